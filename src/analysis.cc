@@ -1,6 +1,7 @@
 #include <algorithm>
 
 #include "analysis.h"
+#include "attacks.h"
 #include "log.h"
 
 namespace apollo {
@@ -75,14 +76,45 @@ Bitboard Analysis::IsolatedPawns(Color color) {
 }
 
 int Analysis::Mobility(Color color) {
-  std::vector<Move> pseudolegal_moves = pos_.PseudolegalMoves();
-  int move_count = 0;
-  for (Move mov : pseudolegal_moves) {
-    if (pos_.IsLegalGivenPseudolegal(mov)) {
-      move_count++;
-    }
+  Bitboard own = pos_.Pieces(color);
+  Bitboard enemy = pos_.Pieces(!color);
+  Bitboard occupancy = own | enemy;
+  Bitboard targets = ~own;
+  int mobility = 0;
+  auto count = [&](Bitboard pieces, auto attacks) {
+    pieces.ForEach([&](Square sq) {
+      mobility += (attacks(sq) & targets).Count();
+    });
+  };
+
+  count(pos_.Knights(color), attacks::KnightAttacks);
+  count(pos_.Bishops(color),
+        [&](Square sq) { return attacks::BishopAttacks(sq, occupancy); });
+  count(pos_.Rooks(color),
+        [&](Square sq) { return attacks::RookAttacks(sq, occupancy); });
+  count(pos_.Queens(color),
+        [&](Square sq) { return attacks::QueenAttacks(sq, occupancy); });
+  count(pos_.Kings(color), attacks::KingAttacks);
+
+  // Pawns move forward onto empty squares and capture diagonally.
+  Bitboard pawns = pos_.Pawns(color);
+  Bitboard empty = ~occupancy;
+  Bitboard pushes, double_pushes;
+  if (color == kWhite) {
+    pushes = Shift<kDirectionNorth>(pawns) & empty;
+    double_pushes = Shift<kDirectionNorth>(pushes & kBBRank3) & empty;
+  } else {
+    pushes = Shift<kDirectionSouth>(pawns) & empty;
+    double_pushes = Shift<kDirectionSouth>(pushes & kBBRank6) & empty;
   }
-  return move_count;
+  mobility += pushes.Count() + double_pushes.Count();
+
+  // Two pawns can capture onto the same square, so count the captures pawn
+  // by pawn.
+  pawns.ForEach([&](Square sq) {
+    mobility += (attacks::PawnAttacks(sq, color) & enemy).Count();
+  });
+  return mobility;
 }
 
 Bitboard Analysis::AdjacentFiles(File file) {
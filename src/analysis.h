@@ -34,8 +34,9 @@ class Analysis {
   Bitboard IsolatedPawns(Color color);
 
   /**
-   * Returns the mobility of the given color, i.e. the number of legal moves
-   * available.
+   * Returns the mobility of the given color, i.e. the number of pseudolegal
+   * moves its pieces have, whether or not it is that color's turn to move.
+   * Castling and en passant captures don't count toward mobility.
    */
   int Mobility(Color color);
 
@@ -56,3 +56,17 @@ TEST(AnalysisTest, IsolatedPawnSmoke) {
   ASSERT_EQ(1, isolated_pawns.Count());
   ASSERT_TRUE(isolated_pawns.Test(Square::D3));
 }
+
+TEST(AnalysisTest, MobilityStartPosition) {
+  Position p;
+  Analysis a(p);
+  ASSERT_EQ(20, a.Mobility(apollo::kWhite));
+  ASSERT_EQ(20, a.Mobility(apollo::kBlack));
+}
+
+TEST(AnalysisTest, MobilityOfSideNotToMove) {
+  Position p("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+  Analysis a(p);
+  ASSERT_EQ(30, a.Mobility(apollo::kWhite));
+  ASSERT_EQ(20, a.Mobility(apollo::kBlack));
+}
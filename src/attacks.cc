@@ -128,7 +128,7 @@ class RayTable {
     }
   }
 
-  Bitboard Attacks(Square sq, Direction dir) const {
+  constexpr Bitboard Attacks(Square sq, Direction dir) const {
     return this->table_[static_cast<size_t>(sq)][static_cast<size_t>(dir)];
   }
 
@@ -183,6 +183,53 @@ constexpr PawnTable kPawnTable = PawnTable();
 constexpr RayTable kRayTable = RayTable();
 constexpr KnightTable kKnightTable = KnightTable();
 
+/**
+ * Tables of the squares connecting every pair of squares that share a rank,
+ * file or diagonal. Both tables are empty for pairs of squares that don't.
+ */
+class LineTable {
+ public:
+  constexpr LineTable(const RayTable& rays) : between_(), line_() {
+    for (int i = A1; i < kSquareLast; i++) {
+      Square a = static_cast<Square>(i);
+      for (int dir = kDirectionNorth; dir < kDirectionLast; dir++) {
+        Direction forward = static_cast<Direction>(dir);
+        Direction backward = static_cast<Direction>((dir + 4) % 8);
+        Bitboard ray = rays.Attacks(a, forward);
+        Bitboard line = ray | rays.Attacks(a, backward);
+        line.Set(a);
+
+        // Walk the ray, the same way that RayTable built it.
+        int cursor = i;
+        for (int step = 0; step < ray.Count(); step++) {
+          cursor += kDirectionVectors[dir];
+          Square b = static_cast<Square>(cursor);
+          // Everything on the ray from a that isn't on the ray from b is
+          // between the two squares, except for b itself.
+          Bitboard between = ray ^ rays.Attacks(b, forward);
+          between.Unset(b);
+          between_[i][cursor] = between;
+          line_[i][cursor] = line;
+        }
+      }
+    }
+  }
+
+  Bitboard Between(Square a, Square b) const {
+    return between_[static_cast<size_t>(a)][static_cast<size_t>(b)];
+  }
+
+  Bitboard Line(Square a, Square b) const {
+    return line_[static_cast<size_t>(a)][static_cast<size_t>(b)];
+  }
+
+ private:
+  std::array<std::array<Bitboard, kSquareLast>, kSquareLast> between_;
+  std::array<std::array<Bitboard, kSquareLast>, kSquareLast> line_;
+};
+
+constexpr LineTable kLineTable = LineTable(kRayTable);
+
 /**
  * Calculates the attacks of a positive ray starting at the given square, going
  * the given direction, and with the given board occupancy. The final square of
@@ -261,6 +308,10 @@ Bitboard KnightAttacks(Square sq) { return kKnightTable.Attacks(sq); }
 
 Bitboard KingAttacks(Square sq) { return kKingTable.Attacks(sq); }
 
+Bitboard Between(Square a, Square b) { return kLineTable.Between(a, b); }
+
+Bitboard Line(Square a, Square b) { return kLineTable.Line(a, b); }
+
 }  // namespace attacks
 
 }  // namespace apollo
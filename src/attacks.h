@@ -12,4 +12,17 @@ Bitboard QueenAttacks(Square sq, Bitboard occupancy);
 Bitboard KnightAttacks(Square sq);
 Bitboard KingAttacks(Square sq);
 
+/**
+ * Returns the squares strictly between two squares that share a rank, file or
+ * diagonal, or the empty set if they share none.
+ */
+Bitboard Between(Square a, Square b);
+
+/**
+ * Returns every square of the rank, file or diagonal shared by two distinct
+ * squares, from one edge of the board to the other, or the empty set if they
+ * share none.
+ */
+Bitboard Line(Square a, Square b);
+
 }  // namespace apollo::attacks
@@ -0,0 +1,39 @@
+#include "gtest/gtest.h"
+
+#include "attacks.h"
+
+using apollo::Bitboard;
+using apollo::Square;
+using apollo::attacks::Between;
+using apollo::attacks::Line;
+
+TEST(AttacksTest, BetweenRank) {
+  Bitboard between = Between(Square::A1, Square::D1);
+  ASSERT_EQ(2, between.Count());
+  ASSERT_TRUE(between.Test(Square::B1));
+  ASSERT_TRUE(between.Test(Square::C1));
+  ASSERT_EQ(between.Bits(), Between(Square::D1, Square::A1).Bits());
+}
+
+TEST(AttacksTest, BetweenDiagonal) {
+  Bitboard between = Between(Square::H8, Square::E5);
+  ASSERT_EQ(2, between.Count());
+  ASSERT_TRUE(between.Test(Square::G7));
+  ASSERT_TRUE(between.Test(Square::F6));
+}
+
+TEST(AttacksTest, BetweenAdjacentAndUnaligned) {
+  ASSERT_TRUE(Between(Square::E4, Square::E5).Empty());
+  ASSERT_TRUE(Between(Square::E4, Square::F6).Empty());
+  ASSERT_TRUE(Between(Square::E4, Square::E4).Empty());
+}
+
+TEST(AttacksTest, Line) {
+  Bitboard line = Line(Square::C3, Square::E5);
+  ASSERT_EQ(8, line.Count());
+  ASSERT_TRUE(line.Test(Square::A1));
+  ASSERT_TRUE(line.Test(Square::C3));
+  ASSERT_TRUE(line.Test(Square::H8));
+  ASSERT_EQ(line.Bits(), Line(Square::H8, Square::A1).Bits());
+  ASSERT_TRUE(Line(Square::A1, Square::B3).Empty());
+}
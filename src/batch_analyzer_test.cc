@@ -0,0 +1,82 @@
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "json.hpp"
+
+#include "bench.h"
+#include "evaluators/shannon_evaluator.h"
+#include "search/batch_analyzer.h"
+#include "search/searcher.h"
+
+using apollo::evaluators::ShannonEvaluator;
+using apollo::search::BatchAnalyzer;
+using apollo::search::Searcher;
+using nlohmann::json;
+
+namespace {
+
+std::vector<json> Analyze(const std::string& input, int threads) {
+  BatchAnalyzer analyzer(threads, 2, [] {
+    return std::make_unique<Searcher>(std::make_unique<ShannonEvaluator>());
+  });
+  std::istringstream in(input);
+  std::ostringstream out;
+  analyzer.Run(in, out);
+
+  std::vector<json> results;
+  std::istringstream lines(out.str());
+  std::string line;
+  while (std::getline(lines, line)) {
+    results.push_back(json::parse(line));
+  }
+  return results;
+}
+
+}  // anonymous namespace
+
+TEST(BatchAnalyzerTest, ResultsInInputOrder) {
+  std::string input;
+  for (std::string_view fen : apollo::BenchPositions()) {
+    input += std::string(fen) + "\n";
+  }
+
+  std::vector<json> results = Analyze(input, 4);
+  const auto& positions = apollo::BenchPositions();
+  ASSERT_EQ(positions.size(), results.size());
+  for (size_t i = 0; i < positions.size(); i++) {
+    ASSERT_EQ(positions[i], results[i]["fen"].get<std::string>());
+    ASSERT_FALSE(results[i].contains("error"));
+  }
+}
+
+TEST(BatchAnalyzerTest, MatchesSingleThreaded) {
+  std::string input;
+  for (std::string_view fen : apollo::BenchPositions()) {
+    input += std::string(fen) + "\n";
+  }
+
+  std::vector<json> single = Analyze(input, 1);
+  std::vector<json> pooled = Analyze(input, 3);
+  ASSERT_EQ(single.size(), pooled.size());
+  for (size_t i = 0; i < single.size(); i++) {
+    ASSERT_EQ(single[i]["best_move"], pooled[i]["best_move"]);
+    ASSERT_EQ(single[i]["nodes"], pooled[i]["nodes"]);
+  }
+}
+
+TEST(BatchAnalyzerTest, EpdsCommentsAndErrors) {
+  std::vector<json> results = Analyze(
+      "# a comment\n"
+      "\n"
+      "7k/8/8/8/8/8/8/R6K w - - bm Ra8#; id \"mate\";\n"
+      "not a position\n"
+      "8/8/8/8/8/8/8/7K w - - 0 1\n",
+      2);
+  ASSERT_EQ(3u, results.size());
+  ASSERT_EQ("7k/8/8/8/8/8/8/R6K w - -", results[0]["fen"].get<std::string>());
+  ASSERT_TRUE(results[0]["best_move"].is_string());
+  ASSERT_TRUE(results[1].contains("error"));
+  ASSERT_TRUE(results[2].contains("error"));
+}
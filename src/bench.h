@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+namespace apollo {
+
+/**
+ * Returns the fixed suite of positions searched by `apollo3 bench`: openings,
+ * middlegames, endgames and the perft test positions. The suite must not
+ * change casually, since the total node count of a bench run doubles as a
+ * signature of the search's behavior.
+ */
+const std::vector<std::string_view>& BenchPositions();
+
+}  // namespace apollo
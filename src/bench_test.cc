@@ -0,0 +1,18 @@
+#include <set>
+#include <string_view>
+#include "gtest/gtest.h"
+
+#include "bench.h"
+#include "position.h"
+
+using apollo::Position;
+
+TEST(BenchTest, PositionsAreDistinctAndLegal) {
+  const auto& positions = apollo::BenchPositions();
+  std::set<std::string_view> seen(positions.begin(), positions.end());
+  ASSERT_EQ(positions.size(), seen.size());
+  for (std::string_view fen : positions) {
+    Position pos(fen);
+    ASSERT_FALSE(pos.IsCheck(!pos.SideToMove())) << fen;
+  }
+}
@@ -136,6 +136,16 @@ class Bitboard {
     return Bitboard(this->bits_ ^ other.bits_);
   }
 
+  constexpr Bitboard operator~() const { return Bitboard(~this->bits_); }
+
+  constexpr Bitboard operator<<(int shift) const {
+    return Bitboard(this->bits_ << shift);
+  }
+
+  constexpr Bitboard operator>>(int shift) const {
+    return Bitboard(this->bits_ >> shift);
+  }
+
  private:
   uint64_t bits_;
 };
@@ -180,4 +190,21 @@ constexpr std::array<Bitboard, kRankLast> kBBRanks = {
     kBBRank5, kBBRank6, kBBRank7, kBBRank8,
 };
 
+/**
+ * Shifts every square in a bitboard one step in the given direction. Squares
+ * that would wrap around to the other side of the board fall off instead.
+ */
+template <Direction D>
+constexpr Bitboard Shift(Bitboard bb) {
+  constexpr int offset = kDirectionVectors[D];
+  if constexpr (D == kDirectionEast || D == kDirectionNorthEast ||
+                D == kDirectionSouthEast) {
+    bb = bb & ~kBBFileH;
+  } else if constexpr (D == kDirectionWest || D == kDirectionNorthWest ||
+                       D == kDirectionSouthWest) {
+    bb = bb & ~kBBFileA;
+  }
+  return offset > 0 ? bb << offset : bb >> -offset;
+}
+
 }  // namespace apollo
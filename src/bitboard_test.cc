@@ -30,3 +30,26 @@ TEST(Bitboard, Iter) {
   ASSERT_TRUE(std::find(squares.cbegin(), squares.cend(), Square::B5) !=
               squares.cend());
 }
+
+TEST(Bitboard, ShiftDoesNotWrap) {
+  using apollo::Shift;
+  Bitboard b;
+  b.Set(Square::A4);
+  b.Set(Square::H5);
+  b.Set(Square::D8);
+
+  Bitboard north = Shift<apollo::kDirectionNorth>(b);
+  ASSERT_EQ(2, north.Count());
+  ASSERT_TRUE(north.Test(Square::A5));
+  ASSERT_TRUE(north.Test(Square::H6));
+
+  Bitboard east = Shift<apollo::kDirectionEast>(b);
+  ASSERT_EQ(2, east.Count());
+  ASSERT_TRUE(east.Test(Square::B4));
+  ASSERT_TRUE(east.Test(Square::E8));
+
+  Bitboard south_west = Shift<apollo::kDirectionSouthWest>(b);
+  ASSERT_EQ(2, south_west.Count());
+  ASSERT_TRUE(south_west.Test(Square::G4));
+  ASSERT_TRUE(south_west.Test(Square::C7));
+}
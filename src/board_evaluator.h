@@ -11,6 +11,17 @@ class BoardEvaluator {
   virtual ~BoardEvaluator() {}
 
   virtual double Evaluate(const Position& pos) const = 0;
+
+  /**
+   * Called before a search of the given position begins. Evaluators that
+   * keep incremental state in the position attach it here.
+   */
+  virtual void BeginSearch(Position& pos) const {}
+
+  /**
+   * Called after a search of the given position ends, undoing BeginSearch.
+   */
+  virtual void EndSearch(Position& pos) const {}
 };
 
 }  // namespace apollo
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "move.h"
+#include "position.h"
+
+namespace apollo::book {
+
+/**
+ * Returns the Polyglot key of a position. Polyglot keys are Zobrist hashes,
+ * but built from Polyglot's own table of random numbers and rules rather
+ * than from zobrist::Hash: in particular, an en passant square only counts
+ * when a pawn of the side to move stands ready to capture on it. The keys
+ * match those of books written by other Polyglot tools.
+ */
+uint64_t PolyglotKey(const Position& pos);
+
+/**
+ * Returns the Polyglot encoding of a move: the destination file and rank in
+ * bits 0-5, the source file and rank in bits 6-11 and the promotion piece in
+ * bits 12-14. Castling is encoded as the king capturing its own rook.
+ */
+uint16_t PolyglotMove(Move mov);
+
+enum BookLoadError {
+  kBookOpenFailed = 1,
+  kBookMapFailed,
+  kBookBadSize,
+};
+
+class BookLoadException : std::exception {
+ public:
+  explicit BookLoadException(BookLoadError err) : err_(err) {}
+
+  const char* what() const noexcept override { return "invalid book"; }
+
+  BookLoadError Error() const { return err_; }
+
+ private:
+  BookLoadError err_;
+};
+
+struct BookMove {
+  Move move;
+  uint16_t weight;
+};
+
+/**
+ * A PolyglotBook is an opening book in the Polyglot .bin format: a sequence
+ * of 16-byte big-endian entries sorted by key,
+ *
+ *   uint64  key
+ *   uint16  move
+ *   uint16  weight
+ *   uint32  learn (unused)
+ *
+ * The book is mapped rather than read, so opening even a very large book is
+ * instant, and positions are found by binary search over the mapping.
+ */
+class PolyglotBook {
+ public:
+  static std::unique_ptr<PolyglotBook> Open(const std::string& path);
+
+  ~PolyglotBook();
+
+  PolyglotBook(const PolyglotBook&) = delete;
+  PolyglotBook& operator=(const PolyglotBook&) = delete;
+
+  /**
+   * Returns the number of entries in the book.
+   */
+  size_t Size() const { return size_ / kEntrySize; }
+
+  /**
+   * Returns the legal moves that the book has for a position, with their
+   * weights, heaviest first.
+   */
+  std::vector<BookMove> Probe(const Position& pos) const;
+
+  /**
+   * Picks one of the book's moves for a position at random, with
+   * probability proportional to its weight, or returns nothing if the book
+   * has no moves with any weight for it. The random number is any uniformly
+   * distributed 64-bit number.
+   */
+  std::optional<Move> Pick(const Position& pos, uint64_t random) const;
+
+  static constexpr size_t kEntrySize = 16;
+
+ private:
+  PolyglotBook(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  const uint8_t* data_;
+  size_t size_;
+};
+
+}  // namespace apollo::book
@@ -0,0 +1,98 @@
+#include <cctype>
+#include <utility>
+
+#include "epd.h"
+
+namespace apollo {
+
+namespace {
+
+/**
+ * Splits an EPD operation into its opcode and operands. Operands are
+ * separated by whitespace, and may be quoted strings containing whitespace.
+ */
+std::vector<std::string> SplitOperation(std::string_view operation) {
+  std::vector<std::string> tokens;
+  size_t i = 0;
+  while (i < operation.size()) {
+    if (std::isspace(static_cast<unsigned char>(operation[i]))) {
+      i++;
+      continue;
+    }
+
+    std::string token;
+    if (operation[i] == '"') {
+      size_t end = operation.find('"', i + 1);
+      if (end == std::string_view::npos) {
+        end = operation.size();
+      }
+      token = operation.substr(i + 1, end - i - 1);
+      i = end + 1;
+    } else {
+      while (i < operation.size() &&
+             !std::isspace(static_cast<unsigned char>(operation[i]))) {
+        token += operation[i++];
+      }
+    }
+    tokens.push_back(std::move(token));
+  }
+  return tokens;
+}
+
+}  // anonymous namespace
+
+std::optional<EpdRecord> ParseEpd(std::string_view line) {
+  EpdRecord record;
+  size_t i = 0;
+  for (int field = 0; field < 4; field++) {
+    while (i < line.size() &&
+           std::isspace(static_cast<unsigned char>(line[i]))) {
+      i++;
+    }
+    size_t start = i;
+    while (i < line.size() &&
+           !std::isspace(static_cast<unsigned char>(line[i]))) {
+      i++;
+    }
+    if (start == i) {
+      return {};
+    }
+    if (field != 0) {
+      record.fen += ' ';
+    }
+    record.fen += line.substr(start, i - start);
+  }
+
+  // Operations are terminated by semicolons, which may also appear inside
+  // quoted strings.
+  std::string_view operations = line.substr(i);
+  size_t start = 0;
+  bool quoted = false;
+  for (size_t j = 0; j <= operations.size(); j++) {
+    if (j < operations.size() && operations[j] == '"') {
+      quoted = !quoted;
+    }
+    if (j < operations.size() && (quoted || operations[j] != ';')) {
+      continue;
+    }
+
+    std::vector<std::string> tokens =
+        SplitOperation(operations.substr(start, j - start));
+    start = j + 1;
+    if (tokens.empty()) {
+      continue;
+    }
+
+    std::vector<std::string> operands(tokens.begin() + 1, tokens.end());
+    if (tokens[0] == "bm") {
+      record.best_moves = std::move(operands);
+    } else if (tokens[0] == "am") {
+      record.avoid_moves = std::move(operands);
+    } else if (tokens[0] == "id" && !operands.empty()) {
+      record.id = operands[0];
+    }
+  }
+  return record;
+}
+
+}  // namespace apollo
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace apollo {
+
+/**
+ * A position from an EPD test suite, with the operations that test suites
+ * use. Moves are kept in SAN, as they are written in the suite.
+ */
+struct EpdRecord {
+  // The four position fields, which Position accepts as a FEN.
+  std::string fen;
+  std::string id;
+
+  // The moves of the bm (best move) and am (avoid move) operations.
+  std::vector<std::string> best_moves;
+  std::vector<std::string> avoid_moves;
+};
+
+/**
+ * Parses one line of EPD. Operations other than bm, am and id are ignored.
+ * Returns nothing if the line doesn't have the four position fields.
+ */
+std::optional<EpdRecord> ParseEpd(std::string_view line);
+
+}  // namespace apollo
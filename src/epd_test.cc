@@ -0,0 +1,35 @@
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "epd.h"
+
+using apollo::EpdRecord;
+using apollo::ParseEpd;
+
+TEST(EpdTest, ParsesOperations) {
+  auto record = ParseEpd(
+      "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - bm Qg6; "
+      "id \"WAC.001\";");
+  ASSERT_TRUE(record.has_value());
+  ASSERT_EQ("2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - -",
+            record->fen);
+  ASSERT_EQ("WAC.001", record->id);
+  ASSERT_EQ(std::vector<std::string>{"Qg6"}, record->best_moves);
+  ASSERT_TRUE(record->avoid_moves.empty());
+}
+
+TEST(EpdTest, MultipleMovesAndQuotedSemicolons) {
+  auto record = ParseEpd(
+      "4k3/8/8/8/8/8/8/4K2R w K - c0 \"a; b\"; am Kf1 O-O;  bm Rh8+ Kd2; "
+      "id \"x y\"");
+  ASSERT_TRUE(record.has_value());
+  ASSERT_EQ("x y", record->id);
+  ASSERT_EQ((std::vector<std::string>{"Rh8+", "Kd2"}), record->best_moves);
+  ASSERT_EQ((std::vector<std::string>{"Kf1", "O-O"}), record->avoid_moves);
+}
+
+TEST(EpdTest, RejectsShortLines) {
+  ASSERT_FALSE(ParseEpd("").has_value());
+  ASSERT_FALSE(ParseEpd("8/8/8/8/8/8/8/8 w -").has_value());
+}
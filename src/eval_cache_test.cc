@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+
+#include "search/eval_cache.h"
+
+using apollo::search::EvalCache;
+
+TEST(EvalCacheTest, StoreAndProbe) {
+  EvalCache cache(1024);
+  double value = 0;
+  ASSERT_FALSE(cache.Probe(0xdeadbeef, value));
+  cache.Store(0xdeadbeef, 1.5);
+  ASSERT_TRUE(cache.Probe(0xdeadbeef, value));
+  ASSERT_EQ(1.5, value);
+  ASSERT_EQ(1u, cache.Hits());
+  ASSERT_EQ(1u, cache.Misses());
+}
+
+TEST(EvalCacheTest, EmptyEntriesMiss) {
+  // A freshly cleared cache must not report hits for any key, including the
+  // ones that an all-zero entry would match.
+  EvalCache cache(16);
+  double value = 0;
+  for (uint64_t key = 0; key < 64; key++) {
+    ASSERT_FALSE(cache.Probe(key, value));
+    ASSERT_FALSE(cache.Probe(~key, value));
+  }
+}
+
+TEST(EvalCacheTest, CollisionReplaces) {
+  EvalCache cache(16);
+  double value = 0;
+  cache.Store(1, 1.0);
+  cache.Store(17, 2.0);
+  ASSERT_FALSE(cache.Probe(1, value));
+  ASSERT_TRUE(cache.Probe(17, value));
+  ASSERT_EQ(2.0, value);
+}
+
+TEST(EvalCacheTest, RoundsDownToPowerOfTwo) {
+  EvalCache cache(1000);
+  ASSERT_EQ(512u, cache.Size());
+}
+
+TEST(EvalCacheTest, DisabledCacheAlwaysMisses) {
+  EvalCache cache(0);
+  double value = 0;
+  cache.Store(42, 1.0);
+  ASSERT_FALSE(cache.Probe(42, value));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <optional>
+
+#include "position.h"
+#include "tablebase/bitbase.h"
+
+namespace apollo::evaluators {
+
+/**
+ * The bonus, in pawns, for the side that wins a king and pawn versus king
+ * endgame. It is added to the evaluation rather than replacing it, so that
+ * the search still prefers advancing the pawn.
+ */
+inline constexpr double kKnownWinBonus = 10;
+
+/**
+ * Adjusts a score, from white's point of view, by what the KPK bitbase knows
+ * about the position: drawn positions score zero and won positions get
+ * kKnownWinBonus. Inline so that evaluators defined in headers can inline it.
+ */
+inline double AdjustForKpk(const Position& pos, double score) {
+  // Cheap enough to check on every evaluation before probing.
+  if ((pos.Pieces(kWhite) | pos.Pieces(kBlack)).Count() != 3) {
+    return score;
+  }
+  std::optional<tablebase::Wdl> wdl = tablebase::Kpk().Probe(pos);
+  if (!wdl) {
+    return score;
+  }
+  if (*wdl == tablebase::kWdlDraw) {
+    return 0;
+  }
+  bool white_wins =
+      (*wdl == tablebase::kWdlWin) == (pos.SideToMove() == kWhite);
+  return white_wins ? score + kKnownWinBonus : score - kKnownWinBonus;
+}
+
+}  // namespace apollo::evaluators
@@ -0,0 +1,18 @@
+#include <utility>
+
+#include "nnue_evaluator.h"
+
+namespace apollo::evaluators {
+
+NnueEvaluator::NnueEvaluator(std::unique_ptr<nnue::Network> network)
+    : network_(std::move(network)) {}
+
+void NnueEvaluator::BeginSearch(Position& pos) const {
+  pos.AttachNetwork(network_.get());
+}
+
+void NnueEvaluator::EndSearch(Position& pos) const {
+  pos.AttachNetwork(nullptr);
+}
+
+}  // namespace apollo::evaluators
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <memory>
+
+#include "board_evaluator.h"
+#include "nnue/network.h"
+#include "position.h"
+
+namespace apollo::evaluators {
+
+/**
+ * The NnueEvaluator evaluates positions with an efficiently updatable neural
+ * network. While a search is running, the network is attached to the position
+ * being searched so that the network's first layer is updated incrementally
+ * as moves are made and unmade, which makes evaluation cheap enough to do at
+ * every leaf.
+ */
+class NnueEvaluator final : public BoardEvaluator {
+ public:
+  explicit NnueEvaluator(std::unique_ptr<nnue::Network> network);
+
+  // Defined here so that the search can inline it.
+  virtual double Evaluate(const Position& pos) const override {
+    // The network scores from the point of view of the side to move, in
+    // centipawns. Evaluators score from white's point of view, in pawns.
+    int score = network_->Evaluate(pos);
+    if (pos.SideToMove() == kBlack) {
+      score = -score;
+    }
+    return score / 100.0;
+  }
+
+  virtual void BeginSearch(Position& pos) const override;
+
+  virtual void EndSearch(Position& pos) const override;
+
+ private:
+  std::unique_ptr<nnue::Network> network_;
+};
+
+}  // namespace apollo::evaluators
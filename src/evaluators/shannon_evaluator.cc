@@ -1,49 +1,77 @@
 #include "shannon_evaluator.h"
 #include "analysis.h"
+#include "evaluators/kpk_adjustment.h"
+#include "evaluators/shannon_weights.h"
 
 namespace apollo::evaluators {
 
-const double kKingWeight = 200;
-const double kQueenWeight = 9;
-const double kRookWeight = 5;
-const double kBishopWeight = 3;
-const double kKnightWeight = 3;
-const double kPawnWeight = 1;
-const double kPawnFormationWeight = 0.5;
-const double kMobilityWeight = 0.1;
+const char* ShannonFeatureName(ShannonFeature feature) {
+  switch (feature) {
+    case kShannonKings:
+      return "kings";
+    case kShannonQueens:
+      return "queens";
+    case kShannonRooks:
+      return "rooks";
+    case kShannonBishops:
+      return "bishops";
+    case kShannonKnights:
+      return "knights";
+    case kShannonPawns:
+      return "pawns";
+    case kShannonIsolatedPawns:
+      return "isolated pawns";
+    case kShannonBackwardPawns:
+      return "backward pawns";
+    case kShannonDoubledPawns:
+      return "doubled pawns";
+    case kShannonMobility:
+      return "mobility";
+    default:
+      return "unknown";
+  }
+}
 
 ShannonEvaluator::ShannonEvaluator() {}
 
 double ShannonEvaluator::Evaluate(const Position& pos) const {
-  Analysis boardAnalysis(pos);
-
-  double kingScore =
-      kKingWeight * (pos.Kings(kWhite).Count() - pos.Kings(kBlack).Count());
-  double queenScore =
-      kQueenWeight * (pos.Queens(kWhite).Count() - pos.Queens(kBlack).Count());
-  double rookScore =
-      kRookWeight * (pos.Rooks(kWhite).Count() - pos.Rooks(kBlack).Count());
-  double bishopScore = kBishopWeight * (pos.Bishops(kWhite).Count() -
-                                        pos.Bishops(kBlack).Count());
-  double knightScore = kKnightWeight * (pos.Knights(kWhite).Count() -
-                                        pos.Knights(kBlack).Count());
-  double pawnScore =
-      kPawnWeight * (pos.Pawns(kWhite).Count() - pos.Pawns(kBlack).Count());
-  double mobilityScore = kMobilityWeight * (boardAnalysis.Mobility(kWhite) -
-                                            boardAnalysis.Mobility(kBlack));
-  double isolatedPawnScore =
-      kPawnFormationWeight * (boardAnalysis.IsolatedPawns(kWhite).Count() -
-                              boardAnalysis.IsolatedPawns(kBlack).Count());
-  double backwardPawnScore =
-      kPawnFormationWeight * (boardAnalysis.BackwardPawns(kWhite).Count() -
-                              boardAnalysis.BackwardPawns(kBlack).Count());
-  double doubledPawnScore =
-      kPawnFormationWeight * (boardAnalysis.DoubledPawns(kWhite).Count() -
-                              boardAnalysis.DoubledPawns(kBlack).Count());
+  ShannonFeatures features = Features(pos);
+  double score = 0;
+  for (int i = 0; i < kShannonFeatureCount; i++) {
+    score += kShannonWeights[i] * features[i];
+  }
+  return AdjustForKpk(pos, score);
+}
 
-  return kingScore + queenScore + rookScore + bishopScore + knightScore +
-         pawnScore + isolatedPawnScore + backwardPawnScore + doubledPawnScore +
-         mobilityScore;
+ShannonFeatures ShannonEvaluator::Features(const Position& pos) {
+  Analysis boardAnalysis(pos);
+  ShannonFeatures features;
+  features[kShannonKings] =
+      pos.Kings(kWhite).Count() - pos.Kings(kBlack).Count();
+  features[kShannonQueens] =
+      pos.Queens(kWhite).Count() - pos.Queens(kBlack).Count();
+  features[kShannonRooks] =
+      pos.Rooks(kWhite).Count() - pos.Rooks(kBlack).Count();
+  features[kShannonBishops] =
+      pos.Bishops(kWhite).Count() - pos.Bishops(kBlack).Count();
+  features[kShannonKnights] =
+      pos.Knights(kWhite).Count() - pos.Knights(kBlack).Count();
+  features[kShannonPawns] =
+      pos.Pawns(kWhite).Count() - pos.Pawns(kBlack).Count();
+  features[kShannonIsolatedPawns] =
+      boardAnalysis.IsolatedPawns(kWhite).Count() -
+      boardAnalysis.IsolatedPawns(kBlack).Count();
+  features[kShannonBackwardPawns] =
+      boardAnalysis.BackwardPawns(kWhite).Count() -
+      boardAnalysis.BackwardPawns(kBlack).Count();
+  features[kShannonDoubledPawns] =
+      boardAnalysis.DoubledPawns(kWhite).Count() -
+      boardAnalysis.DoubledPawns(kBlack).Count();
+  features[kShannonMobility] =
+      boardAnalysis.Mobility(kWhite) - boardAnalysis.Mobility(kBlack);
+  return features;
 }
 
+const ShannonWeights& ShannonEvaluator::Weights() { return kShannonWeights; }
+
 }  // namespace apollo::evaluators
@@ -1,8 +1,39 @@
+#pragma once
+
+#include <array>
+
 #include "board_evaluator.h"
 #include "position.h"
 
 namespace apollo::evaluators {
 
+/**
+ * The terms of the ShannonEvaluator. Each is the difference between white's
+ * and black's count of something, and the evaluation is the weighted sum of
+ * the terms in this order.
+ */
+enum ShannonFeature {
+  kShannonKings,
+  kShannonQueens,
+  kShannonRooks,
+  kShannonBishops,
+  kShannonKnights,
+  kShannonPawns,
+  kShannonIsolatedPawns,
+  kShannonBackwardPawns,
+  kShannonDoubledPawns,
+  kShannonMobility,
+  kShannonFeatureCount,
+};
+
+using ShannonFeatures = std::array<int, kShannonFeatureCount>;
+using ShannonWeights = std::array<double, kShannonFeatureCount>;
+
+/**
+ * Returns the name of a feature, as used in the generated weight header.
+ */
+const char* ShannonFeatureName(ShannonFeature feature);
+
 /**
  * The ShannonEvaluator is a simple board evaluator based on the 1949 paper
  * "Programming a Computer for Playing Chess", where author Claude Shannon
@@ -13,13 +44,28 @@ namespace apollo::evaluators {
  * Shannon provides the formula for a board evaluation function. It is simple,
  * yet powerful.
  *
+ * The evaluation is linear in its features, which makes its weights easy to
+ * tune. The weights live in shannon_weights.h, which `apollo3 tune`
+ * generates. King and pawn versus king positions are scored with the KPK
+ * bitbase on top of the features.
+ *
  * See https://www.pi.infn.it/~carosi/chess/shannon.txt for the full text.
  */
-class ShannonEvaluator : public BoardEvaluator {
+class ShannonEvaluator final : public BoardEvaluator {
  public:
   ShannonEvaluator();
 
   virtual double Evaluate(const Position& pos) const override;
+
+  /**
+   * Returns the features of a position, from white's point of view.
+   */
+  static ShannonFeatures Features(const Position& pos);
+
+  /**
+   * Returns the weights that Evaluate uses.
+   */
+  static const ShannonWeights& Weights();
 };
 
 }  // namespace apollo::evaluators
@@ -0,0 +1,21 @@
+// Generated by `apollo3 tune`.
+#pragma once
+
+#include "evaluators/shannon_evaluator.h"
+
+namespace apollo::evaluators {
+
+constexpr ShannonWeights kShannonWeights = {
+    200,  // kings
+    9,    // queens
+    5,    // rooks
+    3,    // bishops
+    3,    // knights
+    1,    // pawns
+    0.5,  // isolated pawns
+    0.5,  // backward pawns
+    0.5,  // doubled pawns
+    0.1,  // mobility
+};
+
+}  // namespace apollo::evaluators
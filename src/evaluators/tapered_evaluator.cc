@@ -0,0 +1,7 @@
+#include "tapered_evaluator.h"
+
+namespace apollo::evaluators {
+
+TaperedEvaluator::TaperedEvaluator() {}
+
+}  // namespace apollo::evaluators
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+
+#include "board_evaluator.h"
+#include "evaluators/kpk_adjustment.h"
+#include "position.h"
+#include "psqt.h"
+
+namespace apollo::evaluators {
+
+/**
+ * The TaperedEvaluator scores a position using only material and
+ * piece-square tables, blending a midgame and an endgame score according to
+ * how much material is left on the board.
+ *
+ * All of the state it needs is maintained incrementally by Position as moves
+ * are made and unmade, so evaluating a position is constant-time. King and
+ * pawn versus king positions are scored with the KPK bitbase.
+ */
+class TaperedEvaluator final : public BoardEvaluator {
+ public:
+  TaperedEvaluator();
+
+  // Defined here so that the search can inline it.
+  virtual double Evaluate(const Position& pos) const override {
+    // Early promotions can push the phase above its starting value, so clamp
+    // it to keep the blend between the two scores.
+    int phase = std::min(pos.Phase(), psqt::kPhaseMax);
+    int score = pos.MidgameScore() * phase +
+                pos.EndgameScore() * (psqt::kPhaseMax - phase);
+
+    // Scores are kept in centipawns, but evaluators speak in pawns.
+    return AdjustForKpk(pos, score / (psqt::kPhaseMax * 100.0));
+  }
+};
+
+}  // namespace apollo::evaluators
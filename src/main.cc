@@ -20,11 +20,22 @@ const char* kUsage =
 Usage:
   apollo3 perft <position>    # To analyze a position using PERFT
   apollo3 evaluate <position> # Evaluate the best move from a given position
+  apollo3 bench [depth] [threads] [hash]
+                              # Search a fixed suite of positions for speed
+  apollo3 epd <file>          # Run an EPD test suite
+  apollo3 match               # Play two engine configurations in a match
+  apollo3 gensfen <file>      # Generate training data from self-play
+  apollo3 tune <file>         # Tune evaluation weights on training data
   apollo3                     # To play a game of chess
 )USG";
 
 [[noreturn]] void PerftCommand(int argc, const char* argv[]);
 [[noreturn]] void EvaluateCommand(int argc, const char* argv[]);
+[[noreturn]] void BenchCommand(int argc, const char* argv[]);
+[[noreturn]] void EpdCommand(int argc, const char* argv[]);
+[[noreturn]] void MatchCommand(int argc, const char* argv[]);
+[[noreturn]] void GensfenCommand(int argc, const char* argv[]);
+[[noreturn]] void TuneCommand(int argc, const char* argv[]);
 
 int main(int argc, const char* argv[]) {
   apollo::LogEnable(apollo::kLogInfo);
@@ -41,6 +52,21 @@ int main(int argc, const char* argv[]) {
   if (argc >= 2 && strcmp(argv[1], "evaluate") == 0) {
     EvaluateCommand(argc, argv);
   }
+  if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+    BenchCommand(argc, argv);
+  }
+  if (argc >= 2 && strcmp(argv[1], "epd") == 0) {
+    EpdCommand(argc, argv);
+  }
+  if (argc >= 2 && strcmp(argv[1], "match") == 0) {
+    MatchCommand(argc, argv);
+  }
+  if (argc >= 2 && strcmp(argv[1], "gensfen") == 0) {
+    GensfenCommand(argc, argv);
+  }
+  if (argc >= 2 && strcmp(argv[1], "tune") == 0) {
+    TuneCommand(argc, argv);
+  }
 
   std::ofstream log("/var/log/apollo3.log");
   log << "----- beginning new session" << std::endl;
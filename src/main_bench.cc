@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "bench.h"
+#include "evaluators/shannon_evaluator.h"
+#include "position.h"
+#include "search/searcher.h"
+
+using apollo::Position;
+using apollo::evaluators::ShannonEvaluator;
+using apollo::search::EvalCache;
+using apollo::search::Searcher;
+using apollo::search::SearchResult;
+
+namespace {
+
+int depth = 4;
+int threads = 1;
+size_t hash_megabytes = 16;
+
+void ParseOptions(int argc, const char* argv[]) {
+  // Arguments are positional, as in `bench [depth] [threads] [hash]`.
+  int position = 0;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      std::cout << "usage: apollo3 bench [depth] [threads] [hash]"
+                << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+
+    int value = atoi(argv[i]);
+    if (value <= 0) {
+      std::cout << "expected a positive number: " << argv[i] << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    switch (position++) {
+      case 0:
+        depth = value;
+        break;
+      case 1:
+        threads = value;
+        break;
+      case 2:
+        hash_megabytes = static_cast<size_t>(value);
+        break;
+      default:
+        std::cout << "unexpected argument: " << argv[i] << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+  }
+}
+
+}  // anonymous namespace
+
+[[noreturn]] void BenchCommand(int argc, const char* argv[]) {
+  ParseOptions(argc, argv);
+  if (threads != 1) {
+    // The search is single-threaded; the argument is accepted so that bench
+    // can be invoked the same way as other engines.
+    std::cerr << "bench: ignoring threads " << threads
+              << ", the search is single-threaded" << std::endl;
+  }
+
+  // Until there is a transposition table, the hash size is given to the eval
+  // cache. Cached evaluations don't change the tree searched, so the node
+  // count doesn't depend on it.
+  Searcher searcher(std::make_unique<ShannonEvaluator>(),
+                    EvalCache::EntriesInBytes(hash_megabytes << 20));
+  const auto& positions = apollo::BenchPositions();
+  uint64_t nodes = 0;
+  double seconds = 0;
+  for (size_t i = 0; i < positions.size(); i++) {
+    Position pos(positions[i]);
+    SearchResult result = searcher.Search(pos, depth);
+    nodes += result.stats.nodes;
+    seconds += result.stats.seconds;
+    std::cerr << "position " << i + 1 << "/" << positions.size() << ": "
+              << positions[i] << ": " << result.stats.nodes << " nodes"
+              << std::endl;
+  }
+
+  std::cerr << "===========================" << std::endl;
+  std::cout << "Total time (ms) : " << static_cast<uint64_t>(seconds * 1000)
+            << std::endl;
+  std::cout << "Nodes searched  : " << nodes << std::endl;
+  std::cout << "Nodes/second    : "
+            << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0)
+            << std::endl;
+  std::exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,44 @@
+#include <cstdlib>
+#include <iostream>
+
+#include "evaluators/nnue_evaluator.h"
+#include "evaluators/shannon_evaluator.h"
+#include "evaluators/tapered_evaluator.h"
+#include "main_common.h"
+#include "nnue/network.h"
+
+namespace apollo::cli {
+
+const char* NextArgument(int argc, const char* argv[], int& i,
+                         const char* name) {
+  i++;
+  if (i >= argc) {
+    std::cout << "expected argument for " << name << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  return argv[i++];
+}
+
+std::unique_ptr<BoardEvaluator> MakeEvaluator(const std::string& name,
+                                              const std::string& eval_file) {
+  if (name == "shannon") {
+    return std::make_unique<evaluators::ShannonEvaluator>();
+  }
+  if (name == "tapered") {
+    return std::make_unique<evaluators::TaperedEvaluator>();
+  }
+  if (name == "nnue") {
+    try {
+      return std::make_unique<evaluators::NnueEvaluator>(
+          nnue::Network::Load(eval_file));
+    } catch (const nnue::NetworkLoadException& exn) {
+      std::cout << "failed to load network " << eval_file << ": error "
+                << exn.Error() << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+  std::cout << "unknown evaluator: " << name << std::endl;
+  std::exit(EXIT_FAILURE);
+}
+
+}  // namespace apollo::cli
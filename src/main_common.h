@@ -0,0 +1,26 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "board_evaluator.h"
+
+namespace apollo::cli {
+
+/**
+ * Returns the value of the option at argv[i], which is the next argument,
+ * and advances i past both. Exits with a message naming the option if there
+ * is no next argument.
+ */
+const char* NextArgument(int argc, const char* argv[], int& i,
+                         const char* name);
+
+/**
+ * Returns a new evaluator by name: "shannon", "tapered" or "nnue", which
+ * loads its network from eval_file. Exits with a message if the name is
+ * unknown or the network can't be loaded.
+ */
+std::unique_ptr<BoardEvaluator> MakeEvaluator(const std::string& name,
+                                              const std::string& eval_file);
+
+}  // namespace apollo::cli
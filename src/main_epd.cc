@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "epd.h"
+#include "main_common.h"
+#include "position.h"
+#include "search/searcher.h"
+
+using apollo::BoardEvaluator;
+using apollo::EpdRecord;
+using apollo::Move;
+using apollo::Position;
+using apollo::cli::NextArgument;
+using apollo::search::IterationStats;
+using apollo::search::Searcher;
+using apollo::search::SearchLimits;
+using apollo::search::SearchResult;
+
+namespace {
+
+SearchLimits limits;
+size_t eval_cache_entries = apollo::search::kDefaultEvalCacheEntries;
+const char* evaluator = "shannon";
+const char* eval_file = "";
+const char* epd_path = nullptr;
+int threads = 1;
+
+// The upper bounds of the buckets of the time-to-solution histogram.
+const double kHistogramBuckets[] = {0.01, 0.1, 0.25, 0.5, 1, 2.5, 5, 10};
+
+void ParseOptions(int argc, const char* argv[]) {
+  bool limited = false;
+  int i = 2;
+  while (i < argc) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      std::cout << "usage: apollo3 epd <file> [--time seconds] [--nodes n] "
+                   "[--depth n] [--threads n] [--evaluator name] "
+                   "[--eval-file path] [--eval-cache entries]"
+                << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    if (strcmp(argv[i], "--time") == 0) {
+      limits.seconds = atof(NextArgument(argc, argv, i, "time"));
+      limited = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--nodes") == 0) {
+      limits.nodes =
+          strtoull(NextArgument(argc, argv, i, "nodes"), nullptr, 10);
+      limited = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--depth") == 0 || strcmp(argv[i], "-d") == 0) {
+      limits.depth = atoi(NextArgument(argc, argv, i, "depth"));
+      limited = true;
+      continue;
+    }
+    if (strcmp(argv[i], "--threads") == 0) {
+      threads = std::max(atoi(NextArgument(argc, argv, i, "threads")), 1);
+      continue;
+    }
+    if (strcmp(argv[i], "--evaluator") == 0) {
+      evaluator = NextArgument(argc, argv, i, "evaluator");
+      continue;
+    }
+    if (strcmp(argv[i], "--eval-file") == 0) {
+      eval_file = NextArgument(argc, argv, i, "eval file");
+      continue;
+    }
+    if (strcmp(argv[i], "--eval-cache") == 0) {
+      eval_cache_entries =
+          strtoul(NextArgument(argc, argv, i, "eval cache size"), nullptr, 10);
+      continue;
+    }
+    if (!epd_path) {
+      epd_path = argv[i++];
+    } else {
+      std::cout << "unexpected positional argument: " << argv[i] << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+
+  if (!limited) {
+    limits.seconds = 1;
+  }
+}
+
+/**
+ * A position of the suite, with its solutions resolved to moves.
+ */
+struct Problem {
+  EpdRecord record;
+  std::vector<Move> best_moves;
+  std::vector<Move> avoid_moves;
+};
+
+struct Outcome {
+  bool solved = false;
+
+  // The time at which the search settled on its final, solving move, which
+  // is the end of the earliest iteration after which the best move never
+  // stopped being a solution.
+  std::optional<double> solve_seconds;
+  std::string found;
+  uint64_t nodes = 0;
+  double seconds = 0;
+};
+
+bool Solves(const Problem& problem, Move mov) {
+  auto contains = [mov](const std::vector<Move>& moves) {
+    return std::find(moves.begin(), moves.end(), mov) != moves.end();
+  };
+  return (problem.best_moves.empty() || contains(problem.best_moves)) &&
+         !contains(problem.avoid_moves);
+}
+
+Outcome Solve(Searcher& searcher, const Problem& problem) {
+  Position pos(problem.record.fen);
+  Outcome outcome;
+  double elapsed = 0;
+  SearchResult result =
+      searcher.Search(pos, limits, [&](const IterationStats& iteration) {
+        elapsed += iteration.seconds;
+        if (!Solves(problem, iteration.best_move)) {
+          outcome.solve_seconds.reset();
+        } else if (!outcome.solve_seconds) {
+          outcome.solve_seconds = elapsed;
+        }
+      });
+
+  outcome.solved = !result.best_move.IsNull() &&
+                   Solves(problem, result.best_move) && outcome.solve_seconds;
+  outcome.found =
+      result.best_move.IsNull() ? "-" : pos.MoveToSan(result.best_move);
+  outcome.nodes = result.stats.nodes;
+  outcome.seconds = result.stats.seconds;
+  return outcome;
+}
+
+/**
+ * Reads the suite, resolving every solution against its position. Records
+ * that can't be used are reported and skipped.
+ */
+std::vector<Problem> ReadSuite(std::istream& in) {
+  std::vector<Problem> problems;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    line_number++;
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+
+    std::optional<EpdRecord> record = apollo::ParseEpd(line);
+    if (!record) {
+      std::cout << "line " << line_number << ": not an EPD" << std::endl;
+      continue;
+    }
+
+    Problem problem{*record, {}, {}};
+    if (problem.record.id.empty()) {
+      problem.record.id = "line " + std::to_string(line_number);
+    }
+    try {
+      Position pos(problem.record.fen);
+      bool ok = true;
+      auto resolve = [&](const std::vector<std::string>& sans,
+                         std::vector<Move>& moves) {
+        for (const std::string& san : sans) {
+          if (std::optional<Move> mov = pos.MoveFromSan(san)) {
+            moves.push_back(*mov);
+          } else {
+            std::cout << problem.record.id << ": illegal move " << san
+                      << std::endl;
+            ok = false;
+          }
+        }
+      };
+      resolve(problem.record.best_moves, problem.best_moves);
+      resolve(problem.record.avoid_moves, problem.avoid_moves);
+      if (problem.best_moves.empty() && problem.avoid_moves.empty()) {
+        std::cout << problem.record.id << ": no bm or am" << std::endl;
+        ok = false;
+      }
+      if (ok) {
+        problems.push_back(std::move(problem));
+      }
+    } catch (const apollo::InvalidFenException&) {
+      std::cout << problem.record.id << ": invalid position" << std::endl;
+    }
+  }
+  return problems;
+}
+
+std::string Join(const std::vector<std::string>& strings) {
+  std::string joined;
+  for (const std::string& str : strings) {
+    joined += (joined.empty() ? "" : " ") + str;
+  }
+  return joined;
+}
+
+}  // anonymous namespace
+
+[[noreturn]] void EpdCommand(int argc, const char* argv[]) {
+  ParseOptions(argc, argv);
+  if (!epd_path) {
+    std::cout << "no EPD file provided" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  std::ifstream in(epd_path);
+  if (!in) {
+    std::cout << "failed to open " << epd_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::vector<Problem> problems = ReadSuite(in);
+
+  // The evaluators are made before any worker starts, so that a bad
+  // evaluator or network fails here rather than in every worker.
+  std::vector<std::unique_ptr<BoardEvaluator>> evaluators;
+  for (int i = 0; i < threads; i++) {
+    evaluators.push_back(apollo::cli::MakeEvaluator(evaluator, eval_file));
+  }
+
+  // Each worker takes the next unsolved problem until there are none left.
+  std::vector<Outcome> outcomes(problems.size());
+  std::atomic<size_t> next(0);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; i++) {
+    workers.emplace_back([&, i] {
+      Searcher searcher(std::move(evaluators[i]), eval_cache_entries);
+      for (size_t j = next++; j < problems.size(); j = next++) {
+        outcomes[j] = Solve(searcher, problems[j]);
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  std::chrono::duration<double> wall =
+      std::chrono::steady_clock::now() - start;
+
+  size_t solved = 0;
+  uint64_t nodes = 0;
+  constexpr size_t kBuckets = std::size(kHistogramBuckets) + 1;
+  size_t histogram[kBuckets] = {};
+  for (size_t i = 0; i < problems.size(); i++) {
+    const Problem& problem = problems[i];
+    const Outcome& outcome = outcomes[i];
+    nodes += outcome.nodes;
+    std::cout << std::left << std::setw(16) << problem.record.id << std::right;
+    if (outcome.solved) {
+      solved++;
+      size_t bucket = 0;
+      while (bucket < kBuckets - 1 &&
+             *outcome.solve_seconds >= kHistogramBuckets[bucket]) {
+        bucket++;
+      }
+      histogram[bucket]++;
+      std::cout << " solved in " << std::fixed << std::setprecision(3)
+                << *outcome.solve_seconds << "s";
+    } else {
+      std::cout << " failed         ";
+    }
+    if (!problem.record.best_moves.empty()) {
+      std::cout << "  bm " << Join(problem.record.best_moves);
+    }
+    if (!problem.record.avoid_moves.empty()) {
+      std::cout << "  am " << Join(problem.record.avoid_moves);
+    }
+    std::cout << "  found " << outcome.found << std::endl;
+  }
+
+  std::cout << std::endl << "time to solution:" << std::endl;
+  for (size_t bucket = 0; bucket < kBuckets; bucket++) {
+    std::cout << (bucket < kBuckets - 1 ? "  < " : "  >=") << std::setw(6)
+              << std::setprecision(2)
+              << kHistogramBuckets[std::min(bucket, kBuckets - 2)] << "s: "
+              << std::setw(5) << histogram[bucket] << " "
+              << std::string(histogram[bucket] * 60 /
+                                 std::max<size_t>(solved, 1),
+                             '#')
+              << std::endl;
+  }
+
+  std::cout << std::endl
+            << "solved " << solved << "/" << problems.size() << " ("
+            << std::setprecision(1)
+            << (problems.empty() ? 0.0 : 100.0 * solved / problems.size())
+            << "%)" << std::endl;
+  std::cout << "nodes " << nodes << ", " << std::setprecision(2)
+            << wall.count() << "s on " << threads << " threads, "
+            << static_cast<uint64_t>(wall.count() > 0 ? nodes / wall.count()
+                                                      : 0)
+            << " nps" << std::endl;
+  std::exit(EXIT_SUCCESS);
+}
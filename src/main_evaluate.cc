@@ -1,21 +1,35 @@
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <memory>
 
-#include "evaluators/shannon_evaluator.h"
+#include "main_common.h"
 #include "position.h"
+#include "search/batch_analyzer.h"
 #include "search/searcher.h"
 
 using apollo::Position;
-using apollo::evaluators::ShannonEvaluator;
+using apollo::cli::NextArgument;
+using apollo::search::BatchAnalyzer;
+using apollo::search::IterationStats;
 using apollo::search::Searcher;
 using apollo::search::SearchResult;
+using apollo::search::SearchStats;
 
 namespace {
 
 int depth = 2;
+size_t eval_cache_entries = apollo::search::kDefaultEvalCacheEntries;
+const char* evaluator = "shannon";
+const char* eval_file = "";
+bool generic_search = false;
+bool json_output = false;
 const char* position_fen = nullptr;
+const char* batch_path = nullptr;
+int threads = 1;
+int multi_pv = 1;
 
 void ParseOptions(int argc, const char* argv[]) {
   int i = 2;
@@ -25,12 +39,42 @@ void ParseOptions(int argc, const char* argv[]) {
       std::exit(EXIT_FAILURE);
     }
     if (strcmp(argv[i], "--depth") == 0 || strcmp(argv[i], "-d") == 0) {
+      depth = atoi(NextArgument(argc, argv, i, "depth"));
+      continue;
+    }
+    if (strcmp(argv[i], "--eval-cache") == 0) {
+      eval_cache_entries =
+          strtoul(NextArgument(argc, argv, i, "eval cache size"), nullptr, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "--evaluator") == 0) {
+      evaluator = NextArgument(argc, argv, i, "evaluator");
+      continue;
+    }
+    if (strcmp(argv[i], "--eval-file") == 0) {
+      eval_file = NextArgument(argc, argv, i, "eval file");
+      continue;
+    }
+    if (strcmp(argv[i], "--generic-search") == 0) {
+      generic_search = true;
+      i++;
+      continue;
+    }
+    if (strcmp(argv[i], "--batch") == 0) {
+      batch_path = NextArgument(argc, argv, i, "batch");
+      continue;
+    }
+    if (strcmp(argv[i], "--threads") == 0) {
+      threads = atoi(NextArgument(argc, argv, i, "threads"));
+      continue;
+    }
+    if (strcmp(argv[i], "--multipv") == 0) {
+      multi_pv = atoi(NextArgument(argc, argv, i, "multipv"));
+      continue;
+    }
+    if (strcmp(argv[i], "--json") == 0) {
+      json_output = true;
       i++;
-      if (i >= argc) {
-        std::cout << "expected argument for depth" << std::endl;
-        std::exit(EXIT_FAILURE);
-      }
-      depth = atoi(argv[i++]);
       continue;
     }
     if (!position_fen) {
@@ -42,23 +86,88 @@ void ParseOptions(int argc, const char* argv[]) {
   }
 }
 
+std::unique_ptr<Searcher> MakeSearcher() {
+  auto searcher = std::make_unique<Searcher>(
+      apollo::cli::MakeEvaluator(evaluator, eval_file), eval_cache_entries);
+  searcher->UseGenericSearch(generic_search);
+  searcher->SetMultiPv(multi_pv);
+  return searcher;
+}
+
+[[noreturn]] void BatchEvaluate() {
+  BatchAnalyzer analyzer(threads, depth, MakeSearcher);
+  if (strcmp(batch_path, "-") == 0) {
+    analyzer.Run(std::cin, std::cout);
+    std::exit(EXIT_SUCCESS);
+  }
+
+  std::ifstream in(batch_path);
+  if (!in) {
+    std::cout << "failed to open " << batch_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  analyzer.Run(in, std::cout);
+  std::exit(EXIT_SUCCESS);
+}
+
+void PrintStats(const SearchResult& result) {
+  const SearchStats& stats = result.stats;
+  auto line = [](const char* label) -> std::ostream& {
+    return std::cout << std::setw(18) << label << ": ";
+  };
+  line("best move") << result.best_move << std::endl;
+  line("score") << result.score << std::endl;
+  line("nodes") << stats.nodes << std::endl;
+  line("qnodes") << stats.qnodes << std::endl;
+  line("seldepth") << stats.seldepth << std::endl;
+  line("cutoffs") << stats.beta_cutoffs << std::endl;
+  line("first-move cutoffs") << stats.first_move_cutoffs << " ("
+                             << 100 * stats.FirstMoveCutoffRate() << "%)"
+                             << std::endl;
+  line("cache hits") << stats.eval_cache_hits << std::endl;
+  line("cache misses") << stats.eval_cache_misses << std::endl;
+  line("tb hits") << stats.tb_hits << std::endl;
+  line("time") << stats.seconds << "s" << std::endl;
+  line("nps") << stats.Nps() << std::endl;
+
+  std::cout << std::endl;
+  for (const IterationStats& iteration : stats.iterations) {
+    std::cout << "  depth " << std::setw(2) << iteration.depth << " seldepth "
+              << std::setw(2) << iteration.seldepth << "  "
+              << iteration.best_move << "  score " << iteration.score
+              << "  nodes " << iteration.nodes << "  time "
+              << iteration.seconds << "s" << std::endl;
+    if (iteration.lines.size() > 1) {
+      for (size_t i = 0; i < iteration.lines.size(); i++) {
+        std::cout << "    " << std::setw(2) << i + 1 << ". "
+                  << iteration.lines[i].move << "  score "
+                  << iteration.lines[i].score << std::endl;
+      }
+    }
+  }
+}
+
 }  // anonymous namespace
 
 [[noreturn]] void EvaluateCommand(int argc, const char* argv[]) {
   ParseOptions(argc, argv);
+  if (batch_path) {
+    BatchEvaluate();
+  }
   if (!position_fen) {
     std::cout << "no FEN position provided" << std::endl;
     std::exit(EXIT_FAILURE);
   }
 
   Position p(position_fen);
-  p.Dump(std::cout);
-
-  Searcher search(std::make_unique<ShannonEvaluator>());
-  SearchResult result = search.Search(p, depth);
-  std::cout << "  best move: " << result.best_move << std::endl;
-  std::cout << "      score: " << result.score << std::endl;
-  std::cout << "      nodes: " << result.nodes_searched << std::endl;
+  std::unique_ptr<Searcher> search = MakeSearcher();
+  if (json_output) {
+    SearchResult result = search->Search(p, depth);
+    std::cout << result.stats.ToJson() << std::endl;
+    std::exit(EXIT_SUCCESS);
+  }
 
+  p.Dump(std::cout);
+  PrintStats(search->Search(p, depth));
   std::exit(EXIT_SUCCESS);
 }
\ No newline at end of file
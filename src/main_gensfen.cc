@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "main_common.h"
+#include "match/game.h"
+#include "position.h"
+#include "search/searcher.h"
+#include "training/training_data.h"
+
+using apollo::BoardEvaluator;
+using apollo::Color;
+using apollo::Move;
+using apollo::Position;
+using apollo::cli::NextArgument;
+using apollo::match::GameRecord;
+using apollo::match::Player;
+using apollo::search::Searcher;
+using apollo::search::SearchResult;
+using apollo::training::TrainingDataWriter;
+using apollo::training::TrainingRecord;
+
+namespace {
+
+// Scores are stored as int16 centipawns, and mate scores are clamped to this.
+const double kMaxScore = 32000;
+
+uint64_t positions = 1000000;
+int depth = 5;
+int random_plies = 8;
+uint64_t seed = 0;
+size_t eval_cache_entries = apollo::search::kDefaultEvalCacheEntries;
+const char* evaluator = "shannon";
+const char* eval_file = "";
+const char* output_path = nullptr;
+int threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+
+std::atomic<uint64_t> positions_written(0);
+std::atomic<uint64_t> games_played(0);
+
+// The error of the first worker whose training data couldn't be written, or
+// zero. Every worker stops once it is set.
+std::atomic<int> write_error(0);
+
+void ParseOptions(int argc, const char* argv[]) {
+  int i = 2;
+  while (i < argc) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      std::cout << "usage: apollo3 gensfen <file> [--positions n] [--depth n] "
+                   "[--threads n] [--random-plies n] [--seed n] "
+                   "[--evaluator name] [--eval-file path] "
+                   "[--eval-cache entries]"
+                << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    if (strcmp(argv[i], "--positions") == 0) {
+      positions =
+          strtoull(NextArgument(argc, argv, i, "positions"), nullptr, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "--depth") == 0 || strcmp(argv[i], "-d") == 0) {
+      depth = std::max(atoi(NextArgument(argc, argv, i, "depth")), 1);
+      continue;
+    }
+    if (strcmp(argv[i], "--threads") == 0) {
+      threads = std::max(atoi(NextArgument(argc, argv, i, "threads")), 1);
+      continue;
+    }
+    if (strcmp(argv[i], "--random-plies") == 0) {
+      random_plies =
+          std::max(atoi(NextArgument(argc, argv, i, "random plies")), 0);
+      continue;
+    }
+    if (strcmp(argv[i], "--seed") == 0) {
+      seed = strtoull(NextArgument(argc, argv, i, "seed"), nullptr, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "--evaluator") == 0) {
+      evaluator = NextArgument(argc, argv, i, "evaluator");
+      continue;
+    }
+    if (strcmp(argv[i], "--eval-file") == 0) {
+      eval_file = NextArgument(argc, argv, i, "eval file");
+      continue;
+    }
+    if (strcmp(argv[i], "--eval-cache") == 0) {
+      eval_cache_entries =
+          strtoul(NextArgument(argc, argv, i, "eval cache size"), nullptr, 10);
+      continue;
+    }
+    if (!output_path) {
+      output_path = argv[i++];
+    } else {
+      std::cout << "unexpected positional argument: " << argv[i] << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+}
+
+/**
+ * Returns a position a few random moves away from the starting position, so
+ * that games don't all follow the same line.
+ */
+Position RandomOpening(std::mt19937_64& rng) {
+  while (true) {
+    Position pos;
+    int ply = 0;
+    for (; ply < random_plies; ply++) {
+      std::vector<Move> moves = pos.LegalMoves();
+      if (moves.empty()) {
+        break;
+      }
+      std::uniform_int_distribution<size_t> pick(0, moves.size() - 1);
+      pos.MakeMove(moves[pick(rng)]);
+    }
+    if (ply == random_plies && !pos.LegalMoves().empty()) {
+      return pos;
+    }
+  }
+}
+
+/**
+ * Plays self-play games and writes their positions until enough positions
+ * have been written between all of the workers.
+ */
+void Work(int index, std::unique_ptr<BoardEvaluator> evaluator) {
+  Searcher searcher(std::move(evaluator), eval_cache_entries);
+  TrainingDataWriter writer(output_path);
+  std::mt19937_64 rng(seed + index);
+  Player player{&searcher, {}};
+  player.time_control.limits.depth = depth;
+
+  std::vector<TrainingRecord> records;
+  std::vector<Color> sides;
+  while (write_error.load(std::memory_order_relaxed) == 0 &&
+         positions_written.load(std::memory_order_relaxed) < positions) {
+    records.clear();
+    sides.clear();
+    Position start = RandomOpening(rng);
+
+    // Positions in check and positions whose best move is tactical are left
+    // out, since a static evaluation can't be expected to score them.
+    GameRecord game = apollo::match::PlayGame(
+        start, player, player, rng(),
+        [&](const Position& pos, const SearchResult& result) {
+          Move best = result.best_move;
+          if (pos.IsCheck(pos.SideToMove()) || best.IsCapture() ||
+              best.IsPromotion()) {
+            return;
+          }
+          double score =
+              std::clamp(std::round(result.score * 100), -kMaxScore, kMaxScore);
+          records.push_back({pos.Pack(), static_cast<int16_t>(score), 0, 0});
+          sides.push_back(pos.SideToMove());
+        });
+
+    for (size_t i = 0; i < records.size(); i++) {
+      if (game.result != apollo::match::kDraw) {
+        Color winner =
+            game.result == apollo::match::kWhiteWins ? apollo::kWhite
+                                                     : apollo::kBlack;
+        records[i].result = sides[i] == winner ? 1 : -1;
+      }
+      writer.Write(records[i]);
+    }
+    positions_written += records.size();
+    games_played++;
+  }
+
+  // Flush here rather than in the destructor, which can't report a failure.
+  writer.Flush();
+}
+
+}  // anonymous namespace
+
+[[noreturn]] void GensfenCommand(int argc, const char* argv[]) {
+  ParseOptions(argc, argv);
+  if (!output_path) {
+    std::cout << "no output file provided" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  // Open the file once up front, so that a bad path fails before any work is
+  // done rather than in every worker.
+  try {
+    TrainingDataWriter writer(output_path);
+  } catch (const apollo::training::TrainingDataException&) {
+    std::cout << "failed to open " << output_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  // Likewise, make the evaluators before any worker starts.
+  std::vector<std::unique_ptr<BoardEvaluator>> evaluators;
+  for (int i = 0; i < threads; i++) {
+    evaluators.push_back(apollo::cli::MakeEvaluator(evaluator, eval_file));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<int> running(threads);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < threads; i++) {
+    workers.emplace_back([&, i] {
+      try {
+        Work(i, std::move(evaluators[i]));
+      } catch (const apollo::training::TrainingDataException& exn) {
+        int expected = 0;
+        write_error.compare_exchange_strong(expected, exn.Error());
+      }
+      running--;
+    });
+  }
+
+  // Report progress every ten seconds until the workers are done.
+  auto report = [&] {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    uint64_t written = positions_written.load();
+    std::cout << written << " positions from " << games_played.load()
+              << " games in " << std::fixed << std::setprecision(1)
+              << elapsed.count() << "s ("
+              << static_cast<uint64_t>(
+                     elapsed.count() > 0 ? written / elapsed.count() : 0)
+              << " positions/s)" << std::endl;
+  };
+  auto next_report = start + std::chrono::seconds(10);
+  while (running.load() > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (std::chrono::steady_clock::now() >= next_report) {
+      report();
+      next_report += std::chrono::seconds(10);
+    }
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  report();
+  if (write_error.load() != 0) {
+    std::cout << "failed to write " << output_path << ": error "
+              << write_error.load() << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::exit(EXIT_SUCCESS);
+}
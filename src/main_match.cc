@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "epd.h"
+#include "main_common.h"
+#include "match/game.h"
+#include "match/sprt.h"
+#include "position.h"
+#include "search/searcher.h"
+
+using apollo::Position;
+using apollo::match::GameRecord;
+using apollo::match::MatchScore;
+using apollo::match::Player;
+using apollo::match::Sprt;
+using apollo::match::TimeControl;
+using apollo::search::Searcher;
+
+namespace {
+
+/**
+ * The openings played when no opening file is given, as moves from the
+ * starting position. Every opening is played twice, once with each engine
+ * as white.
+ */
+const char* const kDefaultOpenings[] = {
+    "e4 e5 Nf3 Nc6 Bb5 a6",      "e4 e5 Nf3 Nc6 Bc4 Bc5",
+    "e4 e5 Nf3 Nf6 Nxe5 d6",     "e4 e5 Nc3 Nf6 f4 d5",
+    "e4 c5 Nf3 d6 d4 cxd4",      "e4 c5 Nf3 Nc6 d4 cxd4",
+    "e4 c5 Nc3 Nc6 g3 g6",       "e4 e6 d4 d5 Nc3 Bb4",
+    "e4 e6 d4 d5 e5 c5",         "e4 c6 d4 d5 e5 Bf5",
+    "e4 c6 d4 d5 Nc3 dxe4",      "e4 d5 exd5 Qxd5 Nc3 Qa5",
+    "e4 d6 d4 Nf6 Nc3 g6",       "e4 Nf6 e5 Nd5 d4 d6",
+    "d4 d5 c4 e6 Nc3 Nf6",       "d4 d5 c4 c6 Nf3 Nf6",
+    "d4 d5 c4 dxc4 Nf3 Nf6",     "d4 Nf6 c4 e6 Nc3 Bb4",
+    "d4 Nf6 c4 g6 Nc3 Bg7",      "d4 Nf6 c4 e6 Nf3 b6",
+    "d4 Nf6 c4 c5 d5 b5",        "d4 f5 g3 Nf6 Bg2 g6",
+    "c4 e5 Nc3 Nf6 Nf3 Nc6",     "c4 c5 Nc3 Nc6 g3 g6",
+    "Nf3 d5 g3 Nf6 Bg2 c6",      "Nf3 Nf6 c4 b6 g3 Bb7",
+    "g3 d5 Bg2 Nf6 Nf3 c5",      "b3 e5 Bb2 Nc6 e3 d5",
+    "f4 d5 Nf3 g6 e3 Bg7",       "e4 e5 f4 exf4 Nf3 g5",
+    "d4 d5 Bf4 Nf6 e3 c5",       "e4 g6 d4 Bg7 Nc3 d6",
+};
+
+struct EngineConfig {
+  std::string name;
+  std::string evaluator = "shannon";
+  std::string eval_file;
+  size_t eval_cache_entries = apollo::search::kDefaultEvalCacheEntries;
+  bool generic_search = false;
+  TimeControl time_control;
+};
+
+EngineConfig engines[2];
+int games = 1000;
+int concurrency = std::max<int>(std::thread::hardware_concurrency(), 1);
+const char* openings_path = nullptr;
+double sprt_elo0 = 0;
+double sprt_elo1 = 5;
+double sprt_alpha = 0.05;
+double sprt_beta = 0.05;
+
+[[noreturn]] void Usage() {
+  std::cout
+      << "usage: apollo3 match [--engine1 spec] [--engine2 spec] [--games n]\n"
+         "                     [--concurrency n] [--openings file]\n"
+         "                     [--sprt elo0,elo1[,alpha,beta]] [controls]\n"
+         "\n"
+         "An engine spec is a comma-separated list of key=value pairs:\n"
+         "  name, evaluator (shannon, tapered or nnue), eval-file,\n"
+         "  eval-cache, generic, and any of the controls below.\n"
+         "Controls given as --key value apply to both engines:\n"
+         "  nodes=n      search n nodes per move, jittered by 10%\n"
+         "  depth=n      search to depth n every move\n"
+         "  time=s       search s seconds per move\n"
+         "  tc=base+inc  play on a clock of base seconds, plus inc per move\n"
+         "  jitter=f     jitter node limits by a fraction f either way\n";
+  std::exit(EXIT_FAILURE);
+}
+
+/**
+ * Applies a key=value setting to an engine, returning false if the key isn't
+ * known.
+ */
+bool ApplySetting(EngineConfig& engine, const std::string& key,
+                  const std::string& value) {
+  TimeControl& time_control = engine.time_control;
+  if (key == "name") {
+    engine.name = value;
+  } else if (key == "evaluator") {
+    engine.evaluator = value;
+  } else if (key == "eval-file") {
+    engine.eval_file = value;
+  } else if (key == "eval-cache") {
+    engine.eval_cache_entries = strtoul(value.c_str(), nullptr, 10);
+  } else if (key == "generic") {
+    engine.generic_search = value != "false" && value != "0";
+  } else if (key == "nodes") {
+    time_control.limits.nodes = strtoull(value.c_str(), nullptr, 10);
+    if (time_control.node_jitter == 0) {
+      time_control.node_jitter = 0.1;
+    }
+  } else if (key == "depth") {
+    time_control.limits.depth = atoi(value.c_str());
+  } else if (key == "time") {
+    time_control.limits.seconds = atof(value.c_str());
+  } else if (key == "jitter") {
+    time_control.node_jitter = atof(value.c_str());
+  } else if (key == "tc") {
+    size_t plus = value.find('+');
+    time_control.base_seconds = atof(value.substr(0, plus).c_str());
+    time_control.increment_seconds =
+        plus == std::string::npos ? 0 : atof(value.substr(plus + 1).c_str());
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void ApplySpec(EngineConfig& engine, const std::string& spec) {
+  std::istringstream stream(spec);
+  std::string setting;
+  while (std::getline(stream, setting, ',')) {
+    size_t equals = setting.find('=');
+    std::string key = setting.substr(0, equals);
+    std::string value =
+        equals == std::string::npos ? "true" : setting.substr(equals + 1);
+    if (!ApplySetting(engine, key, value)) {
+      std::cout << "unknown engine setting: " << key << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+}
+
+void ParseOptions(int argc, const char* argv[]) {
+  engines[0].name = "engine1";
+  engines[1].name = "engine2";
+
+  // Controls given outside an engine spec apply to both engines, but an
+  // engine's own spec takes precedence, so specs are applied last.
+  std::string specs[2];
+  int i = 2;
+  while (i < argc) {
+    std::string arg = argv[i++];
+    if (arg == "-h" || arg == "--help") {
+      Usage();
+    }
+    if (i >= argc) {
+      std::cout << "expected argument for " << arg << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+
+    const char* value = argv[i++];
+    if (arg == "--engine1") {
+      specs[0] = value;
+    } else if (arg == "--engine2") {
+      specs[1] = value;
+    } else if (arg == "--games") {
+      games = atoi(value);
+    } else if (arg == "--concurrency") {
+      concurrency = std::max(atoi(value), 1);
+    } else if (arg == "--openings") {
+      openings_path = value;
+    } else if (arg == "--sprt") {
+      char* end = nullptr;
+      double* params[] = {&sprt_elo0, &sprt_elo1, &sprt_alpha, &sprt_beta};
+      for (double* param : params) {
+        *param = strtod(value, &end);
+        if (*end != ',') {
+          break;
+        }
+        value = end + 1;
+      }
+    } else if (arg.rfind("--", 0) == 0 &&
+               ApplySetting(engines[0], arg.substr(2), value)) {
+      ApplySetting(engines[1], arg.substr(2), value);
+    } else {
+      std::cout << "unknown option: " << arg << std::endl;
+      Usage();
+    }
+  }
+
+  for (int engine = 0; engine < 2; engine++) {
+    ApplySpec(engines[engine], specs[engine]);
+    const TimeControl& time_control = engines[engine].time_control;
+    const auto& limits = time_control.limits;
+    if (!time_control.UsesClock() && limits.nodes == 0 &&
+        limits.seconds == 0 && limits.depth == apollo::search::kMaxDepth) {
+      // Without any control, play quick games at a fixed node count.
+      ApplySetting(engines[engine], "nodes", "20000");
+    }
+  }
+}
+
+std::unique_ptr<Searcher> MakeSearcher(const EngineConfig& engine) {
+  auto searcher = std::make_unique<Searcher>(
+      apollo::cli::MakeEvaluator(engine.evaluator, engine.eval_file),
+      engine.eval_cache_entries);
+  searcher->UseGenericSearch(engine.generic_search);
+  return searcher;
+}
+
+std::vector<Position> ReadOpenings() {
+  std::vector<Position> openings;
+  if (!openings_path) {
+    for (const char* line : kDefaultOpenings) {
+      Position pos;
+      std::istringstream moves(line);
+      std::string san;
+      while (moves >> san) {
+        pos.MakeMove(*pos.MoveFromSan(san));
+      }
+      openings.push_back(pos);
+    }
+    return openings;
+  }
+
+  std::ifstream in(openings_path);
+  if (!in) {
+    std::cout << "failed to open " << openings_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::string line;
+  while (std::getline(in, line)) {
+    if (auto record = apollo::ParseEpd(line)) {
+      try {
+        openings.emplace_back(record->fen);
+      } catch (const apollo::InvalidFenException&) {
+        std::cout << "skipping invalid opening: " << line << std::endl;
+      }
+    }
+  }
+  if (openings.empty()) {
+    std::cout << "no openings in " << openings_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  return openings;
+}
+
+void PrintStatus(const MatchScore& score, const Sprt& sprt) {
+  std::cout << "Score of " << engines[0].name << " vs " << engines[1].name
+            << ": " << score.wins << " - " << score.losses << " - "
+            << score.draws << "  [" << std::fixed << std::setprecision(3)
+            << score.Score() << "] " << score.Games() << "  LLR "
+            << std::setprecision(2) << sprt.LogLikelihoodRatio(score) << " ("
+            << sprt.LowerBound() << ", " << sprt.UpperBound() << ")"
+            << std::endl;
+}
+
+}  // anonymous namespace
+
+[[noreturn]] void MatchCommand(int argc, const char* argv[]) {
+  ParseOptions(argc, argv);
+  std::vector<Position> openings = ReadOpenings();
+  Sprt sprt(sprt_elo0, sprt_elo1, sprt_alpha, sprt_beta);
+  std::cout << "playing " << games << " games on " << concurrency
+            << " threads from " << openings.size() << " openings, SPRT elo0 "
+            << sprt_elo0 << " elo1 " << sprt_elo1 << " alpha " << sprt_alpha
+            << " beta " << sprt_beta << std::endl;
+
+  std::mutex lock;
+  MatchScore score;
+  apollo::match::SprtDecision decision = apollo::match::kSprtContinue;
+  std::atomic<int> next_game(0);
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < concurrency; i++) {
+    workers.emplace_back([&] {
+      std::unique_ptr<Searcher> searchers[2] = {MakeSearcher(engines[0]),
+                                                MakeSearcher(engines[1])};
+      for (int game = next_game++; game < games && !stop; game = next_game++) {
+        // Games come in pairs from the same opening, with colors reversed.
+        int first = game % 2;
+        Player white{searchers[first].get(), engines[first].time_control};
+        Player black{searchers[!first].get(), engines[!first].time_control};
+        const Position& opening = openings[(game / 2) % openings.size()];
+        GameRecord record =
+            apollo::match::PlayGame(opening, white, black, game / 2);
+
+        std::lock_guard guard(lock);
+        if (record.result == apollo::match::kDraw) {
+          score.draws++;
+        } else if ((record.result == apollo::match::kWhiteWins) ==
+                   (first == 0)) {
+          score.wins++;
+        } else {
+          score.losses++;
+        }
+        PrintStatus(score, sprt);
+        decision = sprt.Decide(score);
+        if (decision != apollo::match::kSprtContinue) {
+          stop = true;
+        }
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  std::cout << std::endl;
+  PrintStatus(score, sprt);
+  std::cout << "Elo difference: " << std::setprecision(1) << score.Elo()
+            << " +/- " << score.EloMargin() << std::endl;
+  switch (decision) {
+    case apollo::match::kSprtAcceptH0:
+      std::cout << "SPRT: H0 accepted" << std::endl;
+      break;
+    case apollo::match::kSprtAcceptH1:
+      std::cout << "SPRT: H1 accepted" << std::endl;
+      break;
+    default:
+      std::cout << "SPRT: no decision" << std::endl;
+      break;
+  }
+  std::exit(EXIT_SUCCESS);
+}
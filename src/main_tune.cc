@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "evaluators/shannon_evaluator.h"
+#include "main_common.h"
+#include "position.h"
+#include "training/texel_tuner.h"
+#include "training/training_data.h"
+
+using apollo::Position;
+using apollo::cli::NextArgument;
+using apollo::evaluators::kShannonFeatureCount;
+using apollo::evaluators::ShannonEvaluator;
+using apollo::evaluators::ShannonFeature;
+using apollo::evaluators::ShannonWeights;
+using apollo::training::TexelTuner;
+using apollo::training::TrainingDataReader;
+using apollo::training::TrainingRecord;
+
+namespace {
+
+int epochs = 200;
+double learning_rate = 0.01;
+uint64_t max_positions = 0;
+const char* data_path = nullptr;
+const char* output_path = "shannon_weights.h";
+int threads = std::max<int>(std::thread::hardware_concurrency(), 1);
+
+void ParseOptions(int argc, const char* argv[]) {
+  int i = 2;
+  while (i < argc) {
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+      std::cout << "usage: apollo3 tune <file> [--epochs n] [--rate r] "
+                   "[--positions n] [--threads n] [--output header]"
+                << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+    if (strcmp(argv[i], "--epochs") == 0) {
+      epochs = std::max(atoi(NextArgument(argc, argv, i, "epochs")), 0);
+      continue;
+    }
+    if (strcmp(argv[i], "--rate") == 0) {
+      learning_rate = atof(NextArgument(argc, argv, i, "learning rate"));
+      continue;
+    }
+    if (strcmp(argv[i], "--positions") == 0) {
+      max_positions =
+          strtoull(NextArgument(argc, argv, i, "positions"), nullptr, 10);
+      continue;
+    }
+    if (strcmp(argv[i], "--threads") == 0) {
+      threads = std::max(atoi(NextArgument(argc, argv, i, "threads")), 1);
+      continue;
+    }
+    if (strcmp(argv[i], "--output") == 0 || strcmp(argv[i], "-o") == 0) {
+      output_path = NextArgument(argc, argv, i, "output");
+      continue;
+    }
+    if (!data_path) {
+      data_path = argv[i++];
+    } else {
+      std::cout << "unexpected positional argument: " << argv[i] << std::endl;
+      std::exit(EXIT_FAILURE);
+    }
+  }
+}
+
+void PrintWeights(const ShannonWeights& weights) {
+  for (int i = 0; i < kShannonFeatureCount; i++) {
+    std::cout << "  " << std::left << std::setw(16)
+              << ShannonFeatureName(static_cast<ShannonFeature>(i))
+              << std::right << weights[i] << std::endl;
+  }
+}
+
+/**
+ * Writes the weights as a replacement for evaluators/shannon_weights.h.
+ */
+void WriteHeader(std::ostream& out, const ShannonWeights& weights) {
+  std::vector<std::string> values;
+  size_t width = 0;
+  for (double weight : weights) {
+    std::ostringstream value;
+    value << std::setprecision(4) << weight << ",";
+    values.push_back(value.str());
+    width = std::max(width, values.back().size());
+  }
+
+  out << "// Generated by `apollo3 tune`.\n"
+         "#pragma once\n"
+         "\n"
+         "#include \"evaluators/shannon_evaluator.h\"\n"
+         "\n"
+         "namespace apollo::evaluators {\n"
+         "\n"
+         "constexpr ShannonWeights kShannonWeights = {\n";
+  for (int i = 0; i < kShannonFeatureCount; i++) {
+    out << "    " << std::left << std::setw(width) << values[i]
+        << "  // " << ShannonFeatureName(static_cast<ShannonFeature>(i))
+        << "\n";
+  }
+  out << "};\n"
+         "\n"
+         "}  // namespace apollo::evaluators\n";
+}
+
+}  // anonymous namespace
+
+[[noreturn]] void TuneCommand(int argc, const char* argv[]) {
+  ParseOptions(argc, argv);
+  if (!data_path) {
+    std::cout << "no training data provided" << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  TexelTuner tuner(threads, learning_rate);
+  try {
+    TrainingDataReader reader(data_path);
+    TrainingRecord record;
+    while ((max_positions == 0 || tuner.Size() < max_positions) &&
+           reader.Next(record)) {
+      // Records are from the side to move's point of view, and the tuner
+      // wants white's.
+      Position pos = Position::Unpack(record.position);
+      double result = (record.result + 1) / 2.0;
+      tuner.Add(pos, pos.SideToMove() == apollo::kWhite ? result : 1 - result);
+    }
+  } catch (const apollo::training::TrainingDataException&) {
+    std::cout << "failed to open " << data_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  std::chrono::duration<double> load = Clock::now() - start;
+  std::cout << "loaded " << tuner.Size() << " positions in " << std::fixed
+            << std::setprecision(2) << load.count() << "s" << std::endl;
+  if (tuner.Size() == 0) {
+    std::exit(EXIT_FAILURE);
+  }
+
+  ShannonWeights weights = ShannonEvaluator::Weights();
+  double scale = tuner.FitScale(weights);
+  std::cout << "scale " << std::setprecision(4) << scale << ", initial error "
+            << std::setprecision(6) << tuner.Error(weights) << std::endl;
+
+  for (int epoch = 1; epoch <= epochs; epoch++) {
+    Clock::time_point epoch_start = Clock::now();
+    tuner.Step(weights);
+    std::chrono::duration<double> elapsed = Clock::now() - epoch_start;
+    if (epoch % 10 == 0 || epoch == epochs) {
+      std::cout << "epoch " << std::setw(5) << epoch << "  error "
+                << std::setprecision(6) << tuner.Error(weights) << "  "
+                << std::setprecision(3) << elapsed.count() << "s" << std::endl;
+    }
+  }
+
+  std::cout << std::defaultfloat << "weights:" << std::endl;
+  PrintWeights(weights);
+
+  std::ofstream out(output_path);
+  if (!out) {
+    std::cout << "failed to open " << output_path << std::endl;
+    std::exit(EXIT_FAILURE);
+  }
+  WriteHeader(out, weights);
+  out.close();
+  std::cout << "wrote " << output_path << std::endl;
+  std::exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include "match/game.h"
+
+namespace apollo::match {
+
+namespace {
+
+// With a clock, each move gets this fraction of the remaining time, plus
+// most of the increment.
+const double kClockFraction = 1.0 / 30;
+const double kIncrementFraction = 0.8;
+
+}  // anonymous namespace
+
+bool IsInsufficientMaterial(const Position& pos) {
+  for (Color color : kColors) {
+    if (!pos.Pawns(color).Empty() || !pos.Rooks(color).Empty() ||
+        !pos.Queens(color).Empty()) {
+      return false;
+    }
+  }
+
+  int minors = 0;
+  for (Color color : kColors) {
+    minors += pos.Knights(color).Count() + pos.Bishops(color).Count();
+  }
+  return minors <= 1;
+}
+
+GameRecord PlayGame(const Position& start, const Player& white,
+                    const Player& black, uint64_t seed,
+                    const MoveCallback& on_move) {
+  using Clock = std::chrono::steady_clock;
+  std::mt19937_64 rng(seed);
+  Position pos = start;
+  double clocks[2] = {white.time_control.base_seconds,
+                      black.time_control.base_seconds};
+
+  // The hashes of every position since the game started, for detecting
+  // repetitions.
+  std::vector<uint64_t> history = {pos.ZobristHash()};
+  GameRecord record{kDraw, kMaxLength, {}};
+  for (int ply = 0; ply < kMaxGamePlies; ply++) {
+    Color us = pos.SideToMove();
+    GameResult loss = us == kWhite ? kBlackWins : kWhiteWins;
+    if (pos.LegalMoves().empty()) {
+      if (pos.IsCheck(us)) {
+        record.result = loss;
+        record.end = kCheckmate;
+      } else {
+        record.end = kStalemate;
+      }
+      return record;
+    }
+    if (pos.HalfmoveClock() >= 100) {
+      record.end = kFiftyMoveRule;
+      return record;
+    }
+    if (std::count(history.begin(), history.end(), pos.ZobristHash()) >= 3) {
+      record.end = kThreefoldRepetition;
+      return record;
+    }
+    if (IsInsufficientMaterial(pos)) {
+      record.end = kInsufficientMaterial;
+      return record;
+    }
+
+    const Player& player = us == kWhite ? white : black;
+    const TimeControl& time_control = player.time_control;
+    search::SearchLimits limits = time_control.limits;
+    if (limits.nodes != 0 && time_control.node_jitter > 0) {
+      std::uniform_real_distribution<double> jitter(
+          1 - time_control.node_jitter, 1 + time_control.node_jitter);
+      limits.nodes = std::max<uint64_t>(1, limits.nodes * jitter(rng));
+    }
+    if (time_control.UsesClock()) {
+      limits.seconds = clocks[us] * kClockFraction +
+                       time_control.increment_seconds * kIncrementFraction;
+    }
+
+    Clock::time_point move_start = Clock::now();
+    search::SearchResult result = player.searcher->Search(pos, limits);
+    std::chrono::duration<double> elapsed = Clock::now() - move_start;
+    if (time_control.UsesClock()) {
+      clocks[us] -= elapsed.count();
+      if (clocks[us] < 0) {
+        record.result = loss;
+        record.end = kTimeForfeit;
+        return record;
+      }
+      clocks[us] += time_control.increment_seconds;
+    }
+
+    if (on_move) {
+      on_move(pos, result);
+    }
+    pos.MakeMove(result.best_move);
+    record.moves.push_back(result.best_move);
+    history.push_back(pos.ZobristHash());
+  }
+  return record;
+}
+
+}  // namespace apollo::match
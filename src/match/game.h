@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "move.h"
+#include "position.h"
+#include "search/searcher.h"
+
+namespace apollo::match {
+
+/**
+ * Games that run this long without ending are adjudicated as draws.
+ */
+constexpr int kMaxGamePlies = 400;
+
+enum GameResult {
+  kWhiteWins,
+  kBlackWins,
+  kDraw,
+};
+
+enum GameEnd {
+  kCheckmate,
+  kStalemate,
+  kFiftyMoveRule,
+  kThreefoldRepetition,
+  kInsufficientMaterial,
+  kTimeForfeit,
+  kMaxLength,
+};
+
+/**
+ * How a player is allowed to search. A player either searches every move
+ * within fixed limits, or plays on a clock: a base time in seconds for the
+ * whole game plus an increment per move. With a clock, each move is given a
+ * share of the remaining time, and a player whose clock runs out loses.
+ */
+struct TimeControl {
+  search::SearchLimits limits;
+  double base_seconds = 0;
+  double increment_seconds = 0;
+
+  // Node limits are varied by up to this fraction either way on every move,
+  // so that the same opening doesn't replay the same game over and over.
+  double node_jitter = 0;
+
+  bool UsesClock() const { return base_seconds > 0; }
+};
+
+struct Player {
+  search::Searcher* searcher;
+  TimeControl time_control;
+};
+
+struct GameRecord {
+  GameResult result;
+  GameEnd end;
+  std::vector<Move> moves;
+};
+
+/**
+ * A callback invoked with every position searched during a game, and the
+ * result of its search, before the chosen move is made.
+ */
+using MoveCallback =
+    std::function<void(const Position&, const search::SearchResult&)>;
+
+/**
+ * Plays a game from the given position between two players. The seed makes
+ * any node jitter reproducible.
+ */
+GameRecord PlayGame(const Position& start, const Player& white,
+                    const Player& black, uint64_t seed,
+                    const MoveCallback& on_move = {});
+
+/**
+ * Returns whether neither side has enough material left to checkmate: bare
+ * kings, or a single minor piece against a bare king.
+ */
+bool IsInsufficientMaterial(const Position& pos);
+
+}  // namespace apollo::match
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+
+#include "match/sprt.h"
+
+namespace apollo::match {
+
+namespace {
+
+double ScoreOfElo(double elo) { return 1 / (1 + std::pow(10, -elo / 400)); }
+
+double EloOfScore(double score) {
+  return -400 * std::log10(1 / score - 1);
+}
+
+/**
+ * Returns the variance of the result of a single game, given a score.
+ */
+double Variance(const MatchScore& score) {
+  double n = static_cast<double>(score.Games());
+  double mean = score.Score();
+  return (score.wins * std::pow(1 - mean, 2) +
+          score.losses * std::pow(0 - mean, 2) +
+          score.draws * std::pow(0.5 - mean, 2)) /
+         n;
+}
+
+}  // anonymous namespace
+
+double MatchScore::Score() const {
+  if (Games() == 0) {
+    return 0.5;
+  }
+  return (wins + draws / 2.0) / Games();
+}
+
+double MatchScore::Elo() const {
+  double score = Score();
+  if (score <= 0 || score >= 1) {
+    return score <= 0 ? -INFINITY : INFINITY;
+  }
+  return EloOfScore(score);
+}
+
+double MatchScore::EloMargin() const {
+  double score = Score();
+  if (Games() == 0 || score <= 0 || score >= 1) {
+    return INFINITY;
+  }
+
+  double deviation = std::sqrt(Variance(*this) / Games());
+  double low = std::max(score - 1.96 * deviation, 1e-9);
+  double high = std::min(score + 1.96 * deviation, 1 - 1e-9);
+  return (EloOfScore(high) - EloOfScore(low)) / 2;
+}
+
+Sprt::Sprt(double elo0, double elo1, double alpha, double beta)
+    : elo0_(elo0),
+      elo1_(elo1),
+      lower_bound_(std::log(beta / (1 - alpha))),
+      upper_bound_(std::log((1 - beta) / alpha)) {}
+
+double Sprt::LogLikelihoodRatio(const MatchScore& score) const {
+  if (score.wins == 0 || score.losses == 0) {
+    // Until both sides have won a game there's no useful variance estimate.
+    return 0;
+  }
+
+  double variance = Variance(score);
+  double s0 = ScoreOfElo(elo0_);
+  double s1 = ScoreOfElo(elo1_);
+  double n = static_cast<double>(score.Games());
+  return (s1 - s0) * (2 * n * score.Score() - n * (s0 + s1)) /
+         (2 * variance);
+}
+
+SprtDecision Sprt::Decide(const MatchScore& score) const {
+  double llr = LogLikelihoodRatio(score);
+  if (llr <= lower_bound_) {
+    return kSprtAcceptH0;
+  }
+  if (llr >= upper_bound_) {
+    return kSprtAcceptH1;
+  }
+  return kSprtContinue;
+}
+
+}  // namespace apollo::match
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+
+namespace apollo::match {
+
+/**
+ * Wins, losses and draws, from the point of view of the first engine of a
+ * match.
+ */
+struct MatchScore {
+  uint64_t wins = 0;
+  uint64_t losses = 0;
+  uint64_t draws = 0;
+
+  uint64_t Games() const { return wins + losses + draws; }
+
+  /**
+   * Returns the mean score per game, counting draws as half a point.
+   */
+  double Score() const;
+
+  /**
+   * Returns the Elo difference that the score implies.
+   */
+  double Elo() const;
+
+  /**
+   * Returns the half-width of the 95% confidence interval around Elo().
+   */
+  double EloMargin() const;
+};
+
+enum SprtDecision {
+  kSprtContinue,
+  kSprtAcceptH0,
+  kSprtAcceptH1,
+};
+
+/**
+ * A sequential probability ratio test between the hypotheses that the first
+ * engine of a match is elo0 stronger than the second (H0) and that it is
+ * elo1 stronger (H1), with false positive rate alpha and false negative rate
+ * beta.
+ *
+ * The log-likelihood ratio uses the usual normal approximation to the
+ * trinomial distribution of game results, as cutechess-cli and fishtest do.
+ */
+class Sprt {
+ public:
+  Sprt(double elo0, double elo1, double alpha, double beta);
+
+  double LowerBound() const { return lower_bound_; }
+  double UpperBound() const { return upper_bound_; }
+
+  /**
+   * Returns the log-likelihood ratio of H1 to H0, given a score.
+   */
+  double LogLikelihoodRatio(const MatchScore& score) const;
+
+  /**
+   * Returns whether the test can stop, and if so which hypothesis it
+   * accepts.
+   */
+  SprtDecision Decide(const MatchScore& score) const;
+
+ private:
+  double elo0_;
+  double elo1_;
+  double lower_bound_;
+  double upper_bound_;
+};
+
+}  // namespace apollo::match
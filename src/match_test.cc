@@ -0,0 +1,84 @@
+#include <memory>
+#include "gtest/gtest.h"
+
+#include "evaluators/shannon_evaluator.h"
+#include "match/game.h"
+#include "match/sprt.h"
+#include "position.h"
+#include "search/searcher.h"
+
+using apollo::Position;
+using apollo::evaluators::ShannonEvaluator;
+using apollo::match::GameRecord;
+using apollo::match::MatchScore;
+using apollo::match::Player;
+using apollo::match::Sprt;
+using apollo::search::Searcher;
+
+TEST(SprtTest, Bounds) {
+  Sprt sprt(0, 5, 0.05, 0.05);
+  ASSERT_NEAR(-2.944, sprt.LowerBound(), 1e-3);
+  ASSERT_NEAR(2.944, sprt.UpperBound(), 1e-3);
+}
+
+TEST(SprtTest, LogLikelihoodRatio) {
+  Sprt sprt(0, 5, 0.05, 0.05);
+  MatchScore score;
+  score.wins = 100;
+  score.losses = 80;
+  score.draws = 120;
+  ASSERT_NEAR(0.431, sprt.LogLikelihoodRatio(score), 1e-3);
+  ASSERT_EQ(apollo::match::kSprtContinue, sprt.Decide(score));
+
+  score.wins = 1200;
+  score.losses = 1000;
+  score.draws = 1000;
+  ASSERT_EQ(apollo::match::kSprtAcceptH1, sprt.Decide(score));
+
+  score.wins = 1000;
+  score.losses = 1200;
+  ASSERT_EQ(apollo::match::kSprtAcceptH0, sprt.Decide(score));
+}
+
+TEST(SprtTest, Elo) {
+  MatchScore score;
+  score.wins = 64;
+  score.losses = 36;
+  ASSERT_NEAR(100.0, score.Elo(), 1.0);
+  ASSERT_GT(score.EloMargin(), 0.0);
+
+  score.losses = 64;
+  ASSERT_NEAR(0.0, score.Elo(), 1e-9);
+}
+
+TEST(MatchGameTest, InsufficientMaterial) {
+  ASSERT_TRUE(apollo::match::IsInsufficientMaterial(
+      Position("8/8/4k3/8/8/2N5/8/4K3 w - - 0 1")));
+  ASSERT_FALSE(apollo::match::IsInsufficientMaterial(
+      Position("8/8/4k3/8/8/2NN4/8/4K3 w - - 0 1")));
+  ASSERT_FALSE(apollo::match::IsInsufficientMaterial(
+      Position("8/8/4k3/8/8/8/P7/4K3 w - - 0 1")));
+}
+
+TEST(MatchGameTest, PlaysToCheckmate) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Player player{&searcher, {}};
+  player.time_control.limits.depth = 2;
+
+  // Mate in one for white.
+  Position start("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+  GameRecord record = apollo::match::PlayGame(start, player, player, 0);
+  ASSERT_EQ(apollo::match::kWhiteWins, record.result);
+  ASSERT_EQ(apollo::match::kCheckmate, record.end);
+}
+
+TEST(MatchGameTest, BareKingsAreDrawn) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Player player{&searcher, {}};
+  player.time_control.limits.depth = 1;
+  GameRecord record = apollo::match::PlayGame(
+      Position("8/8/4k3/8/8/8/8/4K3 w - - 0 1"), player, player, 0);
+  ASSERT_EQ(apollo::match::kDraw, record.result);
+  ASSERT_EQ(apollo::match::kInsufficientMaterial, record.end);
+  ASSERT_TRUE(record.moves.empty());
+}
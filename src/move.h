@@ -13,121 +13,118 @@
 
 namespace apollo {
 
+/**
+ * A Move is a chess move packed into 16 bits. The low six bits are the source
+ * square, the next six are the destination square and the top four are flags
+ * describing the kind of move:
+ *
+ *   bit 15: promotion
+ *   bit 14: capture
+ *   bits 12-13: special, whose meaning depends on the other two flags
+ *
+ *   0000 quiet                  1000 knight promotion
+ *   0001 double pawn push       1001 bishop promotion
+ *   0010 kingside castle        1010 rook promotion
+ *   0011 queenside castle       1011 queen promotion
+ *   0100 capture                1100-1111 promotion captures, as above
+ *   0101 en passant capture
+ *
+ * The null move is the quiet move from A1 to A1, which is all zeros.
+ */
 class Move {
   friend struct std::hash<Move>;
 
  public:
-  static Move Quiet(Square src, Square dst) { return Move(src, dst); }
-
-  static Move Capture(Square src, Square dst) {
-    Move mov(src, dst);
-    mov.bitset_.capture_bit_ = 1;
-    return mov;
-  }
-
-  static Move EnPassant(Square src, Square dst) {
-    Move mov = Capture(src, dst);
-    mov.bitset_.special_1_bit_ = 1;
-    return mov;
-  }
-
-  static Move DoublePawnPush(Square src, Square dst) {
-    Move mov = Quiet(src, dst);
-    mov.bitset_.special_1_bit_ = 1;
-    return mov;
-  }
-
-  static Move Promotion(Square src, Square dst, PieceKind kind) {
-    Move mov = Quiet(src, dst);
-    mov.bitset_.promotion_bit_ = 1;
-    switch (kind) {
-      case kBishop:
-        mov.bitset_.special_1_bit_ = 1;
-        break;
-      case kRook:
-        mov.bitset_.special_0_bit_ = 1;
-        break;
-      case kQueen:
-        mov.bitset_.special_0_bit_ = 1;
-        mov.bitset_.special_1_bit_ = 1;
-        break;
-      default:
-        break;
-    }
-    return mov;
-  }
+  /**
+   * Constructs the null move.
+   */
+  constexpr Move() : bits_(0) {}
 
-  static Move PromotionCapture(Square src, Square dst, PieceKind kind) {
-    Move mov = Promotion(src, dst, kind);
-    mov.bitset_.capture_bit_ = 1;
-    return mov;
+  static constexpr Move Quiet(Square src, Square dst) {
+    return Move(src, dst, 0);
   }
 
-  static Move KingsideCastle(Square src, Square dst) {
-    Move mov = Quiet(src, dst);
-    mov.bitset_.special_0_bit_ = 1;
-    return mov;
+  static constexpr Move Capture(Square src, Square dst) {
+    return Move(src, dst, kCaptureFlag);
   }
 
-  static Move QueensideCastle(Square src, Square dst) {
-    Move mov = Quiet(src, dst);
-    mov.bitset_.special_0_bit_ = 1;
-    mov.bitset_.special_1_bit_ = 1;
-    return mov;
+  static constexpr Move EnPassant(Square src, Square dst) {
+    return Move(src, dst, kCaptureFlag | kSpecial0Flag);
   }
 
-  static Move Null() { return Quiet(Square::A1, Square::A1); }
+  static constexpr Move DoublePawnPush(Square src, Square dst) {
+    return Move(src, dst, kSpecial0Flag);
+  }
 
-  Square Source() const { return static_cast<Square>(bitset_.source_); }
+  static constexpr Move Promotion(Square src, Square dst, PieceKind kind) {
+    return Move(src, dst, kPromotionFlag | PromotionBits(kind));
+  }
 
-  Square Destination() const { return static_cast<Square>(bitset_.dest_); }
+  static constexpr Move PromotionCapture(Square src, Square dst,
+                                         PieceKind kind) {
+    return Move(src, dst, kPromotionFlag | kCaptureFlag | PromotionBits(kind));
+  }
 
-  PieceKind PromotionPiece() const {
-    CHECK(bitset_.promotion_bit_)
-        << "PromotionPiece only valid on promotion moves";
-    if (bitset_.special_0_bit_ && bitset_.special_1_bit_) {
-      return kQueen;
-    }
-    if (bitset_.special_0_bit_) {
-      return kRook;
-    }
-    if (bitset_.special_1_bit_) {
-      return kBishop;
-    }
-    return kKnight;
+  static constexpr Move KingsideCastle(Square src, Square dst) {
+    return Move(src, dst, kSpecial1Flag);
   }
 
-  bool IsQuiet() const {
-    return bitset_.promotion_bit_ == 0 && bitset_.capture_bit_ == 0 &&
-           bitset_.special_0_bit_ == 0 && bitset_.special_1_bit_ == 0;
+  static constexpr Move QueensideCastle(Square src, Square dst) {
+    return Move(src, dst, kSpecial1Flag | kSpecial0Flag);
   }
 
-  bool IsCapture() const { return bitset_.capture_bit_; }
+  static constexpr Move Null() { return Quiet(Square::A1, Square::A1); }
 
-  bool IsNull() const { return bits_ == 0; }
+  /**
+   * Returns the move with the given 16-bit encoding, as returned by Bits.
+   */
+  static constexpr Move FromBits(uint16_t bits) { return Move(bits); }
 
-  bool IsKingsideCastle() const {
-    return !bitset_.promotion_bit_ && !bitset_.capture_bit_ &&
-           bitset_.special_0_bit_ && !bitset_.special_1_bit_;
+  /**
+   * Returns the 16-bit encoding of this move.
+   */
+  constexpr uint16_t Bits() const { return bits_; }
+
+  constexpr Square Source() const {
+    return static_cast<Square>(bits_ & kSquareMask);
+  }
+
+  constexpr Square Destination() const {
+    return static_cast<Square>((bits_ >> kDestinationShift) & kSquareMask);
   }
 
-  bool IsQueensideCastle() const {
-    return !bitset_.promotion_bit_ && !bitset_.capture_bit_ &&
-           bitset_.special_0_bit_ && bitset_.special_1_bit_;
+  /**
+   * Returns the piece that this move promotes to. Only meaningful for
+   * promotions.
+   */
+  constexpr PieceKind PromotionPiece() const {
+    return static_cast<PieceKind>(kKnight + (Flags() & kSpecialMask));
   }
 
-  bool IsCastle() const { return IsKingsideCastle() || IsQueensideCastle(); }
+  constexpr bool IsQuiet() const { return Flags() == 0; }
+
+  constexpr bool IsCapture() const { return (Flags() & kCaptureFlag) != 0; }
+
+  constexpr bool IsNull() const { return bits_ == 0; }
+
+  constexpr bool IsKingsideCastle() const { return Flags() == kSpecial1Flag; }
+
+  constexpr bool IsQueensideCastle() const {
+    return Flags() == (kSpecial1Flag | kSpecial0Flag);
+  }
 
-  bool IsPromotion() const { return bitset_.promotion_bit_; }
+  constexpr bool IsCastle() const {
+    return (Flags() & ~kSpecial0Flag) == kSpecial1Flag;
+  }
 
-  bool IsDoublePawnPush() const {
-    return !bitset_.promotion_bit_ && !bitset_.capture_bit_ &&
-           !bitset_.special_0_bit_ && bitset_.special_1_bit_;
+  constexpr bool IsPromotion() const {
+    return (Flags() & kPromotionFlag) != 0;
   }
 
-  bool IsEnPassant() const {
-    return !bitset_.promotion_bit_ && bitset_.capture_bit_ &&
-           !bitset_.special_0_bit_ && bitset_.special_1_bit_;
+  constexpr bool IsDoublePawnPush() const { return Flags() == kSpecial0Flag; }
+
+  constexpr bool IsEnPassant() const {
+    return Flags() == (kCaptureFlag | kSpecial0Flag);
   }
 
   std::string AsUci() const {
@@ -159,35 +156,59 @@ class Move {
     return str.str();
   }
 
-  bool operator==(const Move other) const { return other.bits_ == bits_; }
+  constexpr bool operator==(const Move other) const {
+    return other.bits_ == bits_;
+  }
+
+  constexpr bool operator!=(const Move other) const {
+    return other.bits_ != bits_;
+  }
 
  private:
-  Move(Square src, Square dst) {
-    this->bitset_.promotion_bit_ = 0;
-    this->bitset_.capture_bit_ = 0;
-    this->bitset_.source_ = static_cast<uint8_t>(src);
-    this->bitset_.special_0_bit_ = 0;
-    this->bitset_.special_1_bit_ = 0;
-    this->bitset_.dest_ = static_cast<uint8_t>(dst);
-  }
-
-  struct Bitset {
-    bool promotion_bit_ : 1;
-    bool capture_bit_ : 1;
-    uint8_t source_ : 6;
-    bool special_0_bit_ : 1;
-    bool special_1_bit_ : 1;
-    uint8_t dest_ : 6;
-  };
-
-  static_assert(sizeof(Bitset) == sizeof(uint16_t));
-  union {
-    Bitset bitset_;
-    uint16_t bits_;
-  };
+  static constexpr int kDestinationShift = 6;
+  static constexpr int kFlagsShift = 12;
+  static constexpr uint16_t kSquareMask = 0x3F;
+
+  static constexpr uint16_t kSpecial0Flag = 0x1;
+  static constexpr uint16_t kSpecial1Flag = 0x2;
+  static constexpr uint16_t kSpecialMask = kSpecial0Flag | kSpecial1Flag;
+  static constexpr uint16_t kCaptureFlag = 0x4;
+  static constexpr uint16_t kPromotionFlag = 0x8;
+
+  constexpr explicit Move(uint16_t bits) : bits_(bits) {}
+
+  constexpr Move(Square src, Square dst, uint16_t flags)
+      : bits_(static_cast<uint16_t>(
+            static_cast<uint16_t>(src) |
+            (static_cast<uint16_t>(dst) << kDestinationShift) |
+            (flags << kFlagsShift))) {}
+
+  static constexpr uint16_t PromotionBits(PieceKind kind) {
+    return static_cast<uint16_t>(kind - kKnight) & kSpecialMask;
+  }
+
+  constexpr uint16_t Flags() const { return bits_ >> kFlagsShift; }
+
+  uint16_t bits_;
 };
 
 static_assert(sizeof(Move) == sizeof(uint16_t));
+static_assert(
+    Move::Promotion(Square::A7, Square::A8, kQueen).PromotionPiece() == kQueen);
+static_assert(Move::FromBits(Move::EnPassant(Square::E5, Square::D6).Bits())
+                  .IsEnPassant());
+
+/**
+ * A move paired with a score used to order it. Both fit in 32 bits, so that
+ * a full list of scored moves stays small enough to remain in cache while it
+ * is sorted in place.
+ */
+struct ScoredMove {
+  Move move;
+  int16_t score;
+};
+
+static_assert(sizeof(ScoredMove) == sizeof(uint32_t));
 
 inline std::ostream& operator<<(std::ostream& os, const Move& mov) {
   os << mov.AsUci();
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "log.h"
+#include "move.h"
+
+namespace apollo {
+
+/**
+ * The most moves that can be generated in any position. No legal position
+ * has more than 218 legal moves; the extra room covers pseudolegal moves.
+ */
+constexpr size_t kMaxMoves = 256;
+
+/**
+ * A MoveList is a fixed-capacity list of scored moves. It never allocates,
+ * so the search can keep one per ply on the stack.
+ */
+class MoveList {
+ public:
+  MoveList() : size_(0) {}
+
+  void push_back(Move mov) {
+    DCHECK(size_ < kMaxMoves) << "move list is full";
+    moves_[size_++] = {mov, 0};
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  void clear() { size_ = 0; }
+
+  ScoredMove& operator[](size_t i) { return moves_[i]; }
+  const ScoredMove& operator[](size_t i) const { return moves_[i]; }
+
+  ScoredMove* begin() { return moves_.data(); }
+  ScoredMove* end() { return moves_.data() + size_; }
+  const ScoredMove* begin() const { return moves_.data(); }
+  const ScoredMove* end() const { return moves_.data() + size_; }
+
+ private:
+  std::array<ScoredMove, kMaxMoves> moves_;
+  size_t size_;
+};
+
+}  // namespace apollo
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "move.h"
+#include "position.h"
+#include "search/move_picker.h"
+
+using apollo::Move;
+using apollo::Position;
+using apollo::Square;
+using apollo::search::MovePicker;
+
+namespace {
+
+std::vector<Move> PickAll(const Position& pos) {
+  std::vector<Move> moves;
+  MovePicker picker(pos);
+  Move mov;
+  while (picker.Next(mov)) {
+    moves.push_back(mov);
+  }
+  return moves;
+}
+
+}  // anonymous namespace
+
+TEST(MovePickerTest, PicksEveryMove) {
+  Position pos(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+  std::vector<Move> picked = PickAll(pos);
+  std::vector<Move> generated = pos.PseudolegalMoves();
+  ASSERT_EQ(generated.size(), picked.size());
+  for (Move mov : generated) {
+    ASSERT_NE(picked.end(), std::find(picked.begin(), picked.end(), mov));
+  }
+}
+
+TEST(MovePickerTest, MostValuableVictimFirst) {
+  // The knight can take either a pawn or the queen.
+  Position pos("4k3/8/8/p1q5/8/1N6/8/4K3 w - - 0 1");
+  std::vector<Move> picked = PickAll(pos);
+  ASSERT_EQ(Move::Capture(Square::B3, Square::C5), picked[0]);
+  ASSERT_EQ(Move::Capture(Square::B3, Square::A5), picked[1]);
+}
+
+TEST(MovePickerTest, LeastValuableAttackerFirst) {
+  Position pos("4k3/8/8/2r5/1P6/3N4/8/4K3 w - - 0 1");
+  std::vector<Move> picked = PickAll(pos);
+  ASSERT_EQ(Move::Capture(Square::B4, Square::C5), picked[0]);
+  ASSERT_EQ(Move::Capture(Square::D3, Square::C5), picked[1]);
+  ASSERT_FALSE(picked[2].IsCapture());
+}
@@ -19,3 +19,37 @@ TEST(Move, Capture) {
   ASSERT_EQ(Square::A3, m.Source());
   ASSERT_EQ(Square::A4, m.Destination());
 }
+
+TEST(Move, Promotion) {
+  for (apollo::PieceKind kind :
+       {apollo::kKnight, apollo::kBishop, apollo::kRook, apollo::kQueen}) {
+    Move m = Move::PromotionCapture(Square::B7, Square::A8, kind);
+    ASSERT_TRUE(m.IsPromotion());
+    ASSERT_TRUE(m.IsCapture());
+    ASSERT_FALSE(m.IsCastle());
+    ASSERT_EQ(kind, m.PromotionPiece());
+  }
+}
+
+TEST(Move, BitsRoundTrip) {
+  Move moves[] = {
+      Move::Quiet(Square::G1, Square::F3),
+      Move::DoublePawnPush(Square::E2, Square::E4),
+      Move::EnPassant(Square::E5, Square::D6),
+      Move::KingsideCastle(Square::E1, Square::G1),
+      Move::QueensideCastle(Square::E8, Square::C8),
+      Move::Promotion(Square::H7, Square::H8, apollo::kQueen),
+  };
+  for (Move m : moves) {
+    Move decoded = Move::FromBits(m.Bits());
+    ASSERT_EQ(m, decoded);
+    ASSERT_EQ(m.Source(), decoded.Source());
+    ASSERT_EQ(m.Destination(), decoded.Destination());
+  }
+}
+
+TEST(Move, DefaultIsNull) {
+  ASSERT_TRUE(Move().IsNull());
+  ASSERT_EQ(Move::Null(), Move());
+  ASSERT_EQ(0, Move::Null().Bits());
+}
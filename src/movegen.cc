@@ -6,80 +6,91 @@ namespace apollo {
 
 namespace {
 
-void GeneratePawnMoves(const Position& pos, std::vector<Move>& moves) {
-  Color color = pos.SideToMove();
-  Bitboard enemy_pieces = pos.Pieces(!color);
-  Bitboard allied_pieces = pos.Pieces(color);
-  Bitboard pieces = enemy_pieces | allied_pieces;
-
-  Rank start_rank = color == kWhite ? kRank2 : kRank7;
-  Rank promo_rank = color == kWhite ? kRank8 : kRank1;
-  Direction pawn_dir = color == kWhite ? kDirectionNorth : kDirectionSouth;
-  Direction ep_dir = color == kWhite ? kDirectionSouth : kDirectionNorth;
-
-  pos.Pawns(color).ForEach([&](Square pawn) {
-    // Pawns shouldn't be on the promotion rank.
-    CHECK(util::RankOf(pawn) != promo_rank)
-        << "Pawns shouldn't be on the promotion rank";
-    Square target = util::Towards(pawn, pawn_dir);
-
-    // Non-capturing moves.
-    if (!pieces.Test(target)) {
-      if (util::RankOf(target) == promo_rank) {
-        moves.push_back(Move::Promotion(pawn, target, kKnight));
-        moves.push_back(Move::Promotion(pawn, target, kBishop));
-        moves.push_back(Move::Promotion(pawn, target, kRook));
-        moves.push_back(Move::Promotion(pawn, target, kQueen));
-      } else {
-        moves.push_back(Move::Quiet(pawn, target));
-      }
-    }
+// The generators are specialized on the color of the side to move, so that the
+// ranks, directions and squares that depend on it are all constants.
+
+template <Color Us, typename MoveContainer>
+void GeneratePawnMoves(const Position& pos, MoveContainer& moves) {
+  // Pawns are generated a whole set at a time: shifting the pawn bitboard
+  // gives the destinations of every pawn at once, and each destination's
+  // source is a constant offset away.
+  constexpr Direction kUp = Us == kWhite ? kDirectionNorth : kDirectionSouth;
+  constexpr Direction kDown = Us == kWhite ? kDirectionSouth : kDirectionNorth;
+  constexpr Direction kUpEast =
+      Us == kWhite ? kDirectionNorthEast : kDirectionSouthEast;
+  constexpr Direction kUpWest =
+      Us == kWhite ? kDirectionNorthWest : kDirectionSouthWest;
+  constexpr Bitboard kPushRank = Us == kWhite ? kBBRank3 : kBBRank6;
+  constexpr Bitboard kPromoRank = Us == kWhite ? kBBRank8 : kBBRank1;
+
+  Bitboard pawns = pos.Pawns(Us);
+  Bitboard enemy_pieces = pos.Pieces(!Us);
+  Bitboard empty = ~(enemy_pieces | pos.Pieces(Us));
+  CHECK((pawns & kPromoRank).Empty())
+      << "Pawns shouldn't be on the promotion rank";
+
+  Bitboard single_pushes = Shift<kUp>(pawns) & empty;
+  Bitboard double_pushes = Shift<kUp>(single_pushes & kPushRank) & empty;
+  Bitboard east_captures = Shift<kUpEast>(pawns) & enemy_pieces;
+  Bitboard west_captures = Shift<kUpWest>(pawns) & enemy_pieces;
+
+  // Recovers the source of a pawn move from its destination.
+  auto from = [](Square target, Direction dir) {
+    return static_cast<Square>(static_cast<int>(target) -
+                               kDirectionVectors[dir]);
+  };
+
+  // Non-capturing moves.
+  (single_pushes & ~kPromoRank).ForEach([&](Square target) {
+    moves.push_back(Move::Quiet(from(target, kUp), target));
+  });
+  (single_pushes & kPromoRank).ForEach([&](Square target) {
+    Square pawn = from(target, kUp);
+    moves.push_back(Move::Promotion(pawn, target, kKnight));
+    moves.push_back(Move::Promotion(pawn, target, kBishop));
+    moves.push_back(Move::Promotion(pawn, target, kRook));
+    moves.push_back(Move::Promotion(pawn, target, kQueen));
+  });
 
-    // Double pawn pushes, for pawns originating on the starting rank.
-    if (util::RankOf(pawn) == start_rank) {
-      Square two_push_target = util::Towards(target, pawn_dir);
-      if (!pieces.Test(target) && !pieces.Test(two_push_target)) {
-        moves.push_back(Move::DoublePawnPush(pawn, two_push_target));
-      }
-    }
+  // Double pawn pushes, for pawns originating on the starting rank.
+  double_pushes.ForEach([&](Square target) {
+    moves.push_back(Move::DoublePawnPush(from(from(target, kUp), kUp), target));
+  });
 
-    // Non-en-passant capturing moves.
-    attacks::PawnAttacks(pawn, color).ForEach([&](Square target) {
-      if (enemy_pieces.Test(target)) {
-        CHECK(!allied_pieces.Test(target))
-            << "Square can't be occupied by both allied and enemy pieces";
-        if (util::RankOf(target) == promo_rank) {
-          moves.push_back(Move::PromotionCapture(pawn, target, kKnight));
-          moves.push_back(Move::PromotionCapture(pawn, target, kBishop));
-          moves.push_back(Move::PromotionCapture(pawn, target, kRook));
-          moves.push_back(Move::PromotionCapture(pawn, target, kQueen));
-        } else {
-          moves.push_back(Move::Capture(pawn, target));
-        }
-      }
+  // Non-en-passant capturing moves.
+  auto add_captures = [&](Bitboard targets, Direction dir) {
+    (targets & ~kPromoRank).ForEach([&](Square target) {
+      moves.push_back(Move::Capture(from(target, dir), target));
     });
-
-    // En passant moves.
-    if (pos.EnPassantSquare()) {
-      Square ep_square = *pos.EnPassantSquare();
-      // Would this move be a normal legal attack for this pawn?
-      if (attacks::PawnAttacks(pawn, color).Test(ep_square)) {
-        // If so, the attack square is directly behind the pawn that was pushed.
-        Square attack_sq = util::Towards(ep_square, ep_dir);
-        CHECK(enemy_pieces.Test(attack_sq))
-            << "square behind EP-square unoccupied";
-        CHECK(!pieces.Test(ep_square)) << "EP-square should be unoccupied";
-        moves.push_back(Move::EnPassant(pawn, ep_square));
-      }
-    }
-  });
+    (targets & kPromoRank).ForEach([&](Square target) {
+      Square pawn = from(target, dir);
+      moves.push_back(Move::PromotionCapture(pawn, target, kKnight));
+      moves.push_back(Move::PromotionCapture(pawn, target, kBishop));
+      moves.push_back(Move::PromotionCapture(pawn, target, kRook));
+      moves.push_back(Move::PromotionCapture(pawn, target, kQueen));
+    });
+  };
+  add_captures(east_captures, kUpEast);
+  add_captures(west_captures, kUpWest);
+
+  // En passant moves. The pawns that can capture onto the EP-square are
+  // exactly the ones an enemy pawn on the EP-square would attack.
+  if (pos.EnPassantSquare()) {
+    Square ep_square = *pos.EnPassantSquare();
+    CHECK(empty.Test(ep_square)) << "EP-square should be unoccupied";
+    CHECK(enemy_pieces.Test(util::Towards(ep_square, kDown)))
+        << "square behind EP-square unoccupied";
+    (attacks::PawnAttacks(ep_square, !Us) & pawns).ForEach([&](Square pawn) {
+      moves.push_back(Move::EnPassant(pawn, ep_square));
+    });
+  }
 }
 
-void GenerateKnightMoves(const Position& pos, std::vector<Move>& moves) {
-  Color color = pos.SideToMove();
-  Bitboard enemy_pieces = pos.Pieces(!color);
-  Bitboard allied_pieces = pos.Pieces(color);
-  pos.Knights(color).ForEach([&](Square knight) {
+template <Color Us, typename MoveContainer>
+void GenerateKnightMoves(const Position& pos, MoveContainer& moves) {
+  Bitboard enemy_pieces = pos.Pieces(!Us);
+  Bitboard allied_pieces = pos.Pieces(Us);
+  pos.Knights(Us).ForEach([&](Square knight) {
     attacks::KnightAttacks(knight).ForEach([&](Square target) {
       if (enemy_pieces.Test(target)) {
         moves.push_back(Move::Capture(knight, target));
@@ -90,13 +101,13 @@ void GenerateKnightMoves(const Position& pos, std::vector<Move>& moves) {
   });
 }
 
-template <typename BoardCallback, typename AttackCallback>
-void GenerateSlidingMoves(const Position& pos, std::vector<Move>& moves,
+template <Color Us, typename MoveContainer, typename BoardCallback,
+          typename AttackCallback>
+void GenerateSlidingMoves(const Position& pos, MoveContainer& moves,
                           BoardCallback bc, AttackCallback atk) {
-  Color color = pos.SideToMove();
-  Bitboard enemy_pieces = pos.Pieces(!color);
-  Bitboard allied_pieces = pos.Pieces(color);
-  bc(color).ForEach([&](Square piece) {
+  Bitboard enemy_pieces = pos.Pieces(!Us);
+  Bitboard allied_pieces = pos.Pieces(Us);
+  bc(Us).ForEach([&](Square piece) {
     atk(piece, enemy_pieces | allied_pieces).ForEach([&](Square target) {
       // In theory, we only need to test the end of rays for occupancy,
       // but this works.
@@ -109,11 +120,14 @@ void GenerateSlidingMoves(const Position& pos, std::vector<Move>& moves,
   });
 }
 
-void GenerateKingMoves(const Position& pos, std::vector<Move>& moves) {
-  Color color = pos.SideToMove();
-  Bitboard enemy_pieces = pos.Pieces(!color);
-  Bitboard allied_pieces = pos.Pieces(color);
-  pos.Kings(color).ForEach([&](Square king) {
+template <Color Us, typename MoveContainer>
+void GenerateKingMoves(const Position& pos, MoveContainer& moves) {
+  constexpr Square kKingsideRook = Us == kWhite ? Square::H1 : Square::H8;
+  constexpr Square kQueensideRook = Us == kWhite ? Square::A1 : Square::A8;
+
+  Bitboard enemy_pieces = pos.Pieces(!Us);
+  Bitboard allied_pieces = pos.Pieces(Us);
+  pos.Kings(Us).ForEach([&](Square king) {
     attacks::KingAttacks(king).ForEach([&](Square target) {
       if (enemy_pieces.Test(target)) {
         moves.push_back(Move::Capture(king, target));
@@ -122,36 +136,34 @@ void GenerateKingMoves(const Position& pos, std::vector<Move>& moves) {
       }
     });
 
-    if (pos.IsCheck(color)) {
+    if (pos.IsCheck(Us)) {
       // No castling out of check.
       return;
     }
 
     Bitboard all_pieces = allied_pieces | enemy_pieces;
-    if (pos.CanCastleKingside(color)) {
-      Square starting_rook = color == kWhite ? Square::H1 : Square::H8;
-      auto maybe_rook = pos.PieceAt(starting_rook);
+    if (pos.CanCastleKingside(Us)) {
+      auto maybe_rook = pos.PieceAt(kKingsideRook);
       if (maybe_rook && maybe_rook->kind() == kRook &&
-          maybe_rook->color() == color) {
+          maybe_rook->color() == Us) {
         Square one = util::Towards(king, kDirectionEast);
         Square two = util::Towards(one, kDirectionEast);
         if (!all_pieces.Test(one) && !all_pieces.Test(two)) {
           // The king moves across both squares one and two and it is illegal to
           // castle through check. We can only proceed if no enemy piece is
           // attacking the squares the king travels upon.
-          if (pos.SquaresAttacking(!color, one).Empty() &&
-              pos.SquaresAttacking(!color, two).Empty()) {
+          if (pos.SquaresAttacking(!Us, one).Empty() &&
+              pos.SquaresAttacking(!Us, two).Empty()) {
             moves.push_back(Move::KingsideCastle(king, two));
           }
         }
       }
     }
 
-    if (pos.CanCastleQueenside(color)) {
-      Square starting_rook = color == kWhite ? Square::A1 : Square::A8;
-      auto maybe_rook = pos.PieceAt(starting_rook);
+    if (pos.CanCastleQueenside(Us)) {
+      auto maybe_rook = pos.PieceAt(kQueensideRook);
       if (maybe_rook && maybe_rook->kind() == kRook &&
-          maybe_rook->color() == color) {
+          maybe_rook->color() == Us) {
         Square one = util::Towards(king, kDirectionWest);
         Square two = util::Towards(one, kDirectionWest);
         Square three = util::Towards(two, kDirectionWest);
@@ -159,8 +171,8 @@ void GenerateKingMoves(const Position& pos, std::vector<Move>& moves) {
             !all_pieces.Test(three)) {
           // Square three can be checked, but it can't be occupied. The rook
           // travels across square three, but the king does not.
-          if (pos.SquaresAttacking(!color, one).Empty() &&
-              pos.SquaresAttacking(!color, two).Empty()) {
+          if (pos.SquaresAttacking(!Us, one).Empty() &&
+              pos.SquaresAttacking(!Us, two).Empty()) {
             moves.push_back(Move::QueensideCastle(king, two));
           }
         }
@@ -169,22 +181,35 @@ void GenerateKingMoves(const Position& pos, std::vector<Move>& moves) {
   });
 }
 
+template <Color Us, typename MoveContainer>
+void GenerateMoves(const Position& pos, MoveContainer& moves) {
+  GenerateKnightMoves<Us>(pos, moves);
+  GenerateSlidingMoves<Us>(pos, moves, [&](Color c) { return pos.Bishops(c); },
+                           attacks::BishopAttacks);
+  GenerateSlidingMoves<Us>(pos, moves, [&](Color c) { return pos.Rooks(c); },
+                           attacks::RookAttacks);
+  GenerateSlidingMoves<Us>(pos, moves, [&](Color c) { return pos.Queens(c); },
+                           attacks::QueenAttacks);
+  GenerateKingMoves<Us>(pos, moves);
+  GeneratePawnMoves<Us>(pos, moves);
+}
+
 }  // anonymous namespace
 
 namespace movegen {
 
-void GeneratePseudolegalMoves(const Position& pos, std::vector<Move>& moves) {
-  GenerateKnightMoves(pos, moves);
-  GenerateSlidingMoves(pos, moves, [&](Color c) { return pos.Bishops(c); },
-                       attacks::BishopAttacks);
-  GenerateSlidingMoves(pos, moves, [&](Color c) { return pos.Rooks(c); },
-                       attacks::RookAttacks);
-  GenerateSlidingMoves(pos, moves, [&](Color c) { return pos.Queens(c); },
-                       attacks::QueenAttacks);
-  GenerateKingMoves(pos, moves);
-  GeneratePawnMoves(pos, moves);
+template <typename MoveContainer>
+void GeneratePseudolegalMoves(const Position& pos, MoveContainer& moves) {
+  if (pos.SideToMove() == kWhite) {
+    GenerateMoves<kWhite>(pos, moves);
+  } else {
+    GenerateMoves<kBlack>(pos, moves);
+  }
 }
 
+template void GeneratePseudolegalMoves(const Position&, std::vector<Move>&);
+template void GeneratePseudolegalMoves(const Position&, MoveList&);
+
 }  // namespace movegen
 
 }  // namespace apollo
@@ -3,10 +3,20 @@
 #include <vector>
 
 #include "move.h"
+#include "move_list.h"
 #include "position.h"
 
 namespace apollo::movegen {
 
-void GeneratePseudolegalMoves(const Position& pos, std::vector<Move>& moves);
+/**
+ * Appends every pseudolegal move in the given position to the given
+ * container, which is either a std::vector<Move> or a MoveList.
+ */
+template <typename MoveContainer>
+void GeneratePseudolegalMoves(const Position& pos, MoveContainer& moves);
+
+extern template void GeneratePseudolegalMoves(const Position&,
+                                              std::vector<Move>&);
+extern template void GeneratePseudolegalMoves(const Position&, MoveList&);
 
 }  // namespace apollo::movegen
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "types.h"
+
+namespace apollo::nnue {
+
+/**
+ * The largest first layer, per perspective, that a network may have.
+ */
+constexpr int kMaxHiddenDimensions = 256;
+
+/**
+ * An Accumulator holds the output of a network's first layer for both
+ * perspectives of a position. Since very few features change from one
+ * position to the next, the accumulator is updated incrementally as pieces
+ * move instead of being recomputed from scratch.
+ *
+ * A perspective is dirty when its king has moved, which changes every one of
+ * its features; dirty perspectives must be refreshed before they are read.
+ */
+struct Accumulator {
+  alignas(32) std::array<std::array<int16_t, kMaxHiddenDimensions>,
+                         kColorLast> values;
+  std::array<bool, kColorLast> dirty;
+};
+
+}  // namespace apollo::nnue
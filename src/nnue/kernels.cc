@@ -0,0 +1,208 @@
+#include <algorithm>
+
+#include "nnue/kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define APOLLO_NNUE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace apollo::nnue {
+
+namespace {
+
+void AddColumnScalar(int16_t* acc, const int16_t* column, int dims) {
+  for (int i = 0; i < dims; i++) {
+    acc[i] = static_cast<int16_t>(acc[i] + column[i]);
+  }
+}
+
+void SubColumnScalar(int16_t* acc, const int16_t* column, int dims) {
+  for (int i = 0; i < dims; i++) {
+    acc[i] = static_cast<int16_t>(acc[i] - column[i]);
+  }
+}
+
+void TransformScalar(const int16_t* acc, uint8_t* output, int dims) {
+  for (int i = 0; i < dims; i++) {
+    output[i] = static_cast<uint8_t>(std::clamp<int>(acc[i], 0, 127));
+  }
+}
+
+void AffineScalar(const uint8_t* input, const int8_t* weights,
+                  const int32_t* bias, int32_t* output, int in_dims,
+                  int out_dims) {
+  for (int i = 0; i < out_dims; i++) {
+    const int8_t* row = weights + i * in_dims;
+    int32_t sum = bias[i];
+    for (int j = 0; j < in_dims; j++) {
+      sum += static_cast<int32_t>(input[j]) * row[j];
+    }
+    output[i] = sum;
+  }
+}
+
+#ifdef APOLLO_NNUE_X86
+
+__attribute__((target("sse4.1"))) void AddColumnSse41(int16_t* acc,
+                                                      const int16_t* column,
+                                                      int dims) {
+  for (int i = 0; i < dims; i += 8) {
+    __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+    _mm_store_si128(a, _mm_add_epi16(_mm_load_si128(a), c));
+  }
+}
+
+__attribute__((target("sse4.1"))) void SubColumnSse41(int16_t* acc,
+                                                      const int16_t* column,
+                                                      int dims) {
+  for (int i = 0; i < dims; i += 8) {
+    __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column + i));
+    _mm_store_si128(a, _mm_sub_epi16(_mm_load_si128(a), c));
+  }
+}
+
+__attribute__((target("sse4.1"))) void TransformSse41(const int16_t* acc,
+                                                      uint8_t* output,
+                                                      int dims) {
+  const __m128i zero = _mm_setzero_si128();
+  for (int i = 0; i < dims; i += 16) {
+    __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+    __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i + 8));
+    // Packing saturates to [-128, 127]; the max takes care of the rest.
+    __m128i packed = _mm_max_epi8(_mm_packs_epi16(lo, hi), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+  }
+}
+
+__attribute__((target("sse4.1"))) void AffineSse41(const uint8_t* input,
+                                                   const int8_t* weights,
+                                                   const int32_t* bias,
+                                                   int32_t* output,
+                                                   int in_dims, int out_dims) {
+  const __m128i ones = _mm_set1_epi16(1);
+  for (int i = 0; i < out_dims; i++) {
+    const int8_t* row = weights + i * in_dims;
+    __m128i sum = _mm_setzero_si128();
+    for (int j = 0; j < in_dims; j += 16) {
+      __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + j));
+      __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j));
+      // Inputs are at most 127, so the pairwise int16 sums can't saturate.
+      __m128i product = _mm_maddubs_epi16(in, w);
+      sum = _mm_add_epi32(sum, _mm_madd_epi16(product, ones));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    output[i] = bias[i] + _mm_cvtsi128_si32(sum);
+  }
+}
+
+__attribute__((target("avx2"))) void AddColumnAvx2(int16_t* acc,
+                                                   const int16_t* column,
+                                                   int dims) {
+  for (int i = 0; i < dims; i += 16) {
+    __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+    __m256i c =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+    _mm256_store_si256(a, _mm256_add_epi16(_mm256_load_si256(a), c));
+  }
+}
+
+__attribute__((target("avx2"))) void SubColumnAvx2(int16_t* acc,
+                                                   const int16_t* column,
+                                                   int dims) {
+  for (int i = 0; i < dims; i += 16) {
+    __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+    __m256i c =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(column + i));
+    _mm256_store_si256(a, _mm256_sub_epi16(_mm256_load_si256(a), c));
+  }
+}
+
+__attribute__((target("avx2"))) void TransformAvx2(const int16_t* acc,
+                                                   uint8_t* output, int dims) {
+  const __m256i zero = _mm256_setzero_si256();
+  for (int i = 0; i < dims; i += 32) {
+    __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+    __m256i hi =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i + 16));
+    __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(lo, hi), zero);
+    // The pack works within 128-bit lanes, leaving the quadwords in the order
+    // lo[0], hi[0], lo[1], hi[1]. Put them back in order.
+    packed = _mm256_permute4x64_epi64(packed, 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+  }
+}
+
+__attribute__((target("avx2"))) void AffineAvx2(const uint8_t* input,
+                                                const int8_t* weights,
+                                                const int32_t* bias,
+                                                int32_t* output, int in_dims,
+                                                int out_dims) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  for (int i = 0; i < out_dims; i++) {
+    const int8_t* row = weights + i * in_dims;
+    __m256i sum = _mm256_setzero_si256();
+    for (int j = 0; j < in_dims; j += 32) {
+      __m256i in =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + j));
+      __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + j));
+      __m256i product = _mm256_maddubs_epi16(in, w);
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(product, ones));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                 _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    output[i] = bias[i] + _mm_cvtsi128_si32(half);
+  }
+}
+
+const Kernels kSse41Kernels = {"sse4.1", AddColumnSse41, SubColumnSse41,
+                               TransformSse41, AffineSse41};
+const Kernels kAvx2Kernels = {"avx2", AddColumnAvx2, SubColumnAvx2,
+                              TransformAvx2, AffineAvx2};
+
+#endif  // APOLLO_NNUE_X86
+
+const Kernels kScalarKernels = {"scalar", AddColumnScalar, SubColumnScalar,
+                                TransformScalar, AffineScalar};
+
+}  // anonymous namespace
+
+const Kernels& ScalarKernels() { return kScalarKernels; }
+
+const Kernels* Sse41Kernels() {
+#ifdef APOLLO_NNUE_X86
+  if (__builtin_cpu_supports("sse4.1")) {
+    return &kSse41Kernels;
+  }
+#endif
+  return nullptr;
+}
+
+const Kernels* Avx2Kernels() {
+#ifdef APOLLO_NNUE_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return &kAvx2Kernels;
+  }
+#endif
+  return nullptr;
+}
+
+const Kernels& BestKernels() {
+  static const Kernels& best = []() -> const Kernels& {
+    if (const Kernels* avx2 = Avx2Kernels()) {
+      return *avx2;
+    }
+    if (const Kernels* sse41 = Sse41Kernels()) {
+      return *sse41;
+    }
+    return ScalarKernels();
+  }();
+  return best;
+}
+
+}  // namespace apollo::nnue
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+namespace apollo::nnue {
+
+/**
+ * Kernels is the set of inner loops used by NNUE inference. There is one set
+ * for each instruction set that apollo3 knows how to use, and the best one
+ * supported by the running CPU is picked once, when the first network is
+ * loaded.
+ *
+ * All dimensions passed to the kernels must be multiples of 32.
+ */
+struct Kernels {
+  const char* name;
+
+  /**
+   * Adds a column of first-layer weights to an accumulator.
+   */
+  void (*add_column)(int16_t* acc, const int16_t* column, int dims);
+
+  /**
+   * Subtracts a column of first-layer weights from an accumulator.
+   */
+  void (*sub_column)(int16_t* acc, const int16_t* column, int dims);
+
+  /**
+   * Clamps an accumulator to [0, 127], producing the input of the second
+   * layer.
+   */
+  void (*transform)(const int16_t* acc, uint8_t* output, int dims);
+
+  /**
+   * Computes output = weights * input + bias, where weights is a row-major
+   * matrix of out_dims rows and in_dims columns.
+   */
+  void (*affine)(const uint8_t* input, const int8_t* weights,
+                 const int32_t* bias, int32_t* output, int in_dims,
+                 int out_dims);
+};
+
+/**
+ * Returns the portable kernels, which work on every CPU.
+ */
+const Kernels& ScalarKernels();
+
+/**
+ * Returns the SSE4.1 kernels, or nullptr if the CPU doesn't support them.
+ */
+const Kernels* Sse41Kernels();
+
+/**
+ * Returns the AVX2 kernels, or nullptr if the CPU doesn't support them.
+ */
+const Kernels* Avx2Kernels();
+
+/**
+ * Returns the fastest kernels supported by the CPU.
+ */
+const Kernels& BestKernels();
+
+}  // namespace apollo::nnue
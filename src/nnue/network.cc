@@ -0,0 +1,242 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+#include "log.h"
+#include "nnue/network.h"
+#include "position.h"
+
+namespace apollo::nnue {
+
+namespace {
+
+const char kMagic[4] = {'A', 'P', 'N', 'N'};
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = 16;
+
+// The hidden layers multiply by weights scaled up by 2^6; the output layer is
+// scaled up by 16 from centipawns.
+const int kWeightScaleBits = 6;
+const int kOutputScale = 16;
+
+uint32_t ReadU32(const uint8_t* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+size_t ExpectedSize(size_t hidden) {
+  return kHeaderSize + sizeof(int16_t) * hidden +
+         sizeof(int16_t) * kInputDimensions * hidden +
+         sizeof(int32_t) * kLayerDimensions +
+         sizeof(int8_t) * kLayerDimensions * 2 * hidden +
+         sizeof(int32_t) * kLayerDimensions +
+         sizeof(int8_t) * kLayerDimensions * kLayerDimensions +
+         sizeof(int32_t) + sizeof(int8_t) * kLayerDimensions;
+}
+
+/**
+ * Returns the HalfKP feature index of a piece on a square, from the point of
+ * view of the given perspective whose king is on the given square. Black's
+ * perspective sees the board flipped vertically, so that both sides see their
+ * own pieces moving up the board.
+ */
+int FeatureIndex(Color perspective, Square king, Square sq, Piece piece) {
+  int flip = perspective == kWhite ? 0 : 56;
+  int oriented_king = static_cast<int>(king) ^ flip;
+  int oriented_sq = static_cast<int>(sq) ^ flip;
+  int piece_index = static_cast<int>(piece.kind()) * 2 +
+                    (piece.color() == perspective ? 0 : 1);
+  return 1 + oriented_sq + piece_index * 64 + oriented_king * 641;
+}
+
+void ClippedRelu(const int32_t* input, uint8_t* output, int dims) {
+  for (int i = 0; i < dims; i++) {
+    output[i] = static_cast<uint8_t>(
+        std::clamp(input[i] >> kWeightScaleBits, 0, 127));
+  }
+}
+
+}  // anonymous namespace
+
+std::unique_ptr<Network> Network::Load(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw NetworkLoadException(kNetworkOpenFailed);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+    close(fd);
+    throw NetworkLoadException(kNetworkBadSize);
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    throw NetworkLoadException(kNetworkMapFailed);
+  }
+
+  // Every error from here on has to unmap the file.
+  const uint8_t* data = static_cast<const uint8_t*>(mapping);
+  auto fail = [&](NetworkLoadError err) {
+    munmap(mapping, size);
+    throw NetworkLoadException(err);
+  };
+
+  if (std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+    fail(kNetworkBadMagic);
+  }
+  if (ReadU32(data + 4) != kVersion) {
+    fail(kNetworkBadVersion);
+  }
+  uint32_t hidden = ReadU32(data + 8);
+  if (hidden == 0 || hidden % 32 != 0 || hidden > kMaxHiddenDimensions) {
+    fail(kNetworkBadDimensions);
+  }
+  if (size != ExpectedSize(hidden)) {
+    fail(kNetworkBadSize);
+  }
+
+  return std::unique_ptr<Network>(
+      new Network(data, size, static_cast<int>(hidden)));
+}
+
+Network::Network(const uint8_t* data, size_t size, int hidden)
+    : data_(data), size_(size), hidden_(hidden), kernels_(&BestKernels()) {
+  // The file is mapped at a page boundary and every section is a multiple of
+  // four bytes long, so each section is suitably aligned for its type.
+  const uint8_t* cursor = data + kHeaderSize;
+  auto take = [&](auto*& section, size_t count) {
+    using T = std::remove_const_t<std::remove_reference_t<decltype(*section)>>;
+    section = reinterpret_cast<const T*>(cursor);
+    cursor += sizeof(T) * count;
+  };
+
+  take(input_biases_, hidden_);
+  take(input_weights_, static_cast<size_t>(kInputDimensions) * hidden_);
+  take(hidden1_biases_, kLayerDimensions);
+  take(hidden1_weights_, kLayerDimensions * 2 * hidden_);
+  take(hidden2_biases_, kLayerDimensions);
+  take(hidden2_weights_, kLayerDimensions * kLayerDimensions);
+  take(output_bias_, 1);
+  take(output_weights_, kLayerDimensions);
+  CHECK(cursor == data_ + size_) << "network sections don't cover the file";
+}
+
+Network::~Network() {
+  munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+void Network::Refresh(const Position& pos, Accumulator& acc) const {
+  RefreshPerspective(pos, acc, kWhite);
+  RefreshPerspective(pos, acc, kBlack);
+}
+
+void Network::RefreshDirty(const Position& pos, Accumulator& acc) const {
+  for (Color perspective : kColors) {
+    if (acc.dirty[perspective]) {
+      RefreshPerspective(pos, acc, perspective);
+    }
+  }
+}
+
+void Network::RefreshPerspective(const Position& pos, Accumulator& acc,
+                                 Color perspective) const {
+  int16_t* values = acc.values[perspective].data();
+  std::copy(input_biases_, input_biases_ + hidden_, values);
+  acc.dirty[perspective] = false;
+
+  Bitboard king = pos.Kings(perspective);
+  if (king.Empty()) {
+    // Without a king there are no features, which is only possible in
+    // positions that were set up by hand.
+    return;
+  }
+
+  Square king_sq = king.Iterator().Next();
+  for (Color color : kColors) {
+    for (PieceKind kind : kPieces) {
+      if (kind == kKing) {
+        continue;
+      }
+
+      Piece piece(color, kind);
+      pos.Pieces(color, kind).ForEach([&](Square sq) {
+        int feature = FeatureIndex(perspective, king_sq, sq, piece);
+        kernels_->add_column(values, Column(feature), hidden_);
+      });
+    }
+  }
+}
+
+void Network::UpdatePiece(const Position& pos, Accumulator& acc, Square sq,
+                          Piece piece, bool added) const {
+  if (piece.kind() == kKing) {
+    // Kings aren't features themselves, but moving a king changes every
+    // feature of its own perspective.
+    acc.dirty[piece.color()] = true;
+    return;
+  }
+
+  for (Color perspective : kColors) {
+    if (acc.dirty[perspective]) {
+      continue;
+    }
+
+    Bitboard king = pos.Kings(perspective);
+    if (king.Empty()) {
+      acc.dirty[perspective] = true;
+      continue;
+    }
+
+    int feature =
+        FeatureIndex(perspective, king.Iterator().Next(), sq, piece);
+    int16_t* values = acc.values[perspective].data();
+    if (added) {
+      kernels_->add_column(values, Column(feature), hidden_);
+    } else {
+      kernels_->sub_column(values, Column(feature), hidden_);
+    }
+  }
+}
+
+int Network::Evaluate(const Position& pos, const Kernels& kernels) const {
+  Accumulator scratch;
+  const Accumulator* acc;
+  if (pos.AttachedNetwork() == this) {
+    acc = &pos.NnueAccumulator();
+  } else {
+    Refresh(pos, scratch);
+    acc = &scratch;
+  }
+
+  Color us = pos.SideToMove();
+  alignas(32) uint8_t transformed[2 * kMaxHiddenDimensions];
+  kernels.transform(acc->values[us].data(), transformed, hidden_);
+  kernels.transform(acc->values[!us].data(), transformed + hidden_, hidden_);
+
+  alignas(32) int32_t hidden1[kLayerDimensions];
+  alignas(32) uint8_t hidden1_out[kLayerDimensions];
+  kernels.affine(transformed, hidden1_weights_, hidden1_biases_, hidden1,
+                 2 * hidden_, kLayerDimensions);
+  ClippedRelu(hidden1, hidden1_out, kLayerDimensions);
+
+  alignas(32) int32_t hidden2[kLayerDimensions];
+  alignas(32) uint8_t hidden2_out[kLayerDimensions];
+  kernels.affine(hidden1_out, hidden2_weights_, hidden2_biases_, hidden2,
+                 kLayerDimensions, kLayerDimensions);
+  ClippedRelu(hidden2, hidden2_out, kLayerDimensions);
+
+  int32_t output;
+  kernels.affine(hidden2_out, output_weights_, output_bias_, &output,
+                 kLayerDimensions, 1);
+  return output / kOutputScale;
+}
+
+}  // namespace apollo::nnue
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "nnue/accumulator.h"
+#include "nnue/kernels.h"
+#include "piece.h"
+#include "types.h"
+
+namespace apollo {
+
+class Position;
+
+}  // namespace apollo
+
+namespace apollo::nnue {
+
+/**
+ * The number of HalfKP input features per perspective: one for every
+ * combination of king square, non-king piece and square that piece stands
+ * on, plus one unused feature per king square kept for compatibility with the
+ * classic HalfKP layout.
+ */
+constexpr int kInputDimensions = 64 * 641;
+
+/**
+ * The width of the two hidden layers that follow the first layer.
+ */
+constexpr int kLayerDimensions = 32;
+
+enum NetworkLoadError {
+  kNetworkOpenFailed = 1,
+  kNetworkMapFailed,
+  kNetworkBadMagic,
+  kNetworkBadVersion,
+  kNetworkBadDimensions,
+  kNetworkBadSize,
+};
+
+class NetworkLoadException : std::exception {
+ public:
+  explicit NetworkLoadException(NetworkLoadError err) : err_(err) {}
+
+  const char* what() const noexcept override { return "invalid network"; }
+
+  NetworkLoadError Error() const { return err_; }
+
+ private:
+  NetworkLoadError err_;
+};
+
+/**
+ * A Network is a HalfKP-style efficiently updatable neural network. It has
+ * four layers:
+ *
+ *   1. A sparse first layer of int16 weights, mapping the 41024 HalfKP
+ *      features of each perspective to N values. Its output is kept in an
+ *      Accumulator and updated incrementally as pieces move.
+ *   2. A dense layer of int8 weights from the 2N clamped accumulator values
+ *      (side to move first) to 32 values.
+ *   3. A dense layer of int8 weights from 32 values to 32 values.
+ *   4. A dense layer of int8 weights from 32 values to the output.
+ *
+ * Networks are read-only and are mapped directly from their file, so loading
+ * a network is cheap no matter its size. The file is laid out as:
+ *
+ *   char    magic[4] = "APNN"
+ *   uint32  version = 1
+ *   uint32  N, a multiple of 32 no larger than kMaxHiddenDimensions
+ *   uint32  reserved
+ *   int16   first layer biases[N]
+ *   int16   first layer weights[kInputDimensions][N]
+ *   int32   second layer biases[32]
+ *   int8    second layer weights[32][2N]
+ *   int32   third layer biases[32]
+ *   int8    third layer weights[32][32]
+ *   int32   output bias
+ *   int8    output weights[32]
+ *
+ * with all values little-endian.
+ */
+class Network {
+ public:
+  /**
+   * Maps and validates the network stored in the file at the given path.
+   * Throws NetworkLoadException if the file isn't a valid network.
+   */
+  static std::unique_ptr<Network> Load(const std::string& path);
+
+  ~Network();
+
+  Network(const Network&) = delete;
+  Network& operator=(const Network&) = delete;
+
+  /**
+   * Returns the size of the first layer, per perspective.
+   */
+  int HiddenDimensions() const { return hidden_; }
+
+  /**
+   * Returns the kernels that this network uses for inference.
+   */
+  const Kernels& InferenceKernels() const { return *kernels_; }
+
+  /**
+   * Recomputes both perspectives of an accumulator from scratch.
+   */
+  void Refresh(const Position& pos, Accumulator& acc) const;
+
+  /**
+   * Recomputes the perspectives of an accumulator that are dirty.
+   */
+  void RefreshDirty(const Position& pos, Accumulator& acc) const;
+
+  /**
+   * Updates an accumulator for a piece that has just been added to or removed
+   * from the given square. The position must already reflect the change.
+   */
+  void UpdatePiece(const Position& pos, Accumulator& acc, Square sq,
+                   Piece piece, bool added) const;
+
+  /**
+   * Evaluates a position, returning a score in centipawns from the point of
+   * view of the side to move. If this network is attached to the position,
+   * the position's accumulator is used; otherwise it is computed from
+   * scratch.
+   */
+  int Evaluate(const Position& pos) const { return Evaluate(pos, *kernels_); }
+
+  /**
+   * Evaluates a position using the given kernels.
+   */
+  int Evaluate(const Position& pos, const Kernels& kernels) const;
+
+ private:
+  Network(const uint8_t* data, size_t size, int hidden);
+
+  void RefreshPerspective(const Position& pos, Accumulator& acc,
+                          Color perspective) const;
+
+  const int16_t* Column(int feature) const {
+    return input_weights_ + static_cast<size_t>(feature) * hidden_;
+  }
+
+  const uint8_t* data_;
+  size_t size_;
+  int hidden_;
+  const Kernels* kernels_;
+
+  const int16_t* input_biases_;
+  const int16_t* input_weights_;
+  const int32_t* hidden1_biases_;
+  const int8_t* hidden1_weights_;
+  const int32_t* hidden2_biases_;
+  const int8_t* hidden2_weights_;
+  const int32_t* output_bias_;
+  const int8_t* output_weights_;
+};
+
+}  // namespace apollo::nnue
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "evaluators/nnue_evaluator.h"
+#include "move.h"
+#include "nnue/kernels.h"
+#include "nnue/network.h"
+#include "position.h"
+
+using apollo::Move;
+using apollo::Position;
+using apollo::nnue::Accumulator;
+using apollo::nnue::Kernels;
+using apollo::nnue::Network;
+using apollo::nnue::NetworkLoadException;
+
+namespace {
+
+const int kTestHiddenDimensions = 32;
+
+const char* const kTestPositions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+};
+
+/**
+ * Writes a tiny network with deterministic pseudo-random weights. The weights
+ * are meaningless, but they exercise every part of inference and are small
+ * enough to generate for every test run instead of being checked in.
+ */
+class TestNetworkWriter {
+ public:
+  explicit TestNetworkWriter(uint64_t seed) : state_(seed) {}
+
+  void Write(const std::string& path, int hidden) {
+    std::ofstream out(path, std::ios::binary);
+    out.write("APNN", 4);
+    Put<uint32_t>(out, 1);
+    Put<uint32_t>(out, static_cast<uint32_t>(hidden));
+    Put<uint32_t>(out, 0);
+    PutRandom<int16_t>(out, hidden, 64);
+    PutRandom<int16_t>(
+        out, static_cast<size_t>(apollo::nnue::kInputDimensions) * hidden, 32);
+    PutRandom<int32_t>(out, apollo::nnue::kLayerDimensions, 2048);
+    PutRandom<int8_t>(out, apollo::nnue::kLayerDimensions * 2 * hidden, 64);
+    PutRandom<int32_t>(out, apollo::nnue::kLayerDimensions, 2048);
+    PutRandom<int8_t>(out, apollo::nnue::kLayerDimensions *
+                               apollo::nnue::kLayerDimensions,
+                      64);
+    PutRandom<int32_t>(out, 1, 2048);
+    PutRandom<int8_t>(out, apollo::nnue::kLayerDimensions, 64);
+  }
+
+ private:
+  template <typename T>
+  void Put(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template <typename T>
+  void PutRandom(std::ofstream& out, size_t count, int magnitude) {
+    std::vector<T> values(count);
+    for (T& value : values) {
+      value = static_cast<T>(static_cast<int>(Next() % (2 * magnitude + 1)) -
+                             magnitude);
+    }
+    out.write(reinterpret_cast<const char*>(values.data()),
+              sizeof(T) * values.size());
+  }
+
+  uint64_t Next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 7;
+    state_ ^= state_ << 17;
+    return state_;
+  }
+
+  uint64_t state_;
+};
+
+class NnueTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    path_ = new std::string(
+        (std::filesystem::temp_directory_path() / "apollo_nnue_test.nnue")
+            .string());
+    TestNetworkWriter(0x5eed).Write(*path_, kTestHiddenDimensions);
+  }
+
+  static void TearDownTestCase() {
+    std::filesystem::remove(*path_);
+    delete path_;
+    path_ = nullptr;
+  }
+
+  static std::string* path_;
+};
+
+std::string* NnueTest::path_ = nullptr;
+
+void ExpectAccumulatorsEqual(const Accumulator& expected,
+                             const Accumulator& actual, int hidden) {
+  for (apollo::Color color : apollo::kColors) {
+    ASSERT_FALSE(actual.dirty[color]);
+    for (int i = 0; i < hidden; i++) {
+      ASSERT_EQ(expected.values[color][i], actual.values[color][i]);
+    }
+  }
+}
+
+void WalkAndCompare(const Network& network, Position& pos, int depth) {
+  Accumulator fresh;
+  network.Refresh(pos, fresh);
+  ExpectAccumulatorsEqual(fresh, pos.NnueAccumulator(),
+                          network.HiddenDimensions());
+  if (depth == 0) {
+    return;
+  }
+
+  for (Move mov : pos.PseudolegalMoves()) {
+    pos.MakeMove(mov);
+    WalkAndCompare(network, pos, depth - 1);
+    pos.UnmakeMove();
+  }
+}
+
+}  // anonymous namespace
+
+TEST_F(NnueTest, LoadsTestNetwork) {
+  auto network = Network::Load(*path_);
+  ASSERT_EQ(kTestHiddenDimensions, network->HiddenDimensions());
+}
+
+TEST_F(NnueTest, RejectsMissingFile) {
+  ASSERT_THROW(Network::Load(*path_ + ".missing"), NetworkLoadException);
+}
+
+TEST_F(NnueTest, RejectsTruncatedFile) {
+  std::string truncated = *path_ + ".truncated";
+  std::filesystem::copy_file(
+      *path_, truncated, std::filesystem::copy_options::overwrite_existing);
+  std::filesystem::resize_file(truncated,
+                               std::filesystem::file_size(truncated) - 1);
+  try {
+    Network::Load(truncated);
+    FAIL() << "expected truncated network to be rejected";
+  } catch (const NetworkLoadException& exn) {
+    ASSERT_EQ(apollo::nnue::kNetworkBadSize, exn.Error());
+  }
+  std::filesystem::remove(truncated);
+}
+
+TEST_F(NnueTest, IncrementalMatchesRefresh) {
+  auto network = Network::Load(*path_);
+  for (const char* fen : kTestPositions) {
+    Position pos(fen);
+    pos.AttachNetwork(network.get());
+    WalkAndCompare(*network, pos, 2);
+  }
+}
+
+TEST_F(NnueTest, AttachAfterMoves) {
+  auto network = Network::Load(*path_);
+  Position pos;
+  pos.MakeMove(Move::DoublePawnPush(apollo::E2, apollo::E4));
+  pos.AttachNetwork(network.get());
+  int attached_eval = network->Evaluate(pos);
+  pos.UnmakeMove();
+
+  Position start;
+  ASSERT_EQ(network->Evaluate(start), network->Evaluate(pos));
+  pos.MakeMove(Move::DoublePawnPush(apollo::E2, apollo::E4));
+  ASSERT_EQ(attached_eval, network->Evaluate(pos));
+}
+
+TEST_F(NnueTest, KernelsAgree) {
+  auto network = Network::Load(*path_);
+  std::vector<const Kernels*> kernels = {&apollo::nnue::ScalarKernels()};
+  if (const Kernels* sse41 = apollo::nnue::Sse41Kernels()) {
+    kernels.push_back(sse41);
+  }
+  if (const Kernels* avx2 = apollo::nnue::Avx2Kernels()) {
+    kernels.push_back(avx2);
+  }
+
+  std::vector<int> scores;
+  for (const char* fen : kTestPositions) {
+    Position pos(fen);
+    int expected = network->Evaluate(pos, apollo::nnue::ScalarKernels());
+    for (const Kernels* k : kernels) {
+      ASSERT_EQ(expected, network->Evaluate(pos, *k)) << k->name << " " << fen;
+    }
+    scores.push_back(expected);
+  }
+
+  // A network whose output is saturated would agree trivially.
+  std::sort(scores.begin(), scores.end());
+  ASSERT_NE(scores.front(), scores.back());
+}
+
+TEST_F(NnueTest, EvaluatorScoresFromWhite) {
+  auto network = Network::Load(*path_);
+  const Network* raw = network.get();
+  apollo::evaluators::NnueEvaluator evaluator(std::move(network));
+  Position pos(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq -");
+  ASSERT_DOUBLE_EQ(-raw->Evaluate(pos) / 100.0, evaluator.Evaluate(pos));
+}
@@ -41,6 +41,12 @@ class Piece {
     }
   }
 
+  /**
+   * Constructs a black pawn, as a placeholder in arrays of pieces that are
+   * filled in later.
+   */
+  Piece() : color_(0), piece_(0) {}
+
   Piece(Color color, PieceKind kind) {
     this->color_ = color == kWhite ? 1 : 0;
     this->piece_ = static_cast<int>(kind);
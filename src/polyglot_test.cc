@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "book/polyglot.h"
+#include "move.h"
+#include "position.h"
+
+using apollo::Move;
+using apollo::Position;
+using apollo::book::BookMove;
+using apollo::book::PolyglotBook;
+using apollo::book::PolyglotKey;
+using apollo::book::PolyglotMove;
+
+namespace {
+
+struct Entry {
+  uint64_t key;
+  uint16_t move;
+  uint16_t weight;
+};
+
+void WriteBigEndian(std::ofstream& out, uint64_t value, int bytes) {
+  for (int i = bytes - 1; i >= 0; i--) {
+    out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+void WriteBook(const std::string& path, std::vector<Entry> entries) {
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.key < b.key; });
+  std::ofstream out(path, std::ios::binary);
+  for (const Entry& entry : entries) {
+    WriteBigEndian(out, entry.key, 8);
+    WriteBigEndian(out, entry.move, 2);
+    WriteBigEndian(out, entry.weight, 2);
+    WriteBigEndian(out, 0, 4);
+  }
+}
+
+Entry MakeEntry(const Position& pos, const char* uci, uint16_t weight) {
+  return {PolyglotKey(pos), PolyglotMove(*pos.MoveFromUci(uci)), weight};
+}
+
+}  // anonymous namespace
+
+// The reference keys published with the Polyglot book format.
+TEST(PolyglotKeyTest, ReferenceKeys) {
+  struct KeyCase {
+    std::vector<const char*> moves;
+    uint64_t key;
+  };
+  std::vector<KeyCase> cases = {
+      {{}, 0x463b96181691fc9c},
+      {{"e2e4"}, 0x823c9b50fd114196},
+      {{"e2e4", "d7d5"}, 0x0756b94461c50fb0},
+      {{"e2e4", "d7d5", "e4e5"}, 0x662fafb965db29d4},
+      {{"e2e4", "d7d5", "e4e5", "f7f5"}, 0x22a48b5a8e47ff78},
+      {{"e2e4", "d7d5", "e4e5", "f7f5", "e1e2"}, 0x652a607ca3f242c1},
+      {{"e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7"}, 0x00fdd303c946bdd9},
+      {{"a2a4", "b7b5", "h2h4", "b5b4", "c2c4"}, 0x3c8123ea7b067637},
+      {{"a2a4", "b7b5", "h2h4", "b5b4", "c2c4", "b4c3", "a1a3"},
+       0x5c3f9b829b279560},
+  };
+  for (const auto& [moves, key] : cases) {
+    Position pos;
+    for (const char* uci : moves) {
+      pos.MakeMove(*pos.MoveFromUci(uci));
+    }
+    ASSERT_EQ(key, PolyglotKey(pos)) << pos.AsFen();
+  }
+}
+
+TEST(PolyglotKeyTest, Transpositions) {
+  Position a;
+  for (const char* uci : {"g1f3", "g8f6", "b1c3"}) {
+    a.MakeMove(*a.MoveFromUci(uci));
+  }
+  Position b;
+  for (const char* uci : {"b1c3", "g8f6", "g1f3"}) {
+    b.MakeMove(*b.MoveFromUci(uci));
+  }
+  ASSERT_EQ(PolyglotKey(a), PolyglotKey(b));
+  ASSERT_NE(PolyglotKey(a), PolyglotKey(Position()));
+}
+
+TEST(PolyglotKeyTest, EnPassantOnlyCountsWhenCapturable) {
+  // No white pawn can take on d6, so the square doesn't count.
+  ASSERT_EQ(
+      PolyglotKey(Position(
+          "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2")),
+      PolyglotKey(Position(
+          "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 2")));
+  ASSERT_NE(
+      PolyglotKey(Position(
+          "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3")),
+      PolyglotKey(Position(
+          "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq - 0 3")));
+}
+
+TEST(PolyglotMoveTest, Encoding) {
+  Position pos;
+  // e2e4: to e4 (28), from e2 (12).
+  ASSERT_EQ(28 | 12 << 6, PolyglotMove(*pos.MoveFromUci("e2e4")));
+
+  Position castle("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  ASSERT_EQ(7 | 4 << 6, PolyglotMove(*castle.MoveFromUci("e1g1")));
+  ASSERT_EQ(0 | 4 << 6, PolyglotMove(*castle.MoveFromUci("e1c1")));
+
+  Position promotion("8/P6k/8/8/8/8/8/K7 w - - 0 1");
+  ASSERT_EQ(56 | 48 << 6 | 4 << 12,
+            PolyglotMove(*promotion.MoveFromUci("a7a8q")));
+}
+
+class PolyglotBookTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ =
+        (std::filesystem::temp_directory_path() / "apollo_polyglot_test.bin")
+            .string();
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::string path_;
+};
+
+TEST_F(PolyglotBookTest, ProbeAndPick) {
+  Position start;
+  Position castle("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  Position after_e4;
+  after_e4.MakeMove(*after_e4.MoveFromUci("e2e4"));
+  WriteBook(path_, {
+                       MakeEntry(start, "d2d4", 1),
+                       MakeEntry(start, "e2e4", 3),
+                       MakeEntry(after_e4, "c7c5", 5),
+                       MakeEntry(castle, "e1g1", 1),
+                   });
+
+  auto book = PolyglotBook::Open(path_);
+  ASSERT_EQ(4, book->Size());
+
+  std::vector<BookMove> moves = book->Probe(start);
+  ASSERT_EQ(2, moves.size());
+  ASSERT_EQ("e2e4", moves[0].move.AsUci());
+  ASSERT_EQ(3, moves[0].weight);
+  ASSERT_EQ("d2d4", moves[1].move.AsUci());
+
+  // Weights of 3 and 1 split the random numbers 3 to 1.
+  ASSERT_EQ("e2e4", book->Pick(start, 0)->AsUci());
+  ASSERT_EQ("e2e4", book->Pick(start, 2)->AsUci());
+  ASSERT_EQ("d2d4", book->Pick(start, 3)->AsUci());
+
+  ASSERT_EQ("c7c5", book->Pick(after_e4, 12345)->AsUci());
+
+  std::optional<Move> castle_move = book->Pick(castle, 0);
+  ASSERT_TRUE(castle_move.has_value());
+  ASSERT_TRUE(castle_move->IsKingsideCastle());
+
+  Position out_of_book("8/8/4k3/8/8/8/8/4K3 w - - 0 1");
+  ASSERT_TRUE(book->Probe(out_of_book).empty());
+  ASSERT_FALSE(book->Pick(out_of_book, 0).has_value());
+}
+
+TEST_F(PolyglotBookTest, RejectsBadFiles) {
+  std::ofstream(path_, std::ios::binary) << "not a book";
+  ASSERT_THROW(PolyglotBook::Open(path_), apollo::book::BookLoadException);
+  ASSERT_THROW(PolyglotBook::Open(path_ + ".missing"),
+               apollo::book::BookLoadException);
+}
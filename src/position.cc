@@ -1,13 +1,16 @@
+#include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstring>
 #include <optional>
-#include <sstream>
 #include <string>
-#include <unordered_set>
 
 #include "attacks.h"
 #include "movegen.h"
+#include "nnue/network.h"
 #include "piece.h"
 #include "position.h"
+#include "psqt.h"
 #include "util.h"
 #include "zobrist.h"
 
@@ -15,7 +18,8 @@ namespace apollo {
 
 class FenParser {
  public:
-  FenParser(std::string_view fen) : it_(fen.cbegin()), end_(fen.cend()) {}
+  FenParser(std::string_view fen)
+      : it_(fen.data()), end_(fen.data() + fen.size()) {}
 
   void Parse(Position& pos) {
     for (int rank = kRank8; rank >= kRank1; rank--) {
@@ -120,34 +124,15 @@ class FenParser {
     }
 
     if (!PeekEof()) {
+      // The clocks are optional.
+      pos.current_state_.zobrist_hash_ = zobrist::Hash(pos);
       return;
     }
 
     Eat(' ');
-    // Halfmove Clock
-    std::stringstream halfmove_stream;
-    while (true) {
-      char c = Peek();
-      if (!std::isdigit(c)) {
-        break;
-      }
-      halfmove_stream << c;
-      Advance();
-    }
-    pos.current_state_.halfmove_clock = std::stoi(halfmove_stream.str());
-
+    pos.current_state_.halfmove_clock = ParseClock();
     Eat(' ');
-    // Fullmove Clock
-    std::stringstream fullmove_stream;
-    while (true) {
-      auto c = PeekEof();
-      if (!c || !std::isdigit(*c)) {
-        break;
-      }
-      fullmove_stream << *c;
-      Advance();
-    }
-    pos.current_state_.fullmove_clock = std::stoi(fullmove_stream.str());
+    pos.current_state_.fullmove_clock = ParseClock();
     pos.current_state_.zobrist_hash_ = zobrist::Hash(pos);
   }
 
@@ -177,18 +162,36 @@ class FenParser {
 
   void Advance() { it_++; }
 
-  std::string_view::const_iterator it_;
-  std::string_view::const_iterator end_;
+  int ParseClock() {
+    int value = 0;
+    auto [next, err] = std::from_chars(it_, end_, value);
+    if (err != std::errc() || value < 0) {
+      throw InvalidFenException(kUnexpectedChar);
+    }
+    it_ = next;
+    return value;
+  }
+
+  const char* it_;
+  const char* end_;
 };
 
-Position::Position(std::string_view fen)
+Position::Position(EmptyBoard)
     : current_state_(),
       irreversible_state_(),
       boards_by_piece_(),
       boards_by_color_(),
-      side_to_move_(kWhite) {
+      side_to_move_(kWhite),
+      midgame_score_(0),
+      endgame_score_(0),
+      phase_(0),
+      network_(nullptr),
+      accumulators_() {}
+
+Position::Position(std::string_view fen) : Position(EmptyBoard{}) {
   FenParser parser(fen);
   parser.Parse(*this);
+  UpdateCheckInfo();
 }
 
 void Position::AddPiece(Square sq, Piece piece) {
@@ -198,6 +201,12 @@ void Position::AddPiece(Square sq, Piece piece) {
   size_t kind = static_cast<size_t>(piece.kind());
   this->boards_by_piece_[kind + offset].Set(sq);
   zobrist::ModifyPiece(current_state_.zobrist_hash_, sq, piece);
+  this->midgame_score_ += psqt::Midgame(piece, sq);
+  this->endgame_score_ += psqt::Endgame(piece, sq);
+  this->phase_ += psqt::Phase(piece.kind());
+  if (network_) {
+    network_->UpdatePiece(*this, accumulators_.back(), sq, piece, true);
+  }
 }
 
 void Position::RemovePiece(Square sq) {
@@ -208,6 +217,13 @@ void Position::RemovePiece(Square sq) {
   size_t kind = static_cast<size_t>(existing_piece->kind());
   this->boards_by_piece_[kind + offset].Unset(sq);
   zobrist::ModifyPiece(current_state_.zobrist_hash_, sq, *existing_piece);
+  this->midgame_score_ -= psqt::Midgame(*existing_piece, sq);
+  this->endgame_score_ -= psqt::Endgame(*existing_piece, sq);
+  this->phase_ -= psqt::Phase(existing_piece->kind());
+  if (network_) {
+    network_->UpdatePiece(*this, accumulators_.back(), sq, *existing_piece,
+                          false);
+  }
 }
 
 std::optional<Piece> Position::PieceAt(Square sq) const {
@@ -233,47 +249,33 @@ std::optional<Piece> Position::PieceAt(Square sq) const {
   __builtin_unreachable();
 }
 
+Bitboard Position::AttackersTo(Square target, Bitboard occupancy) const {
+  // Attacks are symmetric: a piece attacks the target exactly when the same
+  // kind of piece standing on the target would attack it. Pawns are the
+  // exception, since they attack in the direction they move, so look up the
+  // pawn attacks of the opposite color.
+  Bitboard rooks = Rooks(kWhite) | Rooks(kBlack);
+  Bitboard bishops = Bishops(kWhite) | Bishops(kBlack);
+  Bitboard queens = Queens(kWhite) | Queens(kBlack);
+  return (attacks::RookAttacks(target, occupancy) & (rooks | queens)) |
+         (attacks::BishopAttacks(target, occupancy) & (bishops | queens)) |
+         (attacks::KnightAttacks(target) &
+          (Knights(kWhite) | Knights(kBlack))) |
+         (attacks::KingAttacks(target) & (Kings(kWhite) | Kings(kBlack))) |
+         (attacks::PawnAttacks(target, kWhite) & Pawns(kBlack)) |
+         (attacks::PawnAttacks(target, kBlack) & Pawns(kWhite));
+}
+
 Bitboard Position::SquaresAttacking(Color to_move, Square target) const {
   Bitboard occupancy = Pieces(kWhite) | Pieces(kBlack);
-  Bitboard attacks;
-  Queens(to_move).ForEach([&](Square queen) {
-    if (attacks::QueenAttacks(queen, occupancy).Test(target)) {
-      attacks.Set(queen);
-    }
-  });
-  Rooks(to_move).ForEach([&](Square rook) {
-    if (attacks::RookAttacks(rook, occupancy).Test(target)) {
-      attacks.Set(rook);
-    }
-  });
-  Bishops(to_move).ForEach([&](Square bishop) {
-    if (attacks::BishopAttacks(bishop, occupancy).Test(target)) {
-      attacks.Set(bishop);
-    }
-  });
-  Knights(to_move).ForEach([&](Square knight) {
-    if (attacks::KnightAttacks(knight).Test(target)) {
-      attacks.Set(knight);
-    }
-  });
-  Pawns(to_move).ForEach([&](Square pawn) {
-    if (attacks::PawnAttacks(pawn, to_move).Test(target)) {
-      attacks.Set(pawn);
-    }
-  });
-  Kings(to_move).ForEach([&](Square king) {
-    if (attacks::KingAttacks(king).Test(target)) {
-      attacks.Set(king);
-    }
-  });
-  if (current_state_.en_passant_square &&
-      target == *current_state_.en_passant_square) {
-    // TODO(sean)
-  }
-  return attacks;
+  return AttackersTo(target, occupancy) & Pieces(to_move);
 }
 
 bool Position::IsCheck(Color to_move) const {
+  if (to_move == side_to_move_) {
+    return !current_state_.checkers.Empty();
+  }
+
   bool check = false;
   Kings(to_move).ForEach([&](Square king) {
     if (!SquaresAttacking(!to_move, king).Empty()) {
@@ -299,68 +301,254 @@ bool Position::IsAbsolutelyPinned(Color to_move, Square sq) const {
     return false;
   }
 
-  Bitboard attacks_on_square = SquaresAttacking(to_move, sq);
-  if (attacks_on_square.Empty()) {
-    // Nobody is attacking this square? Not a pin.
+  Bitboard kings = Kings(!to_move);
+  if (kings.Empty()) {
     return false;
   }
 
-  Bitboard kings = Kings(!to_move);
-  Bitboard all_pieces_except_pin = Pieces(kWhite) | Pieces(kBlack);
-  all_pieces_except_pin.Unset(sq);
-  for (auto it = attacks_on_square.Iterator(); it.HasNext();) {
-    Square attacker = it.Next();
-    Piece piece = PieceAt(attacker).value();
-    switch (piece.kind()) {
-      case kPawn:
-      case kKnight:
-      case kKing:
-        // Pawns, knights, and kings can't participate in pins.
-        continue;
-      case kBishop:
-        if (!(attacks::BishopAttacks(attacker, all_pieces_except_pin) & kings)
-                 .Empty()) {
-          TLOG() << "bishop on square " << util::SquareString(attacker)
-                 << " absolutely pins " << sq;
-          return true;
-        }
-        break;
-      case kRook:
-        if (!(attacks::RookAttacks(attacker, all_pieces_except_pin) & kings)
-                 .Empty()) {
-          TLOG() << "rook on square " << util::SquareString(attacker)
-                 << " absolutely pins " << util::SquareString(sq);
-          return true;
-        }
-        break;
-      case kQueen:
-        if (!(attacks::QueenAttacks(attacker, all_pieces_except_pin) & kings)
-                 .Empty()) {
-          TLOG() << "queen on square " << util::SquareString(attacker)
-                 << " absolutely pins " << util::SquareString(sq);
-          return true;
-        }
-        break;
-      default:
-        break;
+  // The piece is pinned if it is the only piece between its king and an
+  // enemy slider that would otherwise attack the king along their shared line.
+  Square king = kings.Iterator().Next();
+  Bitboard line = attacks::Line(king, sq);
+  Bitboard rook_pinners = attacks::RookAttacks(king, Bitboard()) &
+                          (Rooks(to_move) | Queens(to_move));
+  Bitboard bishop_pinners = attacks::BishopAttacks(king, Bitboard()) &
+                            (Bishops(to_move) | Queens(to_move));
+  Bitboard occupancy = Pieces(kWhite) | Pieces(kBlack);
+  for (auto it = ((rook_pinners | bishop_pinners) & line).Iterator();
+       it.HasNext();) {
+    Square pinner = it.Next();
+    Bitboard between = attacks::Between(king, pinner);
+    if (between.Test(sq) && (between & occupancy).Count() == 1) {
+      TLOG() << "piece on square " << util::SquareString(pinner)
+             << " absolutely pins " << util::SquareString(sq);
+      return true;
     }
   }
 
   return false;
 }
 
+Bitboard Position::SliderBlockers(Square king, Bitboard rook_sliders,
+                                  Bitboard bishop_sliders) const {
+  Bitboard occupancy = Pieces(kWhite) | Pieces(kBlack);
+  Bitboard snipers =
+      (attacks::RookAttacks(king, Bitboard()) & rook_sliders) |
+      (attacks::BishopAttacks(king, Bitboard()) & bishop_sliders);
+  Bitboard blockers;
+  snipers.ForEach([&](Square sniper) {
+    Bitboard between = attacks::Between(king, sniper) & occupancy;
+    if (between.Count() == 1) {
+      blockers = blockers | between;
+    }
+  });
+  return blockers;
+}
+
+void Position::UpdateCheckInfo() {
+  Color us = side_to_move_;
+  Color them = !us;
+  current_state_.checkers = Bitboard();
+  current_state_.pinned = Bitboard();
+  current_state_.discovered_check_candidates = Bitboard();
+
+  // Positions set up by hand may be missing kings.
+  Bitboard our_king = Kings(us);
+  if (!our_king.Empty()) {
+    Square king = our_king.Iterator().Next();
+    current_state_.checkers = SquaresAttacking(them, king);
+    current_state_.pinned =
+        SliderBlockers(king, Rooks(them) | Queens(them),
+                       Bishops(them) | Queens(them)) &
+        Pieces(us);
+  }
+
+  Bitboard their_king = Kings(them);
+  if (!their_king.Empty()) {
+    Square king = their_king.Iterator().Next();
+    current_state_.discovered_check_candidates =
+        SliderBlockers(king, Rooks(us) | Queens(us), Bishops(us) | Queens(us)) &
+        Pieces(us);
+  }
+}
+
+bool Position::GivesCheck(Move mov) const {
+  Color us = side_to_move_;
+  Bitboard their_king = Kings(!us);
+  if (their_king.Empty()) {
+    return false;
+  }
+
+  Square king = their_king.Iterator().Next();
+  Square source = mov.Source();
+  Square destination = mov.Destination();
+  auto moving_piece = PieceAt(source);
+  CHECK(moving_piece.has_value()) << "no piece at move source square";
+
+  Bitboard after = Pieces(kWhite) | Pieces(kBlack);
+  after.Unset(source);
+  after.Set(destination);
+
+  // Direct checks by the piece that moved, or the piece it promoted to.
+  PieceKind kind =
+      mov.IsPromotion() ? mov.PromotionPiece() : moving_piece->kind();
+  if (kind != kKing && Piece(us, kind).Attacks(destination, after).Test(king)) {
+    return true;
+  }
+
+  // Discovered checks by a piece moving off the line between one of our
+  // sliders and the enemy king.
+  if (current_state_.discovered_check_candidates.Test(source) &&
+      !attacks::Line(king, source).Test(destination)) {
+    return true;
+  }
+
+  if (mov.IsEnPassant()) {
+    // The captured pawn leaves the board too, which can uncover a check of
+    // its own.
+    Direction ep_dir = us == kWhite ? kDirectionSouth : kDirectionNorth;
+    after.Unset(util::Towards(destination, ep_dir));
+    return !(attacks::RookAttacks(king, after) & (Rooks(us) | Queens(us)))
+                .Empty() ||
+           !(attacks::BishopAttacks(king, after) & (Bishops(us) | Queens(us)))
+                .Empty();
+  }
+
+  if (mov.IsCastle()) {
+    // The rook is the only piece that can check after a castle.
+    Square rook, rook_target;
+    if (mov.IsKingsideCastle()) {
+      rook = util::Towards(destination, kDirectionEast);
+      rook_target = util::Towards(destination, kDirectionWest);
+    } else {
+      rook = util::Towards(util::Towards(destination, kDirectionWest),
+                           kDirectionWest);
+      rook_target = util::Towards(destination, kDirectionEast);
+    }
+    after.Unset(rook);
+    after.Set(rook_target);
+    return attacks::RookAttacks(rook_target, after).Test(king);
+  }
+
+  return false;
+}
+
 bool Position::IsLegal(Move mov) const {
-  // This is a very naive implementation of pseudo-legality, based on the fact
-  // that we know that the move generator generates pseudo legal moves.
-  std::vector<Move> pseudolegal_moves = PseudolegalMoves();
-  std::unordered_set<Move> move_set(pseudolegal_moves.begin(),
-                                    pseudolegal_moves.end());
-  if (move_set.find(mov) == move_set.end()) {
-    // Moves that are not pseudolegal are also not legal.
+  // Moves that are not pseudolegal are also not legal.
+  return IsPseudoLegal(mov) && IsLegalGivenPseudolegal(mov);
+}
+
+bool Position::IsPseudoLegal(Move mov) const {
+  // The generator never produces null moves.
+  if (mov.IsNull()) {
+    return false;
+  }
+
+  Color us = side_to_move_;
+  Square source = mov.Source();
+  Square dest = mov.Destination();
+  auto moving_piece = PieceAt(source);
+  if (!moving_piece || moving_piece->color() != us) {
+    return false;
+  }
+
+  Bitboard enemy_pieces = Pieces(!us);
+  Bitboard occupancy = Pieces(us) | enemy_pieces;
+  if (moving_piece->kind() == kPawn) {
+    Bitboard promo_rank = us == kWhite ? kBBRank8 : kBBRank1;
+    Bitboard start_rank = us == kWhite ? kBBRank2 : kBBRank7;
+    if (mov.IsPromotion() != promo_rank.Test(dest)) {
+      return false;
+    }
+
+    if (mov.IsEnPassant()) {
+      return EnPassantSquare() == dest &&
+             attacks::PawnAttacks(source, us).Test(dest);
+    }
+
+    if (mov.IsCapture()) {
+      if (!mov.IsPromotion() && !(mov == Move::Capture(source, dest))) {
+        return false;
+      }
+      return enemy_pieces.Test(dest) &&
+             attacks::PawnAttacks(source, us).Test(dest);
+    }
+
+    Bitboard from;
+    from.Set(source);
+    Bitboard empty = ~occupancy;
+    Bitboard single_push = (us == kWhite ? from << 8 : from >> 8) & empty;
+    if (mov.IsDoublePawnPush()) {
+      Bitboard double_push =
+          (us == kWhite ? single_push << 8 : single_push >> 8) & empty;
+      return start_rank.Test(source) && double_push.Test(dest);
+    }
+
+    if (!mov.IsPromotion() && !mov.IsQuiet()) {
+      return false;
+    }
+    return single_push.Test(dest);
+  }
+
+  // Only pawns promote, push two squares or capture en passant.
+  if (mov.IsPromotion() || mov.IsDoublePawnPush() || mov.IsEnPassant()) {
+    return false;
+  }
+
+  if (mov.IsCastle()) {
+    // Mirror the move generator: the king and rook are on their starting
+    // squares, the king is not in check, the squares between them are empty
+    // and the king doesn't pass through an attacked square.
+    Square king_start = us == kWhite ? Square::E1 : Square::E8;
+    if (moving_piece->kind() != kKing || source != king_start ||
+        !Checkers().Empty()) {
+      return false;
+    }
+
+    Square rook_start, king_target;
+    Bitboard empty_squares, king_path;
+    if (mov.IsKingsideCastle()) {
+      if (!CanCastleKingside(us)) {
+        return false;
+      }
+      rook_start = us == kWhite ? Square::H1 : Square::H8;
+      king_target = us == kWhite ? Square::G1 : Square::G8;
+      empty_squares = attacks::Between(source, rook_start);
+      king_path = empty_squares;
+    } else {
+      if (!CanCastleQueenside(us)) {
+        return false;
+      }
+      rook_start = us == kWhite ? Square::A1 : Square::A8;
+      king_target = us == kWhite ? Square::C1 : Square::C8;
+      empty_squares = attacks::Between(source, rook_start);
+      // The rook crosses the square next to it, but the king doesn't.
+      king_path = empty_squares;
+      king_path.Unset(util::Towards(rook_start, kDirectionEast));
+    }
+
+    auto rook = PieceAt(rook_start);
+    if (dest != king_target || !rook || rook->kind() != kRook ||
+        rook->color() != us || !(empty_squares & occupancy).Empty()) {
+      return false;
+    }
+
+    bool attacked = false;
+    king_path.ForEach([&](Square sq) {
+      attacked = attacked || !SquaresAttacking(!us, sq).Empty();
+    });
+    return !attacked;
+  }
+
+  if (mov.IsCapture()) {
+    if (!(mov == Move::Capture(source, dest)) || !enemy_pieces.Test(dest)) {
+      return false;
+    }
+  } else if (!mov.IsQuiet() || occupancy.Test(dest)) {
     return false;
   }
 
-  return IsLegalGivenPseudolegal(mov);
+  return moving_piece->Attacks(source, occupancy).Test(dest);
 }
 
 bool Position::IsLegalGivenPseudolegal(Move mov) const {
@@ -381,10 +569,10 @@ bool Position::IsLegalGivenPseudolegal(Move mov) const {
   // Therefore this function proceeds differently depending on whether or not
   // we're in check.
   Color to_move = SideToMove();
-  if (IsCheck(to_move)) {
+  Bitboard checking_pieces = Checkers();
+  if (!checking_pieces.Empty()) {
     CHECK(Kings(to_move).Count() == 1) << "expected exactly one king";
     Square king = Kings(to_move).Iterator().Next();
-    Bitboard checking_pieces = SquaresAttacking(!to_move, king);
     if (checking_pieces.Count() > 1) {
       // Double or greater check. It is only legal to move a king.
       if (moving_piece->kind() != kKing) {
@@ -398,7 +586,6 @@ bool Position::IsLegalGivenPseudolegal(Move mov) const {
       CHECK(checking_pieces.Count() == 1)
           << "should be exactly one checking piece";
       Square checking_piece_square = checking_pieces.Iterator().Next();
-      Piece checking_piece = PieceAt(checking_piece_square).value();
 
       // We're being checked by exactly one piece. There are three options
       // available to us:
@@ -406,22 +593,21 @@ bool Position::IsLegalGivenPseudolegal(Move mov) const {
       //   2. Block the checking piece.
       //   3. Move the king out of danger.
       if (moving_piece->kind() != kKing) {
-        // If we're moving to a piece other than where the checking piece
-        // resides, our intention is to block the checking piece.
-        if (mov.Destination() != checking_piece_square && !mov.IsEnPassant()) {
-          Bitboard all_pieces_with_block = Pieces(kWhite) | Pieces(kBlack);
-          all_pieces_with_block.Unset(mov.Source());
-          all_pieces_with_block.Set(mov.Destination());
-          if (checking_piece
-                  .Attacks(checking_piece_square, all_pieces_with_block)
-                  .Test(king)) {
-            return false;
-          }
-        } else if (!mov.IsEnPassant()) {
-          CHECK(mov.IsCapture())
-              << "moving to checking piece square but not a capture";
-        } else {
-          // TODO: en passant check
+        // En passant captures a piece that isn't on the destination square.
+        Square captured_square = mov.Destination();
+        if (mov.IsEnPassant()) {
+          Direction ep_dir =
+              to_move == kWhite ? kDirectionSouth : kDirectionNorth;
+          captured_square = util::Towards(mov.Destination(), ep_dir);
+        }
+
+        // If we're not capturing the checking piece, our intention is to block
+        // it, which is only possible if it's a slider and we're moving onto
+        // the line between it and the king.
+        if (!(mov.IsCapture() && captured_square == checking_piece_square) &&
+            !attacks::Between(king, checking_piece_square)
+                 .Test(mov.Destination())) {
+          return false;
         }
       }
     }
@@ -438,20 +624,45 @@ bool Position::IsLegalGivenPseudolegal(Move mov) const {
   //   rank and leaving an attack on the king.
 
   // If we're not in check, we're fine as long as we don't move into check.
-  // If this is a king move, does it move into check?
-  if (moving_piece->kind() == kKing &&
-      !SquaresAttacking(!SideToMove(), mov.Destination()).Empty()) {
-    return false;
+  // If this is a king move, does it move into check? The king has to be taken
+  // off the board first, or it would shield the squares behind it from the
+  // sliders attacking it.
+  Bitboard occupancy = Pieces(kWhite) | Pieces(kBlack);
+  if (moving_piece->kind() == kKing) {
+    Bitboard without_king = occupancy;
+    without_king.Unset(mov.Source());
+    return (AttackersTo(mov.Destination(), without_king) &
+            Pieces(!SideToMove()))
+        .Empty();
   }
 
-  // Is this piece absolutely pinned to the king?
-  if (IsAbsolutelyPinned(!SideToMove(), mov.Source())) {
+  // Is this piece absolutely pinned to the king? If so, it can still move
+  // along the line of the pin.
+  Square king = Kings(SideToMove()).Iterator().Next();
+  if (PinnedPieces().Test(mov.Source()) &&
+      !attacks::Line(king, mov.Source()).Test(mov.Destination())) {
     return false;
   }
 
-  // TODO(sean): For en-passant moves, we have to do a special check: an
-  // en-passant capture can take two pawns off a single rank, which can place
-  // the king in check if something is attacking that rank.
+  // En passant takes two pieces off the board at once, the capturing pawn
+  // and the captured one, so it can uncover an attack on the king that no
+  // single pin covers. Check for one on the board after the capture.
+  if (mov.IsEnPassant()) {
+    Direction ep_dir =
+        SideToMove() == kWhite ? kDirectionSouth : kDirectionNorth;
+    Bitboard after = occupancy;
+    after.Unset(mov.Source());
+    after.Unset(util::Towards(mov.Destination(), ep_dir));
+    after.Set(mov.Destination());
+    Color them = !SideToMove();
+    Bitboard rook_attackers = Rooks(them) | Queens(them);
+    Bitboard bishop_attackers = Bishops(them) | Queens(them);
+    if (!(attacks::RookAttacks(king, after) & rook_attackers).Empty() ||
+        !(attacks::BishopAttacks(king, after) & bishop_attackers).Empty()) {
+      return false;
+    }
+  }
+
   return true;
 }
 
@@ -465,12 +676,19 @@ void Position::MakeMove(Move mov) {
   // replay it backwards later.
   current_state_.move = mov;
   irreversible_state_.push(current_state_);
+  if (network_) {
+    // The accumulator is reversible state too, but it's much cheaper to copy
+    // it than to undo every update made to it.
+    accumulators_.push_back(accumulators_.back());
+  }
 
   if (mov.IsNull()) {
     // Quick out for null moves:
     //  1. EP is not legal next turn.
     //  2. Halfmove clock always increases.
     //  3. Fullmove clock increases if Black makes the null move.
+    zobrist::ModifyEnPassant(current_state_.zobrist_hash_,
+                             current_state_.en_passant_square, {});
     current_state_.en_passant_square = {};
     current_state_.halfmove_clock++;
     side_to_move_ = !side_to_move_;
@@ -478,9 +696,42 @@ void Position::MakeMove(Move mov) {
     if (side_to_move_ == kWhite) {
       current_state_.fullmove_clock++;
     }
+    UpdateCheckInfo();
     return;
   }
 
+  if (side_to_move_ == kWhite) {
+    MakeMoveFor<kWhite>(mov);
+  } else {
+    MakeMoveFor<kBlack>(mov);
+  }
+
+  UpdateCheckInfo();
+
+  if (network_) {
+    network_->RefreshDirty(*this, accumulators_.back());
+  }
+}
+
+template <Color Us>
+void Position::MakeMoveFor(Move mov) {
+  // Everything that depends on the side to move is resolved here at compile
+  // time.
+  constexpr Color kThem = !Us;
+  constexpr Direction kBehind =
+      Us == kWhite ? kDirectionSouth : kDirectionNorth;
+  constexpr Square kKingsideRook = Us == kWhite ? Square::H1 : Square::H8;
+  constexpr Square kQueensideRook = Us == kWhite ? Square::A1 : Square::A8;
+  constexpr Square kKingsideRookTarget =
+      Us == kWhite ? Square::F1 : Square::F8;
+  constexpr Square kQueensideRookTarget =
+      Us == kWhite ? Square::D1 : Square::D8;
+  constexpr CastleStatus kKingsideMask =
+      Us == kWhite ? kCastleWhiteKingside : kCastleBlackKingside;
+  constexpr CastleStatus kQueensideMask =
+      Us == kWhite ? kCastleWhiteQueenside : kCastleBlackQueenside;
+  constexpr CastleStatus kBothMask = Us == kWhite ? kCastleWhite : kCastleBlack;
+
   auto moving_piece = PieceAt(mov.Source());
   CHECK(moving_piece.has_value()) << "no piece at move source square";
 
@@ -489,14 +740,14 @@ void Position::MakeMove(Move mov) {
     if (mov.IsEnPassant()) {
       // En-passant moves are the only case when the piece being captured does
       // not lie on the same square as the move destination.
-      Direction ep_dir =
-          side_to_move_ == kWhite ? kDirectionSouth : kDirectionNorth;
       CHECK(current_state_.en_passant_square) << "EP-move without EP-square";
-      target_square = util::Towards(*current_state_.en_passant_square, ep_dir);
+      target_square =
+          util::Towards(*current_state_.en_passant_square, kBehind);
     }
 
     auto captured_piece = PieceAt(target_square);
-    CHECK(captured_piece.has_value()) << "no piece at capture square";
+    CHECK(captured_piece.has_value() && captured_piece->color() == kThem)
+        << "no enemy piece at capture square";
 
     // Record the captured piece in the previous move's entry. When unwinding
     // the move stack (unmaking a move), we'll look at the previous move's
@@ -512,23 +763,15 @@ void Position::MakeMove(Move mov) {
   if (mov.IsCastle()) {
     // Castles are encoded based on the king's start and stop position.
     // Notably, the rook is not at the move's destination square.
-    Direction post_castle_dir, pre_castle_dir;
-    int num_squares;
+    Square rook_square, new_rook_square;
     if (mov.IsKingsideCastle()) {
-      post_castle_dir = kDirectionWest;
-      pre_castle_dir = kDirectionEast;
-      num_squares = 1;
+      rook_square = kKingsideRook;
+      new_rook_square = kKingsideRookTarget;
     } else {
-      post_castle_dir = kDirectionEast;
-      pre_castle_dir = kDirectionWest;
-      num_squares = 2;
+      rook_square = kQueensideRook;
+      new_rook_square = kQueensideRookTarget;
     }
 
-    Square new_rook_square = util::Towards(mov.Destination(), post_castle_dir);
-    Square rook_square =
-        static_cast<Square>(static_cast<int>(mov.Destination()) +
-                            kDirectionVectors[pre_castle_dir] * num_squares);
-
     auto rook = PieceAt(rook_square);
     CHECK(rook.has_value() && rook->kind() == kRook)
         << "rook not at destination: " << AsFen() << " " << mov;
@@ -538,16 +781,14 @@ void Position::MakeMove(Move mov) {
 
   Piece piece_to_add = *moving_piece;
   if (mov.IsPromotion()) {
-    piece_to_add = Piece(side_to_move_, mov.PromotionPiece());
+    piece_to_add = Piece(Us, mov.PromotionPiece());
   }
 
   RemovePiece(mov.Source());
   AddPiece(mov.Destination(), piece_to_add);
   if (mov.IsDoublePawnPush()) {
     // Double-pawn pushes set the en passant square.
-    Direction ep_dir =
-        SideToMove() == kWhite ? kDirectionSouth : kDirectionNorth;
-    Square ep_sq = util::Towards(mov.Destination(), ep_dir);
+    Square ep_sq = util::Towards(mov.Destination(), kBehind);
     zobrist::ModifyEnPassant(current_state_.zobrist_hash_,
                              current_state_.en_passant_square, ep_sq);
     current_state_.en_passant_square = ep_sq;
@@ -561,41 +802,25 @@ void Position::MakeMove(Move mov) {
   // castle rights by moving their king or rooks.
   if (moving_piece->kind() == kRook) {
     // Moving a rook invalidates the castle on that rook's side of the board.
-    Square kingside_rook, queenside_rook;
-    if (side_to_move_ == kWhite) {
-      kingside_rook = Square::H1;
-      queenside_rook = Square::A1;
-    } else {
-      kingside_rook = Square::H8;
-      queenside_rook = Square::A8;
-    }
-
-    if (CanCastleQueenside(side_to_move_) && mov.Source() == queenside_rook) {
+    if (CanCastleQueenside(Us) && mov.Source() == kQueensideRook) {
       // Move of the queenside rook. Can't castle queenside anymore.
-      CastleStatus mask = side_to_move_ == kWhite ? kCastleWhiteQueenside
-                                                  : kCastleBlackQueenside;
-      current_state_.castle_status &= ~mask;
-      zobrist::ModifyQueensideCastle(current_state_.zobrist_hash_,
-                                     side_to_move_);
+      current_state_.castle_status &= ~kQueensideMask;
+      zobrist::ModifyQueensideCastle(current_state_.zobrist_hash_, Us);
     }
 
-    if (CanCastleKingside(side_to_move_) && mov.Source() == kingside_rook) {
+    if (CanCastleKingside(Us) && mov.Source() == kKingsideRook) {
       // Move of the kingside rook. Can't castle kingside anymore.
-      CastleStatus mask =
-          side_to_move_ == kWhite ? kCastleWhiteKingside : kCastleBlackKingside;
-      current_state_.castle_status &= ~mask;
-      zobrist::ModifyKingsideCastle(current_state_.zobrist_hash_,
-                                    side_to_move_);
+      current_state_.castle_status &= ~kKingsideMask;
+      zobrist::ModifyKingsideCastle(current_state_.zobrist_hash_, Us);
     }
   } else if (moving_piece->kind() == kKing) {
     // Moving a king invalidates the castle on both sides.
-    CastleStatus mask = side_to_move_ == kWhite ? kCastleWhite : kCastleBlack;
-    current_state_.castle_status &= ~mask;
-    zobrist::ModifyKingsideCastle(current_state_.zobrist_hash_, side_to_move_);
-    zobrist::ModifyQueensideCastle(current_state_.zobrist_hash_, side_to_move_);
+    current_state_.castle_status &= ~kBothMask;
+    zobrist::ModifyKingsideCastle(current_state_.zobrist_hash_, Us);
+    zobrist::ModifyQueensideCastle(current_state_.zobrist_hash_, Us);
   }
 
-  side_to_move_ = !side_to_move_;
+  side_to_move_ = kThem;
   zobrist::ModifySideToMove(current_state_.zobrist_hash_);
   if (mov.IsCapture() || moving_piece->kind() == kPawn) {
     current_state_.halfmove_clock = 0;
@@ -603,7 +828,7 @@ void Position::MakeMove(Move mov) {
     current_state_.halfmove_clock++;
   }
 
-  if (side_to_move_ == kWhite) {
+  if constexpr (Us == kBlack) {
     current_state_.fullmove_clock++;
   }
 }
@@ -618,12 +843,60 @@ void Position::UnmakeMove() {
   // See comment at the bottom of this function.
   uint64_t hack_hash = current_state_.zobrist_hash_;
 
+  // The accumulator from before this move is still on the stack, unless the
+  // move was made before the network was attached. Either way, detach the
+  // network while we shuffle pieces back so that they don't update it.
+  const nnue::Network* network = network_;
+  bool refresh_accumulator = false;
+  if (network) {
+    if (accumulators_.size() > 1) {
+      accumulators_.pop_back();
+    } else {
+      refresh_accumulator = true;
+    }
+    network_ = nullptr;
+  }
+
   // Reverse the side to move.
   side_to_move_ = !side_to_move_;
 
   CHECK(current_state_.move.has_value()) << "no move available to unmake";
   Move mov = *current_state_.move;
 
+  // Null moves don't move any pieces, so there's nothing left to undo.
+  if (!mov.IsNull()) {
+    if (side_to_move_ == kWhite) {
+      UnmakeMoveFor<kWhite>(mov);
+    } else {
+      UnmakeMoveFor<kBlack>(mov);
+    }
+  }
+
+  // HACK HACK HACK: the zobrist hash is saved in the irreversible state buffer
+  // because it's hard to reverse it in UnmakeMove. We just called a bunch of
+  // functions that messed with the hash, so just restore the hash from the
+  // irreversible state buffer now.
+  //
+  // This sucks, but it works.
+  current_state_.zobrist_hash_ = hack_hash;
+
+  network_ = network;
+  if (refresh_accumulator) {
+    network_->Refresh(*this, accumulators_.back());
+  }
+}
+
+template <Color Us>
+void Position::UnmakeMoveFor(Move mov) {
+  constexpr Direction kBehind =
+      Us == kWhite ? kDirectionSouth : kDirectionNorth;
+  constexpr Square kKingsideRook = Us == kWhite ? Square::H1 : Square::H8;
+  constexpr Square kQueensideRook = Us == kWhite ? Square::A1 : Square::A8;
+  constexpr Square kKingsideRookTarget =
+      Us == kWhite ? Square::F1 : Square::F8;
+  constexpr Square kQueensideRookTarget =
+      Us == kWhite ? Square::D1 : Square::D8;
+
   // The rest of UnmakeMove proceeds in reverse of MakeMove; find the piece at
   // the destination square, remove it, replace it with the piece that was
   // captured, and move the piece back to the source.
@@ -642,39 +915,29 @@ void Position::UnmakeMove() {
     if (mov.IsEnPassant()) {
       // Like in MakeMove, en passant is the only move where we have to put
       // the piece back somewhere other than the move destination.
-      Direction ep_dir =
-          side_to_move_ == kWhite ? kDirectionSouth : kDirectionNorth;
-      captured_piece_square = util::Towards(mov.Destination(), ep_dir);
+      captured_piece_square = util::Towards(mov.Destination(), kBehind);
     }
 
-    AddPiece(captured_piece_square,
-             Piece(!side_to_move_, *current_state_.last_capture_));
+    AddPiece(captured_piece_square, Piece(!Us, *current_state_.last_capture_));
   }
 
   Piece piece_to_add = *moved_piece;
   if (mov.IsPromotion()) {
     // Only pawns can be promoted, therefore the piece that this used to be is
     // a pawn.
-    piece_to_add = Piece(side_to_move_, kPawn);
+    piece_to_add = Piece(Us, kPawn);
   }
   AddPiece(mov.Source(), piece_to_add);
 
   if (mov.IsCastle()) {
-    // If this move was a castle, we need to put the rook in the right spot.
-    // If this is a kingside castle, the rook needs to be one square to the
-    // east of the king. If this is a queenside castle, the rook needs to be
-    // two squares to the west of the king.
-    //
-    // In both cases, mov.Destination() refers to the location of the king,
-    // so we can calculate the rook position based on that.
+    // If this move was a castle, we need to put the rook back in its corner.
     Square rook_square, target_rook_square;
     if (mov.IsKingsideCastle()) {
-      rook_square = util::Towards(mov.Destination(), kDirectionWest);
-      target_rook_square = util::Towards(mov.Destination(), kDirectionEast);
+      rook_square = kKingsideRookTarget;
+      target_rook_square = kKingsideRook;
     } else {
-      rook_square = util::Towards(mov.Destination(), kDirectionEast);
-      target_rook_square = util::Towards(
-          util::Towards(mov.Destination(), kDirectionWest), kDirectionWest);
+      rook_square = kQueensideRookTarget;
+      target_rook_square = kQueensideRook;
     }
 
     auto rook = PieceAt(rook_square);
@@ -683,14 +946,15 @@ void Position::UnmakeMove() {
     RemovePiece(rook_square);
     AddPiece(target_rook_square, *rook);
   }
+}
 
-  // HACK HACK HACK: the zobrist hash is saved in the irreversible state buffer
-  // because it's hard to reverse it in UnmakeMove. We just called a bunch of
-  // functions that messed with the hash, so just restore the hash from the
-  // irreversible state buffer now.
-  //
-  // This sucks, but it works.
-  current_state_.zobrist_hash_ = hack_hash;
+void Position::AttachNetwork(const nnue::Network* network) {
+  network_ = network;
+  accumulators_.clear();
+  if (network_) {
+    accumulators_.emplace_back();
+    network_->Refresh(*this, accumulators_.back());
+  }
 }
 
 std::vector<Move> Position::PseudolegalMoves() const {
@@ -735,60 +999,188 @@ void Position::Dump(std::ostream& out) const {
 }
 
 std::string Position::AsFen() const {
-  std::stringstream ss;
+  char buffer[kMaxFenLength];
+  std::to_chars_result result = FenToChars(buffer, buffer + kMaxFenLength);
+  return std::string(buffer, result.ptr);
+}
+
+std::to_chars_result Position::FenToChars(char* first, char* last) const {
+  if (last - first < static_cast<std::ptrdiff_t>(kMaxFenLength)) {
+    // Write into a buffer that's certainly big enough, then see whether the
+    // result fits.
+    char buffer[kMaxFenLength];
+    std::to_chars_result result = FenToChars(buffer, buffer + kMaxFenLength);
+    size_t length = result.ptr - buffer;
+    if (length > static_cast<size_t>(last - first)) {
+      return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, buffer, length);
+    return {first + length, std::errc()};
+  }
+
+  // Lay the pieces out square by square first, rather than asking which
+  // piece is on each of the 64 squares.
+  char board[kSquareLast] = {};
+  for (Color color : kColors) {
+    for (PieceKind kind : kPieces) {
+      char c = Piece(color, kind).AsChar();
+      Pieces(color, kind).ForEach([&](Square sq) { board[sq] = c; });
+    }
+  }
+
+  char* out = first;
   for (int rank = kRank8; rank >= kRank1; rank--) {
-    int empty_squares = 0;
+    char empty_squares = 0;
     for (int file = kFileA; file < kFileLast; file++) {
-      Square sq = util::SquareOf(rank, file);
-      std::optional<Piece> piece_at_square = PieceAt(sq);
-      if (piece_at_square) {
-        if (empty_squares != 0) {
-          ss << empty_squares;
-        }
-        ss << piece_at_square->AsChar();
-        empty_squares = 0;
-      } else {
+      char c = board[rank * 8 + file];
+      if (c == 0) {
         empty_squares++;
+        continue;
+      }
+      if (empty_squares != 0) {
+        *out++ = '0' + empty_squares;
+        empty_squares = 0;
       }
+      *out++ = c;
     }
-
     if (empty_squares != 0) {
-      ss << empty_squares;
+      *out++ = '0' + empty_squares;
     }
-
     if (rank != kRank1) {
-      ss << "/";
+      *out++ = '/';
     }
   }
 
-  ss << " ";
-  if (SideToMove() == kWhite) {
-    ss << "w";
-  } else {
-    ss << "b";
-  }
-  ss << " ";
+  *out++ = ' ';
+  *out++ = SideToMove() == kWhite ? 'w' : 'b';
+  *out++ = ' ';
+  char* castling = out;
   if (CanCastleKingside(kWhite)) {
-    ss << "K";
+    *out++ = 'K';
   }
   if (CanCastleQueenside(kWhite)) {
-    ss << "Q";
+    *out++ = 'Q';
   }
   if (CanCastleKingside(kBlack)) {
-    ss << "k";
+    *out++ = 'k';
   }
   if (CanCastleQueenside(kBlack)) {
-    ss << "q";
+    *out++ = 'q';
+  }
+  if (out == castling) {
+    *out++ = '-';
   }
-  ss << " ";
+  *out++ = ' ';
   auto ep_square = EnPassantSquare();
   if (ep_square) {
-    ss << util::SquareString(*ep_square);
+    *out++ = 'a' + util::FileOf(*ep_square);
+    *out++ = '1' + util::RankOf(*ep_square);
   } else {
-    ss << "-";
+    *out++ = '-';
   }
-  ss << " " << HalfmoveClock() << " " << FullmoveClock();
-  return ss.str();
+  *out++ = ' ';
+  out = std::to_chars(out, last, HalfmoveClock()).ptr;
+  *out++ = ' ';
+  out = std::to_chars(out, last, FullmoveClock()).ptr;
+  return {out, std::errc()};
+}
+
+PackedPosition Position::Pack() const {
+  PackedPosition packed = {};
+  Bitboard occupancy = Pieces(kWhite) | Pieces(kBlack);
+  CHECK(occupancy.Count() <= 32) << "too many pieces to pack";
+  uint64_t bits = occupancy.Bits();
+  std::memcpy(&packed.bytes[0], &bits, sizeof(bits));
+
+  // Split the piece codes into four bit planes, so that the code of the
+  // piece on any square can be read off without a search.
+  uint64_t planes[4] = {};
+  for (size_t code = 0; code < boards_by_piece_.size(); code++) {
+    for (int bit = 0; bit < 4; bit++) {
+      if (code & (1 << bit)) {
+        planes[bit] |= boards_by_piece_[code].Bits();
+      }
+    }
+  }
+
+  int index = 0;
+  occupancy.ForEach([&](Square sq) {
+    uint8_t code = ((planes[0] >> sq) & 1) | ((planes[1] >> sq) & 1) << 1 |
+                   ((planes[2] >> sq) & 1) << 2 | ((planes[3] >> sq) & 1) << 3;
+    packed.bytes[8 + index / 2] |= code << (4 * (index % 2));
+    index++;
+  });
+
+  auto ep_square = EnPassantSquare();
+  uint16_t ep_file = ep_square ? util::FileOf(*ep_square) + 1 : 0;
+  uint16_t halfmove = static_cast<uint16_t>(std::min(HalfmoveClock(), 127));
+  uint16_t state = static_cast<uint16_t>(SideToMove()) |
+                   current_state_.castle_status << 1 | ep_file << 5 |
+                   halfmove << 9;
+  uint16_t fullmove = static_cast<uint16_t>(FullmoveClock());
+  std::memcpy(&packed.bytes[24], &state, sizeof(state));
+  std::memcpy(&packed.bytes[26], &fullmove, sizeof(fullmove));
+  return packed;
+}
+
+Position Position::Unpack(const PackedPosition& packed) {
+  Position pos{EmptyBoard{}};
+  uint64_t bits;
+  uint16_t state;
+  uint16_t fullmove;
+  std::memcpy(&bits, &packed.bytes[0], sizeof(bits));
+  std::memcpy(&state, &packed.bytes[24], sizeof(state));
+  std::memcpy(&fullmove, &packed.bytes[26], sizeof(fullmove));
+
+  // The pieces are placed directly rather than through AddPiece, which
+  // would check every square and look up the hash and evaluation terms of
+  // every piece in separate calls. The pieces are listed as the boards are
+  // filled in, and the hash and evaluation state are summed over the list
+  // afterwards.
+  std::array<Piece, 32> pieces;
+  std::array<Square, 32> squares;
+  int count = 0;
+  Bitboard(bits).ForEach([&](Square sq) {
+    int code = (packed.bytes[8 + count / 2] >> (4 * (count % 2))) & 0xF;
+    CHECK(code < 12) << "invalid packed piece";
+    pos.boards_by_piece_[code].Set(sq);
+    pos.boards_by_color_[code < 6 ? 0 : 1].Set(sq);
+    pieces[count] =
+        Piece(code < 6 ? kWhite : kBlack, static_cast<PieceKind>(code % 6));
+    squares[count] = sq;
+    count++;
+  });
+  psqt::Accumulate(pieces.data(), squares.data(), count, pos.midgame_score_,
+                   pos.endgame_score_, pos.phase_);
+  uint64_t hash = 0;
+  zobrist::ModifyPieces(hash, pieces.data(), squares.data(), count);
+
+  pos.side_to_move_ = static_cast<Color>(state & 1);
+  if (pos.side_to_move_ == kBlack) {
+    zobrist::ModifySideToMove(hash);
+  }
+  pos.current_state_.castle_status =
+      static_cast<CastleStatus>((state >> 1) & kCastleAll);
+  for (Color color : kColors) {
+    if (pos.CanCastleKingside(color)) {
+      zobrist::ModifyKingsideCastle(hash, color);
+    }
+    if (pos.CanCastleQueenside(color)) {
+      zobrist::ModifyQueensideCastle(hash, color);
+    }
+  }
+  int ep_file = (state >> 5) & 0xF;
+  if (ep_file != 0) {
+    Rank ep_rank = pos.side_to_move_ == kWhite ? kRank6 : kRank3;
+    Square ep_square = util::SquareOf(ep_rank, ep_file - 1);
+    pos.current_state_.en_passant_square = ep_square;
+    zobrist::ModifyEnPassant(hash, {}, ep_square);
+  }
+  pos.current_state_.halfmove_clock = state >> 9;
+  pos.current_state_.fullmove_clock = fullmove;
+  pos.current_state_.zobrist_hash_ = hash;
+  pos.UpdateCheckInfo();
+  return pos;
 }
 
 std::optional<Move> Position::MoveFromUci(std::string_view uci) const {
@@ -944,4 +1336,152 @@ std::optional<Move> Position::MoveFromUci(std::string_view uci) const {
   return Move::Quiet(source, dest);
 }
 
+std::optional<Move> Position::MoveFromSan(std::string_view san) const {
+  while (!san.empty() && std::strchr("+#!?", san.back())) {
+    san.remove_suffix(1);
+  }
+
+  std::vector<Move> legal_moves = LegalMoves();
+  if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0") {
+    bool kingside = san.size() == 3;
+    for (Move mov : legal_moves) {
+      if (kingside ? mov.IsKingsideCastle() : mov.IsQueensideCastle()) {
+        return mov;
+      }
+    }
+    return {};
+  }
+
+  // Pieces other than pawns are written as an uppercase letter.
+  PieceKind kind = kPawn;
+  if (!san.empty() && std::isupper(static_cast<unsigned char>(san[0]))) {
+    auto maybe_kind = util::CharToPiece(std::tolower(san[0]));
+    if (!maybe_kind) {
+      return {};
+    }
+    kind = *maybe_kind;
+    san.remove_prefix(1);
+  }
+
+  // Promotions are written "e8=Q", or sometimes "e8Q".
+  std::optional<PieceKind> promotion;
+  if (kind == kPawn && !san.empty() &&
+      std::isupper(static_cast<unsigned char>(san.back()))) {
+    promotion = util::CharToPiece(std::tolower(san.back()));
+    if (!promotion) {
+      return {};
+    }
+    san.remove_suffix(1);
+    if (!san.empty() && san.back() == '=') {
+      san.remove_suffix(1);
+    }
+  }
+
+  if (san.size() < 2) {
+    return {};
+  }
+  auto maybe_dest_file = util::CharToFile(san[san.size() - 2]);
+  auto maybe_dest_rank = util::CharToRank(san[san.size() - 1]);
+  if (!maybe_dest_file || !maybe_dest_rank) {
+    return {};
+  }
+  Square dest = util::SquareOf(*maybe_dest_rank, *maybe_dest_file);
+  san.remove_suffix(2);
+
+  // What's left is the source file and rank needed to disambiguate the move,
+  // if any, and the capture marker.
+  std::optional<File> source_file;
+  std::optional<Rank> source_rank;
+  for (char c : san) {
+    if (c == 'x') {
+      continue;
+    }
+    if (auto file = util::CharToFile(c)) {
+      source_file = file;
+    } else if (auto rank = util::CharToRank(c)) {
+      source_rank = rank;
+    } else {
+      return {};
+    }
+  }
+
+  std::optional<Move> found;
+  for (Move mov : legal_moves) {
+    Square source = mov.Source();
+    if (mov.IsCastle() || mov.Destination() != dest ||
+        PieceAt(source)->kind() != kind ||
+        (source_file && util::FileOf(source) != *source_file) ||
+        (source_rank && util::RankOf(source) != *source_rank) ||
+        mov.IsPromotion() != promotion.has_value() ||
+        (promotion && mov.PromotionPiece() != *promotion)) {
+      continue;
+    }
+    if (found) {
+      // The move is ambiguous.
+      return {};
+    }
+    found = mov;
+  }
+  return found;
+}
+
+std::string Position::MoveToSan(Move mov) const {
+  const char kPieceLetters[] = {'P', 'N', 'B', 'R', 'Q', 'K'};
+  std::string san;
+  if (mov.IsKingsideCastle()) {
+    san = "O-O";
+  } else if (mov.IsQueensideCastle()) {
+    san = "O-O-O";
+  } else {
+    Square source = mov.Source();
+    PieceKind kind = PieceAt(source)->kind();
+    if (kind == kPawn) {
+      if (mov.IsCapture()) {
+        san += util::SquareString(source)[0];
+      }
+    } else {
+      san += kPieceLetters[kind];
+
+      // Disambiguate by file if that's enough, then by rank, then by both.
+      bool ambiguous = false;
+      bool same_file = false;
+      bool same_rank = false;
+      for (Move other : LegalMoves()) {
+        Square other_source = other.Source();
+        if (other_source == source ||
+            other.Destination() != mov.Destination() || other.IsCastle() ||
+            PieceAt(other_source)->kind() != kind) {
+          continue;
+        }
+        ambiguous = true;
+        same_file |= util::FileOf(other_source) == util::FileOf(source);
+        same_rank |= util::RankOf(other_source) == util::RankOf(source);
+      }
+      std::string source_string = util::SquareString(source);
+      if (ambiguous && (!same_file || same_rank)) {
+        san += source_string[0];
+      }
+      if (ambiguous && same_file) {
+        san += source_string[1];
+      }
+    }
+
+    if (mov.IsCapture()) {
+      san += 'x';
+    }
+    san += util::SquareString(mov.Destination());
+    if (mov.IsPromotion()) {
+      san += '=';
+      san += kPieceLetters[mov.PromotionPiece()];
+    }
+  }
+
+  if (GivesCheck(mov)) {
+    Position after = *this;
+    after.MakeMove(mov);
+    san += after.LegalMoves().empty() ? '#' : '+';
+  }
+  return san;
+}
+
 }  // namespace apollo
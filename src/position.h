@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <charconv>
 #include <cstdint>
 #include <exception>
 #include <iostream>
@@ -11,14 +12,26 @@
 
 #include "bitboard.h"
 #include "move.h"
+#include "nnue/accumulator.h"
 #include "piece.h"
 #include "types.h"
 
 namespace apollo {
 
+namespace nnue {
+
+class Network;
+
+}  // namespace nnue
+
 constexpr const char* kFenDefaultPosition =
     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+/**
+ * The length of the longest FEN that Position::FenToChars can write.
+ */
+constexpr size_t kMaxFenLength = 128;
+
 enum FenParseError {
   kInvalidDigit = 1,
   kFileInvalidSum,
@@ -36,6 +49,26 @@ class InvalidFenException : std::exception {
   FenParseError err_;
 };
 
+/**
+ * A Position packed into 28 bytes, for storing positions in bulk. The move
+ * history of the position isn't kept. The layout is:
+ *
+ *   uint64  occupancy, a bitboard of every occupied square
+ *   uint8   pieces[16], a 4-bit code for the piece on each occupied square in
+ *           square order, low nibble first. The code is the piece kind, plus
+ *           6 for black pieces.
+ *   uint16  side to move (bit 0), castle status (bits 1-4), the file of the
+ *           en passant square plus one or zero if there isn't one (bits 5-8)
+ *           and the halfmove clock, saturating at 127 (bits 9-15)
+ *   uint16  fullmove clock
+ *
+ * Fields are in native byte order. Only positions with at most 32 pieces can
+ * be packed, which every position reachable in a game has.
+ */
+struct PackedPosition {
+  std::array<uint8_t, 28> bytes;
+};
+
 /**
  * A Position represents a singular chess position. It contains all of the state
  * necessary to represent a instant in a game of chess, as well as enough state
@@ -141,10 +174,108 @@ class Position {
   Bitboard Queens(Color color) const { return Pieces(color, kQueen); }
   Bitboard Kings(Color color) const { return Pieces(color, kKing); }
 
+  /**
+   * Returns the midgame material and piece-square score of this position, in
+   * centipawns from white's point of view. The score is maintained
+   * incrementally as pieces are added to and removed from the board.
+   */
+  int MidgameScore() const { return this->midgame_score_; }
+
+  /**
+   * Returns the endgame material and piece-square score of this position, in
+   * centipawns from white's point of view.
+   */
+  int EndgameScore() const { return this->endgame_score_; }
+
+  /**
+   * Returns the game phase of this position, which ranges from
+   * psqt::kPhaseMax with all non-pawn material on the board down to zero with
+   * none of it. Promotions can push the phase past psqt::kPhaseMax.
+   */
+  int Phase() const { return this->phase_; }
+
+  /**
+   * Attaches an NNUE network to this position, or detaches the current
+   * network if given nullptr. While a network is attached, MakeMove and
+   * UnmakeMove keep the network's first-layer accumulator up to date.
+   *
+   * The network must outlive its attachment to this position.
+   */
+  void AttachNetwork(const nnue::Network* network);
+
+  /**
+   * Returns the NNUE network attached to this position, if any.
+   */
+  const nnue::Network* AttachedNetwork() const { return this->network_; }
+
+  /**
+   * Returns the accumulator of the attached NNUE network for this position.
+   * Only valid while a network is attached.
+   */
+  const nnue::Accumulator& NnueAccumulator() const {
+    return this->accumulators_.back();
+  }
+
   std::string AsFen() const;
 
+  /**
+   * Writes the FEN of this position into the range [first, last), in the
+   * manner of std::to_chars: on success, returns a pointer one past the last
+   * character written, and otherwise returns last and
+   * std::errc::value_too_large. A buffer of kMaxFenLength characters is
+   * always big enough. The FEN isn't null-terminated.
+   */
+  std::to_chars_result FenToChars(char* first, char* last) const;
+
+  /**
+   * Returns this position packed into a PackedPosition.
+   */
+  PackedPosition Pack() const;
+
+  /**
+   * Returns the position that was packed into the given PackedPosition.
+   */
+  static Position Unpack(const PackedPosition& packed);
+
+  /**
+   * Returns the pieces of both colors that attack the given square when the
+   * board is occupied by the given set of squares. Passing an occupancy other
+   * than the real one asks about a hypothetical board: sliders see through
+   * squares left out of it, which is how x-ray attacks are found.
+   */
+  Bitboard AttackersTo(Square sq, Bitboard occupancy) const;
+
   Bitboard SquaresAttacking(Color to_move, Square sq) const;
   bool IsCheck(Color to_move) const;
+
+  /**
+   * Returns the enemy pieces giving check to the side to move.
+   *
+   * This and the two functions below are computed once per move made and
+   * saved with the rest of the irreversible state, so they are free to call.
+   * They are not updated by AddPiece and RemovePiece.
+   */
+  Bitboard Checkers() const { return current_state_.checkers; }
+
+  /**
+   * Returns the pieces of the side to move that are absolutely pinned to
+   * their king.
+   */
+  Bitboard PinnedPieces() const { return current_state_.pinned; }
+
+  /**
+   * Returns the pieces of the side to move that are the only piece between
+   * one of its sliders and the enemy king, and so would give a discovered
+   * check by moving off that line.
+   */
+  Bitboard DiscoveredCheckCandidates() const {
+    return current_state_.discovered_check_candidates;
+  }
+
+  /**
+   * Returns whether or not the given pseudolegal move gives check.
+   */
+  bool GivesCheck(Move mov) const;
   bool IsCheckmate(Color to_move) const;
 
   // Pin detection
@@ -154,6 +285,14 @@ class Position {
   bool IsLegal(Move mov) const;
   bool IsLegalGivenPseudolegal(Move mov) const;
 
+  /**
+   * Returns whether or not the given move is one that the move generator
+   * would generate in this position, without generating any moves. Moves
+   * that come from somewhere other than the generator, such as a UCI client
+   * or an earlier search, should be validated with this before they are made.
+   */
+  bool IsPseudoLegal(Move mov) const;
+
   void AddPiece(Square sq, Piece piece);
   void RemovePiece(Square sq);
   std::optional<Piece> PieceAt(Square sq) const;
@@ -168,11 +307,44 @@ class Position {
 
   std::optional<Move> MoveFromUci(std::string_view) const;
 
+  /**
+   * Returns the legal move written in Standard Algebraic Notation, or nothing
+   * if the string doesn't describe exactly one legal move. Check and mate
+   * markers and annotations like "!?" are accepted but not checked.
+   */
+  std::optional<Move> MoveFromSan(std::string_view san) const;
+
+  /**
+   * Returns the given legal move in Standard Algebraic Notation.
+   */
+  std::string MoveToSan(Move mov) const;
+
  private:
   friend class FenParser;
 
+  // Constructs a position with no pieces, white to move and no castling
+  // rights.
+  struct EmptyBoard {};
+  explicit Position(EmptyBoard);
+
   Bitboard SquareAttacks(Square sq) const;
 
+  // Returns the pieces that are the only piece between the given king and one
+  // of the given sliders.
+  Bitboard SliderBlockers(Square king, Bitboard rook_sliders,
+                          Bitboard bishop_sliders) const;
+
+  // Recomputes the checkers, pinned pieces and discovered check candidates of
+  // the current state.
+  void UpdateCheckInfo();
+
+  // The bodies of MakeMove and UnmakeMove, specialized on the color of the
+  // side making or unmaking the move.
+  template <Color Us>
+  void MakeMoveFor(Move mov);
+  template <Color Us>
+  void UnmakeMoveFor(Move mov);
+
   struct IrreversibleInformation {
     std::optional<Move> move;
     std::optional<PieceKind> last_capture_;
@@ -181,13 +353,30 @@ class Position {
     int fullmove_clock;
     CastleStatus castle_status;
     uint64_t zobrist_hash_;
+    Bitboard checkers;
+    Bitboard pinned;
+    Bitboard discovered_check_candidates;
   };
 
   IrreversibleInformation current_state_;
-  std::stack<IrreversibleInformation> irreversible_state_;
+  std::stack<IrreversibleInformation, std::vector<IrreversibleInformation>>
+      irreversible_state_;
   std::array<Bitboard, 12> boards_by_piece_;
   std::array<Bitboard, 2> boards_by_color_;
   Color side_to_move_;
+
+  // Incrementally-updated evaluation state. Unlike the Zobrist hash, these
+  // are exactly reversed by the AddPiece and RemovePiece calls that
+  // UnmakeMove makes, so they don't need to live on the irreversible state
+  // stack.
+  int midgame_score_;
+  int endgame_score_;
+  int phase_;
+
+  // The attached NNUE network and its accumulators, one for every move made
+  // since the network was attached. Unmaking a move pops an accumulator.
+  const nnue::Network* network_;
+  std::vector<nnue::Accumulator> accumulators_;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Position& pos) {
@@ -1,9 +1,17 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <vector>
 #include "gtest/gtest.h"
 
 #include "log.h"
 #include "move.h"
 #include "position.h"
+#include "psqt.h"
 
+using apollo::Bitboard;
+using apollo::kFenDefaultPosition;
 using apollo::Move;
 using apollo::PieceKind;
 using apollo::Position;
@@ -215,6 +223,20 @@ TEST(PositionPinTest, KingPin) {
   ASSERT_FALSE(p.IsAbsolutelyPinned(apollo::kWhite, Square::D4));
 }
 
+TEST(PositionPinTest, PinnedPieceMovesAlongPin) {
+  Position p("4k3/8/4q3/8/8/8/4R3/4K3 w - - 0 1");
+  ASSERT_TRUE(p.IsLegalGivenPseudolegal(Move::Quiet(Square::E2, Square::E4)));
+  ASSERT_TRUE(p.IsLegalGivenPseudolegal(Move::Capture(Square::E2, Square::E6)));
+  ASSERT_FALSE(p.IsLegalGivenPseudolegal(Move::Quiet(Square::E2, Square::D2)));
+}
+
+TEST(PositionCheckTest, EnPassantCapturesChecker) {
+  Position p("8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1");
+  ASSERT_TRUE(p.IsCheck(apollo::kBlack));
+  ASSERT_TRUE(
+      p.IsLegalGivenPseudolegal(Move::EnPassant(Square::E4, Square::D3)));
+}
+
 TEST(PositionUciTest, UciPawns) {
   Position p("8/8/8/8/8/2p5/1P6/8 w - - 0 1");
   ASSERT_EQ(Move::Quiet(Square::B2, Square::B3), p.MoveFromUci("b2b3"));
@@ -266,8 +288,356 @@ TEST(PositionUciTest, UciBugCastle) {
   ASSERT_EQ(Move::Quiet(Square::D7, Square::C8), p.MoveFromUci("d7c8"));
 }
 
+TEST(PositionSanTest, SanPiecesAndPawns) {
+  Position p(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+  ASSERT_EQ(Move::Quiet(Square::E5, Square::D3), p.MoveFromSan("Nd3"));
+  ASSERT_EQ(Move::Capture(Square::E5, Square::F7), p.MoveFromSan("Nxf7"));
+  ASSERT_EQ(Move::Capture(Square::D5, Square::E6), p.MoveFromSan("dxe6"));
+  ASSERT_EQ(Move::DoublePawnPush(Square::A2, Square::A4), p.MoveFromSan("a4"));
+  ASSERT_EQ(Move::KingsideCastle(Square::E1, Square::G1), p.MoveFromSan("O-O"));
+  ASSERT_EQ(Move::QueensideCastle(Square::E1, Square::C1),
+            p.MoveFromSan("O-O-O"));
+  ASSERT_EQ(Move::Capture(Square::F3, Square::F6), p.MoveFromSan("Qxf6!?"));
+
+  // No knight can move to h4, and Kg1 is not castling.
+  ASSERT_FALSE(p.MoveFromSan("Nh4").has_value());
+  ASSERT_FALSE(p.MoveFromSan("Kg1").has_value());
+  ASSERT_FALSE(p.MoveFromSan("Zz9").has_value());
+}
+
+TEST(PositionSanTest, SanDisambiguationAndPromotion) {
+  Position p("3r3k/4P3/8/8/8/8/K7/R6R w - - 0 1");
+  ASSERT_FALSE(p.MoveFromSan("Rd1").has_value());
+  ASSERT_EQ(Move::Quiet(Square::A1, Square::D1), p.MoveFromSan("Rad1"));
+  ASSERT_EQ(Move::Quiet(Square::H1, Square::D1), p.MoveFromSan("Rhd1"));
+  ASSERT_EQ(Move::Promotion(Square::E7, Square::E8, apollo::kQueen),
+            p.MoveFromSan("e8=Q+"));
+  ASSERT_EQ(Move::Promotion(Square::E7, Square::E8, apollo::kKnight),
+            p.MoveFromSan("e8N"));
+  ASSERT_EQ(Move::PromotionCapture(Square::E7, Square::D8, apollo::kRook),
+            p.MoveFromSan("exd8=R+"));
+  ASSERT_FALSE(p.MoveFromSan("e8").has_value());
+}
+
+TEST(PositionSanTest, SanRoundTrip) {
+  const char* const positions[] = {
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+      "3r3k/4P3/8/8/8/8/K7/R6R w - - 0 1",
+      "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1",
+      "1k6/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1",
+      "7k/8/8/8/8/8/8/R5RK w - - 0 1",
+  };
+  for (const char* fen : positions) {
+    Position p(fen);
+    for (Move mov : p.LegalMoves()) {
+      std::string san = p.MoveToSan(mov);
+      ASSERT_EQ(mov, p.MoveFromSan(san)) << fen << " " << san;
+    }
+  }
+
+  Position mate("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+  ASSERT_EQ("Ra8#", mate.MoveToSan(Move::Quiet(Square::A1, Square::A8)));
+  Position queens("1k6/8/8/8/8/Q7/8/Q1Q1K3 w - - 0 1");
+  ASSERT_EQ("Qa1b2#", queens.MoveToSan(Move::Quiet(Square::A1, Square::B2)));
+  ASSERT_EQ("Q3b2#", queens.MoveToSan(Move::Quiet(Square::A3, Square::B2)));
+  Position rooks("7k/8/8/8/8/8/8/R5RK w - - 0 1");
+  ASSERT_EQ("Rg8+", rooks.MoveToSan(Move::Quiet(Square::G1, Square::G8)));
+  ASSERT_EQ("Rab1", rooks.MoveToSan(Move::Quiet(Square::A1, Square::B1)));
+}
+
 TEST(PositionCheckmateTest, CheckmateBug) {
   Position p("8/3r2k1/p3R3/P1B2NNp/1PP3pK/8/3R2PP/8 b - - 0 50");
   ASSERT_FALSE(p.IsCheckmate(apollo::kBlack));
   ASSERT_TRUE(p.IsLegal(Move::Quiet(Square::G7, Square::H8)));
-}
\ No newline at end of file
+}
+
+TEST(PositionEvalStateTest, StartPositionIsBalanced) {
+  Position p;
+  ASSERT_EQ(0, p.MidgameScore());
+  ASSERT_EQ(0, p.EndgameScore());
+  ASSERT_EQ(apollo::psqt::kPhaseMax, p.Phase());
+}
+
+TEST(PositionEvalStateTest, IncrementalMatchesFresh) {
+  Position p(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+  int midgame = p.MidgameScore();
+  int endgame = p.EndgameScore();
+  int phase = p.Phase();
+  for (Move mov : p.PseudolegalMoves()) {
+    p.MakeMove(mov);
+    Position fresh(p.AsFen());
+    ASSERT_EQ(fresh.MidgameScore(), p.MidgameScore()) << mov;
+    ASSERT_EQ(fresh.EndgameScore(), p.EndgameScore()) << mov;
+    ASSERT_EQ(fresh.Phase(), p.Phase()) << mov;
+    p.UnmakeMove();
+    ASSERT_EQ(midgame, p.MidgameScore());
+    ASSERT_EQ(endgame, p.EndgameScore());
+    ASSERT_EQ(phase, p.Phase());
+  }
+}
+
+TEST(PositionEvalStateTest, PromotionAndCapture) {
+  Position p("1n6/P7/8/8/8/8/8/8 w - - 0 1");
+  int phase = p.Phase();
+  p.MakeMove(Move::PromotionCapture(Square::A7, Square::B8, apollo::kQueen));
+  ASSERT_EQ(phase - apollo::psqt::Phase(apollo::kKnight) +
+                apollo::psqt::Phase(apollo::kQueen),
+            p.Phase());
+  p.UnmakeMove();
+  ASSERT_EQ(phase, p.Phase());
+}
+
+namespace {
+
+void AssertHashMatchesFresh(Position& pos, int depth) {
+  ASSERT_EQ(Position(pos.AsFen()).ZobristHash(), pos.ZobristHash())
+      << pos.AsFen();
+  if (depth == 0) {
+    return;
+  }
+
+  for (Move mov : pos.PseudolegalMoves()) {
+    pos.MakeMove(mov);
+    AssertHashMatchesFresh(pos, depth - 1);
+    pos.UnmakeMove();
+  }
+}
+
+}  // anonymous namespace
+
+TEST(PositionZobristTest, IncrementalMatchesFresh) {
+  Position p(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+  AssertHashMatchesFresh(p, 2);
+}
+
+TEST(PositionZobristTest, NullMoveRoundTrip) {
+  Position p("rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2");
+  std::string fen = p.AsFen();
+  uint64_t hash = p.ZobristHash();
+  p.MakeMove(Move::Null());
+  ASSERT_EQ(Position(p.AsFen()).ZobristHash(), p.ZobristHash());
+  p.UnmakeMove();
+  ASSERT_EQ(fen, p.AsFen());
+  ASSERT_EQ(hash, p.ZobristHash());
+}
+
+TEST(PositionAttackersTest, AttackersTo) {
+  Position p("4k3/8/4n3/8/8/2P5/3R4/3QK3 w - - 0 1");
+  Bitboard occupancy = p.Pieces(apollo::kWhite) | p.Pieces(apollo::kBlack);
+  Bitboard attackers = p.AttackersTo(Square::D4, occupancy);
+  ASSERT_EQ(3, attackers.Count());
+  ASSERT_TRUE(attackers.Test(Square::C3));
+  ASSERT_TRUE(attackers.Test(Square::D2));
+  ASSERT_TRUE(attackers.Test(Square::E6));
+
+  // With the rook gone, the queen behind it sees through to the target.
+  occupancy.Unset(Square::D2);
+  ASSERT_TRUE(p.AttackersTo(Square::D4, occupancy).Test(Square::D1));
+}
+
+TEST(PositionCheckTest, KingCantRetreatAlongCheck) {
+  Position p("4k3/8/8/8/8/8/8/r3K3 w - - 0 1");
+  ASSERT_FALSE(p.IsLegalGivenPseudolegal(Move::Quiet(Square::E1, Square::F1)));
+  ASSERT_TRUE(p.IsLegalGivenPseudolegal(Move::Quiet(Square::E1, Square::E2)));
+}
+
+TEST(PositionCheckTest, EnPassantDiscoveredCheck) {
+  Position p("8/8/8/K2pP2r/8/8/8/7k w - d6 0 1");
+  ASSERT_FALSE(
+      p.IsLegalGivenPseudolegal(Move::EnPassant(Square::E5, Square::D6)));
+}
+
+namespace {
+
+void AssertLegalMovesMatchMakeAndCheck(Position& pos, int depth) {
+  apollo::Color us = pos.SideToMove();
+  std::vector<Move> expected;
+  for (Move mov : pos.PseudolegalMoves()) {
+    pos.MakeMove(mov);
+    if (!pos.IsCheck(us)) {
+      expected.push_back(mov);
+    }
+    pos.UnmakeMove();
+  }
+  ASSERT_EQ(expected, pos.LegalMoves()) << pos.AsFen();
+  if (depth == 0) {
+    return;
+  }
+
+  for (Move mov : expected) {
+    pos.MakeMove(mov);
+    AssertLegalMovesMatchMakeAndCheck(pos, depth - 1);
+    pos.UnmakeMove();
+  }
+}
+
+}  // anonymous namespace
+
+TEST(PositionLegalityTest, LegalMovesMatchMakeAndCheck) {
+  Position p(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+  AssertLegalMovesMatchMakeAndCheck(p, 2);
+}
+
+TEST(PositionCheckInfoTest, CheckersAndPins) {
+  Position p("4k3/4r3/8/8/1b6/8/3N4/4K3 w - - 0 1");
+  ASSERT_TRUE(p.Checkers().Test(Square::E7));
+  ASSERT_EQ(1, p.Checkers().Count());
+  ASSERT_TRUE(p.PinnedPieces().Test(Square::D2));
+  ASSERT_EQ(1, p.PinnedPieces().Count());
+
+  p.MakeMove(Move::Quiet(Square::E1, Square::F1));
+  ASSERT_TRUE(p.Checkers().Empty());
+  ASSERT_TRUE(p.PinnedPieces().Empty());
+  ASSERT_TRUE(p.DiscoveredCheckCandidates().Empty());
+
+  p.UnmakeMove();
+  ASSERT_TRUE(p.Checkers().Test(Square::E7));
+  ASSERT_TRUE(p.PinnedPieces().Test(Square::D2));
+}
+
+TEST(PositionCheckInfoTest, DiscoveredCheck) {
+  Position p("4k3/8/8/8/4N3/8/8/4RK2 w - - 0 1");
+  ASSERT_TRUE(p.DiscoveredCheckCandidates().Test(Square::E4));
+  ASSERT_TRUE(p.GivesCheck(Move::Quiet(Square::E4, Square::C3)));
+  ASSERT_TRUE(p.GivesCheck(Move::Quiet(Square::E4, Square::D6)));
+  ASSERT_FALSE(p.GivesCheck(Move::Quiet(Square::F1, Square::G1)));
+}
+
+namespace {
+
+void AssertGivesCheckMatchesMakeAndCheck(Position& pos, int depth) {
+  apollo::Color us = pos.SideToMove();
+  for (Move mov : pos.LegalMoves()) {
+    bool gives_check = pos.GivesCheck(mov);
+    pos.MakeMove(mov);
+    ASSERT_EQ(pos.IsCheck(!us), gives_check) << pos.AsFen();
+    if (depth > 0) {
+      AssertGivesCheckMatchesMakeAndCheck(pos, depth - 1);
+    }
+    pos.UnmakeMove();
+  }
+}
+
+}  // anonymous namespace
+
+TEST(PositionCheckInfoTest, GivesCheckMatchesMakeAndCheck) {
+  Position kiwipete(
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -");
+  AssertGivesCheckMatchesMakeAndCheck(kiwipete, 1);
+  Position endgame("8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -");
+  AssertGivesCheckMatchesMakeAndCheck(endgame, 2);
+}
+
+namespace {
+
+// Every move that can be encoded from one square to another, valid or not.
+std::vector<Move> AllMoves(Square source, Square dest) {
+  std::vector<Move> moves = {
+      Move::Quiet(source, dest),          Move::Capture(source, dest),
+      Move::DoublePawnPush(source, dest), Move::EnPassant(source, dest),
+      Move::KingsideCastle(source, dest), Move::QueensideCastle(source, dest),
+  };
+  for (PieceKind kind :
+       {apollo::kKnight, apollo::kBishop, apollo::kRook, apollo::kQueen}) {
+    moves.push_back(Move::Promotion(source, dest, kind));
+    moves.push_back(Move::PromotionCapture(source, dest, kind));
+  }
+  return moves;
+}
+
+void AssertPseudoLegalMatchesGenerator(const Position& pos) {
+  std::vector<Move> generated = pos.PseudolegalMoves();
+  for (Square source : apollo::kSquares) {
+    for (Square dest : apollo::kSquares) {
+      for (Move mov : AllMoves(source, dest)) {
+        bool expected = std::find(generated.begin(), generated.end(), mov) !=
+                        generated.end();
+        ASSERT_EQ(expected, pos.IsPseudoLegal(mov))
+            << pos.AsFen() << " " << mov;
+      }
+    }
+  }
+}
+
+}  // anonymous namespace
+
+TEST(PositionLegalityTest, PseudoLegalMatchesGenerator) {
+  const char* fens[] = {
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R b KQkq -",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+      "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2",
+  };
+  for (const char* fen : fens) {
+    Position p(fen);
+    AssertPseudoLegalMatchesGenerator(p);
+    for (Move mov : p.PseudolegalMoves()) {
+      p.MakeMove(mov);
+      AssertPseudoLegalMatchesGenerator(p);
+      p.UnmakeMove();
+    }
+  }
+}
+
+TEST(PositionPackTest, RoundTrip) {
+  const char* fens[] = {
+      kFenDefaultPosition,
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+      "rnbqkbnr/pppp1ppp/8/8/3Pp3/8/PPP1PPPP/RNBQKBNR b Kq d3 0 3",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 12 74",
+      "8/8/4k3/8/8/8/8/4K3 b - - 99 300",
+  };
+  for (const char* fen : fens) {
+    Position pos(fen);
+    Position unpacked = Position::Unpack(pos.Pack());
+    ASSERT_EQ(pos.AsFen(), unpacked.AsFen());
+    ASSERT_EQ(pos.ZobristHash(), unpacked.ZobristHash());
+    ASSERT_EQ(pos.Checkers().Bits(), unpacked.Checkers().Bits());
+    ASSERT_EQ(pos.MidgameScore(), unpacked.MidgameScore());
+    ASSERT_EQ(pos.EndgameScore(), unpacked.EndgameScore());
+    ASSERT_EQ(pos.Phase(), unpacked.Phase());
+  }
+}
+
+TEST(PositionPackTest, HalfmoveClockSaturates) {
+  Position pos("8/8/4k3/8/8/8/8/4K3 w - - 200 300");
+  ASSERT_EQ(127, Position::Unpack(pos.Pack()).HalfmoveClock());
+}
+
+TEST(PositionFenTest, FenToChars) {
+  const char* fen =
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+  Position pos(fen);
+  char buffer[apollo::kMaxFenLength];
+  std::to_chars_result result = pos.FenToChars(buffer, buffer + sizeof(buffer));
+  ASSERT_EQ(std::errc(), result.ec);
+  ASSERT_EQ(fen, std::string(buffer, result.ptr));
+
+  // Buffers smaller than kMaxFenLength work as long as the FEN fits.
+  size_t length = strlen(fen);
+  result = pos.FenToChars(buffer, buffer + length);
+  ASSERT_EQ(std::errc(), result.ec);
+  ASSERT_EQ(fen, std::string(buffer, result.ptr));
+  result = pos.FenToChars(buffer, buffer + length - 1);
+  ASSERT_EQ(std::errc::value_too_large, result.ec);
+}
+
+TEST(PositionFenTest, NoCastlingRights) {
+  const char* fen = "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 b - - 12 74";
+  ASSERT_EQ(fen, Position(fen).AsFen());
+}
+
+TEST(PositionFenTest, InvalidClocks) {
+  ASSERT_THROW(Position("8/8/4k3/8/8/8/8/4K3 w - - x 1"),
+               apollo::InvalidFenException);
+  ASSERT_THROW(Position("8/8/4k3/8/8/8/8/4K3 w - - -3 1"),
+               apollo::InvalidFenException);
+}
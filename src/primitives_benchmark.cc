@@ -0,0 +1,259 @@
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "benchmark/benchmark.h"
+
+#include "attacks.h"
+#include "bench.h"
+#include "evaluators/shannon_evaluator.h"
+#include "move_list.h"
+#include "movegen.h"
+#include "position.h"
+#include "zobrist.h"
+
+using apollo::Bitboard;
+using apollo::Color;
+using apollo::Move;
+using apollo::MoveList;
+using apollo::Position;
+using apollo::Square;
+
+namespace {
+
+/**
+ * The positions every benchmark runs over, which are those of the bench
+ * command. Each iteration of a benchmark operates on the next position (or
+ * move, or square) of the corpus in turn, so that reported times are per
+ * operation.
+ */
+const std::vector<Position>& Corpus() {
+  static const std::vector<Position> corpus = [] {
+    std::vector<Position> positions;
+    for (std::string_view fen : apollo::BenchPositions()) {
+      positions.emplace_back(fen);
+    }
+    return positions;
+  }();
+  return corpus;
+}
+
+/**
+ * Every legal move of every corpus position, paired with the index of its
+ * position.
+ */
+const std::vector<std::pair<size_t, Move>>& CorpusMoves() {
+  static const std::vector<std::pair<size_t, Move>> moves = [] {
+    std::vector<std::pair<size_t, Move>> all;
+    const std::vector<Position>& corpus = Corpus();
+    for (size_t i = 0; i < corpus.size(); i++) {
+      for (Move mov : corpus[i].PseudolegalMoves()) {
+        if (corpus[i].IsLegalGivenPseudolegal(mov)) {
+          all.emplace_back(i, mov);
+        }
+      }
+    }
+    return all;
+  }();
+  return moves;
+}
+
+/**
+ * Occupancies of the corpus positions, for the slider attack benchmarks.
+ */
+const std::vector<Bitboard>& CorpusOccupancies() {
+  static const std::vector<Bitboard> occupancies = [] {
+    std::vector<Bitboard> all;
+    for (const Position& pos : Corpus()) {
+      all.push_back(pos.Pieces(apollo::kWhite) | pos.Pieces(apollo::kBlack));
+    }
+    return all;
+  }();
+  return occupancies;
+}
+
+template <Bitboard (*Attacks)(Square, Bitboard)>
+void BM_SliderAttacks(benchmark::State& state) {
+  const std::vector<Bitboard>& occupancies = CorpusOccupancies();
+  size_t i = 0;
+  for (auto _ : state) {
+    Square sq = static_cast<Square>(i % 64);
+    benchmark::DoNotOptimize(Attacks(sq, occupancies[i / 64]));
+    if (++i == 64 * occupancies.size()) {
+      i = 0;
+    }
+  }
+}
+BENCHMARK_TEMPLATE(BM_SliderAttacks, apollo::attacks::BishopAttacks)
+    ->Name("BM_BishopAttacks");
+BENCHMARK_TEMPLATE(BM_SliderAttacks, apollo::attacks::RookAttacks)
+    ->Name("BM_RookAttacks");
+BENCHMARK_TEMPLATE(BM_SliderAttacks, apollo::attacks::QueenAttacks)
+    ->Name("BM_QueenAttacks");
+
+template <Bitboard (*Attacks)(Square)>
+void BM_LeaperAttacks(benchmark::State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Attacks(static_cast<Square>(i++ % 64)));
+  }
+}
+BENCHMARK_TEMPLATE(BM_LeaperAttacks, apollo::attacks::KnightAttacks)
+    ->Name("BM_KnightAttacks");
+BENCHMARK_TEMPLATE(BM_LeaperAttacks, apollo::attacks::KingAttacks)
+    ->Name("BM_KingAttacks");
+
+void BM_PawnAttacks(benchmark::State& state) {
+  size_t i = 0;
+  for (auto _ : state) {
+    Color side = i & 64 ? apollo::kBlack : apollo::kWhite;
+    benchmark::DoNotOptimize(
+        apollo::attacks::PawnAttacks(static_cast<Square>(i % 64), side));
+    i++;
+  }
+}
+BENCHMARK(BM_PawnAttacks);
+
+template <typename MoveContainer>
+void BM_GeneratePseudolegalMoves(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  MoveContainer moves;
+  size_t i = 0;
+  for (auto _ : state) {
+    moves.clear();
+    apollo::movegen::GeneratePseudolegalMoves(corpus[i], moves);
+    benchmark::DoNotOptimize(moves.size());
+    i = (i + 1) % corpus.size();
+  }
+}
+BENCHMARK_TEMPLATE(BM_GeneratePseudolegalMoves, std::vector<Move>);
+BENCHMARK_TEMPLATE(BM_GeneratePseudolegalMoves, MoveList);
+
+void BM_MakeUnmakeMove(benchmark::State& state) {
+  std::vector<Position> corpus = Corpus();
+  const std::vector<std::pair<size_t, Move>>& moves = CorpusMoves();
+  size_t i = 0;
+  for (auto _ : state) {
+    Position& pos = corpus[moves[i].first];
+    pos.MakeMove(moves[i].second);
+    pos.UnmakeMove();
+    i = (i + 1) % moves.size();
+  }
+}
+BENCHMARK(BM_MakeUnmakeMove);
+
+void BM_IsLegalGivenPseudolegal(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  std::vector<std::pair<size_t, Move>> moves;
+  for (size_t i = 0; i < corpus.size(); i++) {
+    for (Move mov : corpus[i].PseudolegalMoves()) {
+      moves.emplace_back(i, mov);
+    }
+  }
+
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        corpus[moves[i].first].IsLegalGivenPseudolegal(moves[i].second));
+    i = (i + 1) % moves.size();
+  }
+}
+BENCHMARK(BM_IsLegalGivenPseudolegal);
+
+void BM_SquaresAttacking(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  size_t i = 0;
+  for (auto _ : state) {
+    const Position& pos = corpus[i / 64];
+    benchmark::DoNotOptimize(
+        pos.SquaresAttacking(pos.SideToMove(), static_cast<Square>(i % 64)));
+    if (++i == 64 * corpus.size()) {
+      i = 0;
+    }
+  }
+}
+BENCHMARK(BM_SquaresAttacking);
+
+void BM_ZobristHash(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(apollo::zobrist::Hash(corpus[i]));
+    i = (i + 1) % corpus.size();
+  }
+}
+BENCHMARK(BM_ZobristHash);
+
+void BM_ParseFen(benchmark::State& state) {
+  const std::vector<std::string_view>& fens = apollo::BenchPositions();
+  size_t i = 0;
+  for (auto _ : state) {
+    Position pos(fens[i]);
+    benchmark::DoNotOptimize(pos);
+    i = (i + 1) % fens.size();
+  }
+}
+BENCHMARK(BM_ParseFen);
+
+void BM_AsFen(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  size_t i = 0;
+  for (auto _ : state) {
+    std::string fen = corpus[i].AsFen();
+    benchmark::DoNotOptimize(fen);
+    i = (i + 1) % corpus.size();
+  }
+}
+BENCHMARK(BM_AsFen);
+
+void BM_FenToChars(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  char buffer[apollo::kMaxFenLength];
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        corpus[i].FenToChars(buffer, buffer + sizeof(buffer)).ptr);
+    benchmark::ClobberMemory();
+    i = (i + 1) % corpus.size();
+  }
+}
+BENCHMARK(BM_FenToChars);
+
+void BM_Pack(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(corpus[i].Pack());
+    i = (i + 1) % corpus.size();
+  }
+}
+BENCHMARK(BM_Pack);
+
+void BM_Unpack(benchmark::State& state) {
+  std::vector<apollo::PackedPosition> packed;
+  for (const Position& pos : Corpus()) {
+    packed.push_back(pos.Pack());
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    Position pos = Position::Unpack(packed[i]);
+    benchmark::DoNotOptimize(pos);
+    i = (i + 1) % packed.size();
+  }
+}
+BENCHMARK(BM_Unpack);
+
+void BM_ShannonEvaluate(benchmark::State& state) {
+  const std::vector<Position>& corpus = Corpus();
+  apollo::evaluators::ShannonEvaluator evaluator;
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(evaluator.Evaluate(corpus[i]));
+    i = (i + 1) % corpus.size();
+  }
+}
+BENCHMARK(BM_ShannonEvaluate);
+
+}  // anonymous namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,210 @@
+#include <array>
+
+#include "psqt.h"
+
+namespace apollo::psqt {
+
+namespace {
+
+using SquareTable = std::array<int, kSquareLast>;
+
+// The piece-square tables below are written from white's point of view and
+// laid out the way a board is printed: the first row is the eighth rank and
+// the last row is the first rank. PsqtTable flips them into square order.
+
+constexpr std::array<int, kPieceLast> kMidgameMaterial = {
+    82, 337, 365, 477, 1025, 0,
+};
+
+constexpr std::array<int, kPieceLast> kEndgameMaterial = {
+    94, 281, 297, 512, 936, 0,
+};
+
+constexpr std::array<int, kPieceLast> kPhaseWeights = {0, 1, 1, 2, 4, 0};
+
+// clang-format off
+constexpr SquareTable kPawnMidgame = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     60,  70,  60,  70,  70,  60,  70,  60,
+     10,  15,  25,  35,  35,  25,  15,  10,
+      0,   5,  10,  25,  25,  10,   5,   0,
+     -5,   0,   5,  20,  20,   5,   0,  -5,
+     -5,  -5,   0,   5,   5,   0,  -5,  -5,
+     -5,   5,   5, -15, -15,   5,   5,  -5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+constexpr SquareTable kPawnEndgame = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+    150, 145, 135, 125, 125, 135, 145, 150,
+     90,  90,  80,  70,  70,  80,  90,  90,
+     35,  30,  20,  15,  15,  20,  30,  35,
+     15,  10,   5,   0,   0,   5,  10,  15,
+      5,   5,   0,   0,   0,   0,   5,   5,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+constexpr SquareTable kKnightMidgame = {
+    -60, -40, -30, -30, -30, -30, -40, -60,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   5,  20,  25,  25,  20,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -60, -30, -30, -30, -30, -30, -30, -60,
+};
+
+constexpr SquareTable kKnightEndgame = {
+    -50, -35, -25, -20, -20, -25, -35, -50,
+    -35, -15,  -5,   0,   0,  -5, -15, -35,
+    -25,  -5,  10,  15,  15,  10,  -5, -25,
+    -20,   0,  15,  20,  20,  15,   0, -20,
+    -20,   0,  15,  20,  20,  15,   0, -20,
+    -25,  -5,  10,  15,  15,  10,  -5, -25,
+    -35, -15,  -5,   0,   0,  -5, -15, -35,
+    -50, -35, -25, -20, -20, -25, -35, -50,
+};
+
+constexpr SquareTable kBishopMidgame = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,  15,   0,   0,   0,   0,  15, -10,
+    -20, -10, -15, -10, -10, -15, -10, -20,
+};
+
+constexpr SquareTable kBishopEndgame = {
+    -15, -10, -10,  -5,  -5, -10, -10, -15,
+    -10,  -5,   0,   0,   0,   0,  -5, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,  10,  10,   5,   0,  -5,
+     -5,   0,   5,  10,  10,   5,   0,  -5,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+    -10,  -5,   0,   0,   0,   0,  -5, -10,
+    -15, -10, -10,  -5,  -5, -10, -10, -15,
+};
+
+constexpr SquareTable kRookMidgame = {
+      5,  10,  10,  10,  10,  10,  10,   5,
+     15,  20,  20,  20,  20,  20,  20,  15,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+    -10,  -5,   0,   0,   0,   0,  -5, -10,
+     -5,   0,   5,  10,  10,   5,   0,  -5,
+};
+
+constexpr SquareTable kRookEndgame = {
+     10,  10,  10,  10,  10,  10,  10,  10,
+     10,  10,  10,  10,  10,  10,  10,  10,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+     -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,
+     -5,  -5,  -5,  -5,  -5,  -5,  -5,  -5,
+    -10,  -5,   0,   0,   0,   0,  -5, -10,
+};
+
+constexpr SquareTable kQueenMidgame = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,   0,  -5, -10, -10, -20,
+};
+
+constexpr SquareTable kQueenEndgame = {
+    -10,  -5,  -5,   0,   0,  -5,  -5, -10,
+     -5,   5,   5,  10,  10,   5,   5,  -5,
+     -5,   5,  10,  15,  15,  10,   5,  -5,
+      0,  10,  15,  20,  20,  15,  10,   0,
+      0,  10,  15,  20,  20,  15,  10,   0,
+     -5,   5,  10,  15,  15,  10,   5,  -5,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+    -10,  -5,  -5,  -5,  -5,  -5,  -5, -10,
+};
+
+constexpr SquareTable kKingMidgame = {
+    -40, -50, -50, -60, -60, -50, -50, -40,
+    -40, -50, -50, -60, -60, -50, -50, -40,
+    -40, -50, -50, -60, -60, -50, -50, -40,
+    -40, -50, -50, -60, -60, -50, -50, -40,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+     10,  10, -10, -20, -20, -10,  10,  10,
+     20,  30,  10, -10,   0, -10,  30,  20,
+};
+
+constexpr SquareTable kKingEndgame = {
+    -50, -35, -25, -20, -20, -25, -35, -50,
+    -30, -15,   0,   5,   5,   0, -15, -30,
+    -25,   0,  15,  25,  25,  15,   0, -25,
+    -20,   5,  25,  35,  35,  25,   5, -20,
+    -20,   5,  25,  35,  35,  25,   5, -20,
+    -25,   0,  15,  25,  25,  15,   0, -25,
+    -30, -15,   0,   5,   5,   0, -15, -30,
+    -50, -35, -25, -20, -20, -25, -35, -50,
+};
+// clang-format on
+
+class PsqtTable {
+ public:
+  constexpr PsqtTable(const std::array<int, kPieceLast>& material,
+                      const std::array<SquareTable, kPieceLast>& tables)
+      : table_() {
+    for (int kind = kPawn; kind < kPieceLast; kind++) {
+      for (int i = A1; i < kSquareLast; i++) {
+        // White reads the printed table upside down, so flip the rank of the
+        // square. Black sees the board from the other side, so the printed
+        // layout already matches its square order.
+        int value_white = material[kind] + tables[kind][i ^ 56];
+        int value_black = material[kind] + tables[kind][i];
+        table_[kWhite][kind][i] = value_white;
+        table_[kBlack][kind][i] = -value_black;
+      }
+    }
+  }
+
+  int Value(Piece piece, Square sq) const {
+    return table_[piece.color()][piece.kind()][static_cast<size_t>(sq)];
+  }
+
+ private:
+  std::array<std::array<SquareTable, kPieceLast>, kColorLast> table_;
+};
+
+constexpr PsqtTable kMidgameTable = PsqtTable(
+    kMidgameMaterial, {kPawnMidgame, kKnightMidgame, kBishopMidgame,
+                       kRookMidgame, kQueenMidgame, kKingMidgame});
+
+constexpr PsqtTable kEndgameTable = PsqtTable(
+    kEndgameMaterial, {kPawnEndgame, kKnightEndgame, kBishopEndgame,
+                       kRookEndgame, kQueenEndgame, kKingEndgame});
+
+}  // anonymous namespace
+
+int Midgame(Piece piece, Square sq) { return kMidgameTable.Value(piece, sq); }
+
+int Endgame(Piece piece, Square sq) { return kEndgameTable.Value(piece, sq); }
+
+int Phase(PieceKind kind) { return kPhaseWeights[static_cast<size_t>(kind)]; }
+
+void Accumulate(const Piece* pieces, const Square* squares, int count,
+                int& midgame, int& endgame, int& phase) {
+  for (int i = 0; i < count; i++) {
+    midgame += kMidgameTable.Value(pieces[i], squares[i]);
+    endgame += kEndgameTable.Value(pieces[i], squares[i]);
+    phase += kPhaseWeights[static_cast<size_t>(pieces[i].kind())];
+  }
+}
+
+}  // namespace apollo::psqt
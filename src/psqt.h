@@ -0,0 +1,42 @@
+#pragma once
+
+#include "piece.h"
+#include "types.h"
+
+namespace apollo::psqt {
+
+/**
+ * The game phase of a position with all of its non-pawn material on the
+ * board. The phase of a position decreases towards zero as pieces are
+ * traded off, and evaluators use it to blend midgame and endgame scores.
+ */
+constexpr int kPhaseMax = 24;
+
+/**
+ * Returns the midgame value, in centipawns, of the given piece standing on
+ * the given square. The value includes both the material value of the piece
+ * and its piece-square bonus and is signed so that it is positive for white
+ * pieces and negative for black pieces.
+ */
+int Midgame(Piece piece, Square sq);
+
+/**
+ * Returns the endgame value, in centipawns, of the given piece standing on the
+ * given square. Signed in the same way as Midgame.
+ */
+int Endgame(Piece piece, Square sq);
+
+/**
+ * Adds the midgame values, endgame values and phase contributions of the
+ * given pieces standing on the given squares to the given totals.
+ */
+void Accumulate(const Piece* pieces, const Square* squares, int count,
+                int& midgame, int& endgame, int& phase);
+
+/**
+ * Returns the amount that the given kind of piece contributes to the game
+ * phase.
+ */
+int Phase(PieceKind kind);
+
+}  // namespace apollo::psqt
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "json.hpp"
+#include "position.h"
+#include "search/batch_analyzer.h"
+
+using nlohmann::json;
+
+namespace apollo::search {
+
+namespace {
+
+// How many positions may be read ahead of the oldest unwritten result, per
+// thread. This bounds memory when one position takes much longer than the
+// ones after it.
+const uint64_t kMaxInFlightPerThread = 64;
+
+bool IsNumber(const std::string& token) {
+  if (token.empty()) {
+    return false;
+  }
+  for (char c : token) {
+    if (!std::isdigit(static_cast<unsigned char>(c))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Returns the position fields of a FEN or EPD line: all six fields of a FEN,
+ * or the first four fields of an EPD.
+ */
+std::string PositionFields(const std::string& line) {
+  std::istringstream stream(line);
+  std::vector<std::string> fields;
+  std::string field;
+  while (fields.size() < 6 && stream >> field) {
+    fields.push_back(field);
+  }
+
+  size_t count = 4;
+  if (fields.size() == 6 && IsNumber(fields[4]) && IsNumber(fields[5])) {
+    count = 6;
+  }
+
+  std::string fen;
+  for (size_t i = 0; i < count && i < fields.size(); i++) {
+    if (i != 0) {
+      fen += ' ';
+    }
+    fen += fields[i];
+  }
+  return fen;
+}
+
+}  // anonymous namespace
+
+BatchAnalyzer::BatchAnalyzer(int threads, int depth,
+                             SearcherFactory make_searcher)
+    : threads_(std::max(threads, 1)),
+      depth_(depth),
+      make_searcher_(std::move(make_searcher)),
+      next_input_(0),
+      next_output_(0),
+      done_reading_(false),
+      out_(nullptr) {}
+
+void BatchAnalyzer::Run(std::istream& in, std::ostream& out) {
+  out_ = &out;
+  next_input_ = 0;
+  next_output_ = 0;
+  done_reading_ = false;
+
+  // Searchers are made up front, on this thread, so that the factory needn't
+  // be thread-safe.
+  std::vector<std::unique_ptr<Searcher>> searchers;
+  for (int i = 0; i < threads_; i++) {
+    searchers.push_back(make_searcher_());
+  }
+
+  std::vector<std::thread> workers;
+  for (auto& searcher : searchers) {
+    workers.emplace_back([this, &searcher] { Work(*searcher); });
+  }
+
+  const uint64_t max_in_flight = kMaxInFlightPerThread * threads_;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') {
+      continue;
+    }
+
+    std::unique_lock lock(lock_);
+    space_available_.wait(
+        lock, [&] { return next_input_ - next_output_ < max_in_flight; });
+    jobs_.push_back({next_input_++, std::move(line)});
+    work_available_.notify_one();
+  }
+
+  {
+    std::lock_guard lock(lock_);
+    done_reading_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  out_ = nullptr;
+}
+
+void BatchAnalyzer::Work(Searcher& searcher) {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock lock(lock_);
+      work_available_.wait(lock,
+                           [&] { return !jobs_.empty() || done_reading_; });
+      if (jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+
+    Finish(job.index, Analyze(searcher, job.line));
+  }
+}
+
+std::string BatchAnalyzer::Analyze(Searcher& searcher,
+                                   const std::string& line) {
+  std::string fen = PositionFields(line);
+  json result = {{"fen", fen}};
+  try {
+    Position pos(fen);
+    if (pos.Kings(kWhite).Count() != 1 || pos.Kings(kBlack).Count() != 1 ||
+        pos.IsCheck(!pos.SideToMove())) {
+      // The search assumes one king per side and that the side to move can't
+      // capture a king.
+      result["error"] = "illegal position";
+      return result.dump();
+    }
+
+    SearchResult search = searcher.Search(pos, depth_);
+    if (search.best_move.IsNull()) {
+      result["best_move"] = nullptr;
+    } else {
+      result["best_move"] = search.best_move.AsUci();
+    }
+    result["score"] = search.score;
+    if (!search.stats.iterations.empty() &&
+        search.stats.iterations.back().lines.size() > 1) {
+      json lines = json::array();
+      for (const PvLine& pv : search.stats.iterations.back().lines) {
+        lines.push_back({{"move", pv.move.AsUci()}, {"score", pv.score}});
+      }
+      result["lines"] = lines;
+    }
+    result["nodes"] = search.stats.nodes;
+    result["seconds"] = search.stats.seconds;
+  } catch (const InvalidFenException&) {
+    result["error"] = "invalid position";
+  }
+  return result.dump();
+}
+
+void BatchAnalyzer::Finish(uint64_t index, std::string result) {
+  std::lock_guard lock(lock_);
+  finished_.emplace(index, std::move(result));
+  bool wrote = false;
+  for (auto it = finished_.begin();
+       it != finished_.end() && it->first == next_output_;
+       it = finished_.erase(it)) {
+    *out_ << it->second << '\n';
+    next_output_++;
+    wrote = true;
+  }
+
+  if (wrote) {
+    out_->flush();
+    space_available_.notify_one();
+  }
+}
+
+}  // namespace apollo::search
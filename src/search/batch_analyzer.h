@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "search/searcher.h"
+
+namespace apollo::search {
+
+/**
+ * A BatchAnalyzer searches a stream of positions on a pool of worker threads
+ * and writes one JSON object per position, in input order:
+ *
+ *   {"fen": ..., "best_move": ..., "score": ..., "nodes": ..., "seconds": ...}
+ *
+ * A searcher set up for several lines (MultiPV) adds them too, best first, as
+ * "lines": [{"move": ..., "score": ...}, ...].
+ *
+ * Input lines are FENs or EPDs; the operations of an EPD are ignored. Blank
+ * lines and lines starting with '#' are skipped. A line that isn't a valid
+ * or legal position produces {"fen": ..., "error": ...} instead.
+ *
+ * Every worker has its own Searcher, and so its own caches. Positions are
+ * read as they are needed, so the input can be arbitrarily long.
+ */
+class BatchAnalyzer {
+ public:
+  using SearcherFactory = std::function<std::unique_ptr<Searcher>()>;
+
+  BatchAnalyzer(int threads, int depth, SearcherFactory make_searcher);
+
+  /**
+   * Analyzes every position read from in, writing the results to out.
+   * Returns once every result has been written.
+   */
+  void Run(std::istream& in, std::ostream& out);
+
+ private:
+  struct Job {
+    uint64_t index;
+    std::string line;
+  };
+
+  void Work(Searcher& searcher);
+  std::string Analyze(Searcher& searcher, const std::string& line);
+  void Finish(uint64_t index, std::string result);
+
+  int threads_;
+  int depth_;
+  SearcherFactory make_searcher_;
+
+  std::mutex lock_;
+  std::condition_variable work_available_;
+  std::condition_variable space_available_;
+  std::deque<Job> jobs_;
+
+  // Results that are done but can't be written until the ones before them
+  // are.
+  std::map<uint64_t, std::string> finished_;
+  uint64_t next_input_;
+  uint64_t next_output_;
+  bool done_reading_;
+  std::ostream* out_;
+};
+
+}  // namespace apollo::search
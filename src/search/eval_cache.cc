@@ -0,0 +1,63 @@
+#include <cstring>
+
+#include "search/eval_cache.h"
+
+namespace apollo::search {
+
+EvalCache::EvalCache(size_t entries)
+    : entries_(), mask_(0), hits_(0), misses_(0) {
+  Resize(entries);
+}
+
+bool EvalCache::Probe(uint64_t hash, double& value) {
+  if (entries_.empty()) {
+    misses_++;
+    return false;
+  }
+
+  const Entry& entry = entries_[hash & mask_];
+  if ((entry.check ^ entry.data) != hash) {
+    misses_++;
+    return false;
+  }
+
+  std::memcpy(&value, &entry.data, sizeof(value));
+  hits_++;
+  return true;
+}
+
+void EvalCache::Store(uint64_t hash, double value) {
+  if (entries_.empty()) {
+    return;
+  }
+
+  uint64_t data;
+  std::memcpy(&data, &value, sizeof(data));
+  Entry& entry = entries_[hash & mask_];
+  entry.check = hash ^ data;
+  entry.data = data;
+}
+
+void EvalCache::Resize(size_t entries) {
+  size_t size = 0;
+  if (entries != 0) {
+    // Round down to a power of two, so that indexing is a mask.
+    size = size_t(1) << (63 - __builtin_clzll(entries));
+  }
+
+  entries_.assign(size, Entry());
+  mask_ = size == 0 ? 0 : size - 1;
+  Clear();
+}
+
+void EvalCache::Clear() {
+  // An all-zero entry would read as an evaluation of 0.0 for the position
+  // with hash zero. Instead, give each empty entry a key that can never be
+  // stored in its slot.
+  for (size_t i = 0; i < entries_.size(); i++) {
+    entries_[i].check = ~static_cast<uint64_t>(i);
+    entries_[i].data = 0;
+  }
+}
+
+}  // namespace apollo::search
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace apollo::search {
+
+/**
+ * An EvalCache is a hash table of recent static evaluations, keyed by
+ * Zobrist hash. The search evaluates the same leaves many times over through
+ * transpositions and repeated searches of the same position, and looking an
+ * evaluation up is much cheaper than recomputing it.
+ *
+ * The cache is direct-mapped and always replaces. Each entry stores its key
+ * XOR'd with its data, so a torn write from a concurrent writer shows up as a
+ * miss rather than as a bogus evaluation; the cache needs no locks even if it
+ * is ever shared between threads.
+ */
+class EvalCache {
+ public:
+  /**
+   * Constructs a cache with room for the given number of entries, rounded
+   * down to a power of two. A cache of zero entries is disabled and always
+   * misses.
+   */
+  explicit EvalCache(size_t entries);
+
+  /**
+   * Returns the number of entries that fit in the given number of bytes.
+   */
+  static size_t EntriesInBytes(size_t bytes) { return bytes / sizeof(Entry); }
+
+  /**
+   * Looks up the evaluation of the position with the given hash, storing it
+   * in value and returning true if present.
+   */
+  bool Probe(uint64_t hash, double& value);
+
+  /**
+   * Records the evaluation of the position with the given hash.
+   */
+  void Store(uint64_t hash, double value);
+
+  /**
+   * Resizes the cache, discarding all entries.
+   */
+  void Resize(size_t entries);
+
+  /**
+   * Discards all entries, but keeps the cache's size.
+   */
+  void Clear();
+
+  /**
+   * Resets the hit and miss counters.
+   */
+  void ResetStats() {
+    hits_ = 0;
+    misses_ = 0;
+  }
+
+  size_t Size() const { return entries_.size(); }
+  uint64_t Hits() const { return hits_; }
+  uint64_t Misses() const { return misses_; }
+
+ private:
+  struct Entry {
+    uint64_t check;
+    uint64_t data;
+  };
+
+  std::vector<Entry> entries_;
+  uint64_t mask_;
+  uint64_t hits_;
+  uint64_t misses_;
+};
+
+}  // namespace apollo::search
@@ -0,0 +1,58 @@
+#include <array>
+#include <utility>
+
+#include "movegen.h"
+#include "search/move_picker.h"
+
+namespace apollo::search {
+
+namespace {
+
+// Captures score above every promotion and quiet move. Within them, the
+// victim dominates and the attacker breaks ties.
+constexpr int kCaptureScore = 1024;
+constexpr std::array<int, kPieceLast> kVictimScore = {100, 300, 300,
+                                                      500, 900, 0};
+constexpr std::array<int, kPieceLast> kAttackerScore = {5, 4, 3, 2, 1, 0};
+
+int16_t ScoreMove(const Position& pos, Move mov) {
+  int score = 0;
+  if (mov.IsCapture()) {
+    PieceKind victim =
+        mov.IsEnPassant() ? kPawn : pos.PieceAt(mov.Destination())->kind();
+    PieceKind attacker = pos.PieceAt(mov.Source())->kind();
+    score += kCaptureScore + kVictimScore[victim] + kAttackerScore[attacker];
+  }
+  if (mov.IsPromotion()) {
+    score += kVictimScore[mov.PromotionPiece()];
+  }
+  return static_cast<int16_t>(score);
+}
+
+}  // anonymous namespace
+
+MovePicker::MovePicker(const Position& pos) : moves_(), cursor_(0) {
+  movegen::GeneratePseudolegalMoves(pos, moves_);
+  for (ScoredMove& scored : moves_) {
+    scored.score = ScoreMove(pos, scored.move);
+  }
+}
+
+bool MovePicker::Next(Move& mov) {
+  if (cursor_ == moves_.size()) {
+    return false;
+  }
+
+  size_t best = cursor_;
+  for (size_t i = cursor_ + 1; i < moves_.size(); i++) {
+    if (moves_[i].score > moves_[best].score) {
+      best = i;
+    }
+  }
+
+  std::swap(moves_[cursor_], moves_[best]);
+  mov = moves_[cursor_++].move;
+  return true;
+}
+
+}  // namespace apollo::search
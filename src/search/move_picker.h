@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+#include "move.h"
+#include "move_list.h"
+#include "position.h"
+
+namespace apollo::search {
+
+/**
+ * A MovePicker hands out the pseudolegal moves of a position, best first.
+ * Captures come first, ordered most valuable victim, least valuable attacker
+ * (MVV-LVA), then promotions and then quiet moves.
+ *
+ * Moves are scored once up front and picked with a partial selection sort,
+ * which only sorts as far as the search gets before a cutoff.
+ */
+class MovePicker {
+ public:
+  explicit MovePicker(const Position& pos);
+
+  /**
+   * Stores the best move that hasn't been picked yet in mov and returns true,
+   * or returns false if every move has been picked.
+   */
+  bool Next(Move& mov);
+
+ private:
+  MoveList moves_;
+  size_t cursor_;
+};
+
+}  // namespace apollo::search
@@ -0,0 +1,44 @@
+#include "json.hpp"
+#include "search/search_stats.h"
+
+using nlohmann::json;
+
+namespace apollo::search {
+
+std::string SearchStats::ToJson() const {
+  json iterations_json = json::array();
+  for (const IterationStats& iteration : iterations) {
+    json lines_json = json::array();
+    for (const PvLine& line : iteration.lines) {
+      lines_json.push_back(
+          {{"move", line.move.AsUci()}, {"score", line.score}});
+    }
+    iterations_json.push_back({
+        {"depth", iteration.depth},
+        {"seldepth", iteration.seldepth},
+        {"best_move", iteration.best_move.AsUci()},
+        {"score", iteration.score},
+        {"nodes", iteration.nodes},
+        {"seconds", iteration.seconds},
+        {"lines", lines_json},
+    });
+  }
+
+  json doc = {
+      {"nodes", nodes},
+      {"qnodes", qnodes},
+      {"nps", Nps()},
+      {"seconds", seconds},
+      {"seldepth", seldepth},
+      {"beta_cutoffs", beta_cutoffs},
+      {"first_move_cutoffs", first_move_cutoffs},
+      {"first_move_cutoff_rate", FirstMoveCutoffRate()},
+      {"eval_cache",
+       {{"hits", eval_cache_hits}, {"misses", eval_cache_misses}}},
+      {"tb_hits", tb_hits},
+      {"iterations", iterations_json},
+  };
+  return doc.dump();
+}
+
+}  // namespace apollo::search
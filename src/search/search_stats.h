@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "move.h"
+
+namespace apollo::search {
+
+/**
+ * A root move and its exact score.
+ */
+struct PvLine {
+  Move move;
+  double score;
+};
+
+/**
+ * Statistics for one iteration of iterative deepening.
+ */
+struct IterationStats {
+  int depth;
+  int seldepth;
+  Move best_move;
+  double score;
+
+  // Nodes searched and time spent by this iteration alone.
+  uint64_t nodes;
+  double seconds;
+
+  // The best lines of a MultiPV search, best first. A search for a single
+  // line has just the best move and its score here.
+  std::vector<PvLine> lines;
+};
+
+/**
+ * Counters collected over a single search.
+ */
+struct SearchStats {
+  // Every node visited, including the quiescence nodes counted in qnodes.
+  uint64_t nodes = 0;
+  uint64_t qnodes = 0;
+
+  // Beta cutoffs, and how many of them the first move searched produced. The
+  // ratio of the two measures how well moves are ordered.
+  uint64_t beta_cutoffs = 0;
+  uint64_t first_move_cutoffs = 0;
+
+  uint64_t eval_cache_hits = 0;
+  uint64_t eval_cache_misses = 0;
+
+  // Positions whose result came from the endgame tablebases.
+  uint64_t tb_hits = 0;
+
+  // The deepest ply reached by any line, including quiescence.
+  int seldepth = 0;
+
+  double seconds = 0;
+  std::vector<IterationStats> iterations;
+
+  /**
+   * Returns the fraction of beta cutoffs caused by the first move searched,
+   * or zero if there were none.
+   */
+  double FirstMoveCutoffRate() const {
+    return beta_cutoffs == 0 ? 0.0
+                             : static_cast<double>(first_move_cutoffs) /
+                                   static_cast<double>(beta_cutoffs);
+  }
+
+  /**
+   * Returns the nodes searched per second.
+   */
+  double Nps() const { return seconds == 0 ? 0.0 : nodes / seconds; }
+
+  /**
+   * Returns these statistics as a JSON object.
+   */
+  std::string ToJson() const;
+};
+
+}  // namespace apollo::search
@@ -1,53 +1,315 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <limits>
+#include <optional>
+#include <vector>
 
+#include "evaluators/nnue_evaluator.h"
+#include "evaluators/shannon_evaluator.h"
+#include "evaluators/tapered_evaluator.h"
 #include "log.h"
+#include "search/move_picker.h"
 #include "searcher.h"
 
 namespace apollo::search {
 
-SearchResult Searcher::Search(Position& pos, int depth) {
-  nodes_ = 0;
+/**
+ * SearchCore is the search proper, specialized on the type of its evaluator.
+ * A SearchCore lives for a single search.
+ */
+template <typename Evaluator>
+class SearchCore {
+ public:
+  SearchCore(const Evaluator& evaluator, EvalCache& eval_cache,
+             const tablebase::Prober* tablebases, int multi_pv,
+             const SearchLimits& limits, const IterationCallback& on_iteration)
+      : evaluator_(evaluator),
+        eval_cache_(eval_cache),
+        tablebases_(tablebases),
+        multi_pv_(multi_pv),
+        limits_(limits),
+        on_iteration_(on_iteration),
+        start_(Clock::now()),
+        stopped_(false),
+        stats_() {}
+
+  static SearchResult Run(Searcher& searcher, Position& pos,
+                          const SearchLimits& limits,
+                          const IterationCallback& on_iteration) {
+    const Evaluator& evaluator =
+        static_cast<const Evaluator&>(*searcher.evaluator_);
+    SearchCore core(evaluator, searcher.eval_cache_,
+                    searcher.tablebases_.get(), searcher.multi_pv_, limits,
+                    on_iteration);
+    return core.Search(pos);
+  }
+
+  SearchResult Search(Position& pos);
+
+ private:
+  bool FilterRootMoves(Position& pos, std::vector<Move>& root_moves);
+  std::optional<tablebase::Wdl> ProbeWdl(const Position& pos);
+  double SearchRoot(Position& pos, std::vector<Move>& root_moves, size_t first,
+                    int depth);
+  double AlphaBeta(Position& pos, double alpha, double beta, int depth,
+                   int ply);
+  double Quiesce(Position& pos, double alpha, double beta, int ply);
+  double Evaluate(const Position& pos);
+
+  using Clock = std::chrono::steady_clock;
+
+  double Elapsed() const {
+    std::chrono::duration<double> elapsed = Clock::now() - start_;
+    return elapsed.count();
+  }
+
+  // Returns whether the search has reached one of its limits, checking the
+  // clock only every so often since reading it isn't free.
+  bool ShouldStop() {
+    if (stopped_ || stats_.iterations.empty()) {
+      return stopped_;
+    }
+    if (limits_.nodes != 0 && stats_.nodes >= limits_.nodes) {
+      stopped_ = true;
+    } else if (limits_.seconds > 0 && (stats_.nodes & 1023) == 0 &&
+               Elapsed() >= limits_.seconds) {
+      stopped_ = true;
+    }
+    return stopped_;
+  }
+
+  const Evaluator& evaluator_;
+  EvalCache& eval_cache_;
+  const tablebase::Prober* tablebases_;
+  int multi_pv_;
+  const SearchLimits& limits_;
+  const IterationCallback& on_iteration_;
+  Clock::time_point start_;
+  bool stopped_;
+  SearchStats stats_;
+};
+
+template <typename Evaluator>
+SearchResult SearchCore<Evaluator>::Search(Position& pos) {
+  eval_cache_.ResetStats();
+  evaluator_.BeginSearch(pos);
+
+  // The legal root moves are generated once, in the move picker's order.
+  // Every iteration after the first searches the best move of the iteration
+  // before it first.
+  std::vector<Move> root_moves;
+  MovePicker picker(pos);
+  Move mov;
+  while (picker.Next(mov)) {
+    if (pos.IsLegalGivenPseudolegal(mov)) {
+      root_moves.push_back(mov);
+    }
+  }
+  if (tablebases_ && FilterRootMoves(pos, root_moves)) {
+    // Every move left keeps the best result. Probing below the root would
+    // score them all alike, so the evaluator is left to choose between them
+    // and make progress.
+    tablebases_ = nullptr;
+  }
+
   Move best_move = Move::Null();
-  bool seen_a_legal_move = false;
   double best_score = -std::numeric_limits<double>::infinity();
-  double alpha = best_score;
-  double beta = -best_score;
-  for (Move mov : pos.PseudolegalMoves()) {
-    if (!pos.IsLegalGivenPseudolegal(mov)) {
-      continue;
+  for (int iteration_depth = 1;
+       iteration_depth <= std::max(limits_.depth, 1) && !root_moves.empty();
+       iteration_depth++) {
+    Clock::time_point iteration_start = Clock::now();
+    uint64_t nodes_before = stats_.nodes;
+
+    // Each line is the best of the root moves that the lines before it
+    // didn't choose, searched with a full window so that its score is exact.
+    std::vector<PvLine> lines;
+    size_t line_count = std::min<size_t>(multi_pv_, root_moves.size());
+    for (size_t line = 0; line < line_count && !stopped_; line++) {
+      double score = SearchRoot(pos, root_moves, line, iteration_depth);
+      lines.push_back({root_moves[line], score});
+    }
+    if (stopped_) {
+      break;
     }
 
-    pos.MakeMove(mov);
-    double score = -AlphaBeta(pos, -beta, -alpha, depth - 1);
+    best_score = lines.front().score;
+    best_move = root_moves.front();
+
+    std::chrono::duration<double> elapsed = Clock::now() - iteration_start;
+    stats_.iterations.push_back({iteration_depth, stats_.seldepth, best_move,
+                                 best_score, stats_.nodes - nodes_before,
+                                 elapsed.count(), std::move(lines)});
+    if (on_iteration_) {
+      on_iteration_(stats_.iterations.back());
+    }
+  }
+
+  evaluator_.EndSearch(pos);
+  stats_.seconds = Elapsed();
+  stats_.eval_cache_hits = eval_cache_.Hits();
+  stats_.eval_cache_misses = eval_cache_.Misses();
+  return {best_move, best_score, stats_};
+}
+
+template <typename Evaluator>
+std::optional<tablebase::Wdl> SearchCore<Evaluator>::ProbeWdl(
+    const Position& pos) {
+  Bitboard pieces = pos.Pieces(kWhite) | pos.Pieces(kBlack);
+  if (pieces.Count() > tablebases_->MaxPieces()) {
+    return {};
+  }
+  for (Color color : kColors) {
+    if (pos.CanCastleKingside(color) || pos.CanCastleQueenside(color)) {
+      return {};
+    }
+  }
+  std::optional<tablebase::Wdl> wdl = tablebases_->ProbeWdl(pos);
+  if (wdl) {
+    stats_.tb_hits++;
+  }
+  return wdl;
+}
+
+template <typename Evaluator>
+bool SearchCore<Evaluator>::FilterRootMoves(Position& pos,
+                                            std::vector<Move>& root_moves) {
+  // The result of each move, from the point of view of the side to move at
+  // the root, and the distance to zeroing the halfmove clock after it.
+  struct RootResult {
+    Move move;
+    int wdl;
+    int dtz;
+  };
+  std::vector<RootResult> results;
+  for (Move root_move : root_moves) {
+    pos.MakeMove(root_move);
+    std::optional<tablebase::Wdl> wdl = ProbeWdl(pos);
+    std::optional<int> dtz;
+    if (wdl && *wdl != tablebase::kWdlDraw) {
+      dtz = tablebases_->ProbeDtz(pos);
+    }
     pos.UnmakeMove();
+    if (!wdl) {
+      // Unless every move is known, the search decides.
+      return false;
+    }
+
+    // A move that zeroes the halfmove clock resets the distance, and the
+    // distance of a move is measured from the position before it.
+    int distance = dtz ? std::abs(*dtz) + 1 : 0;
+    if (root_move.IsCapture() ||
+        pos.PieceAt(root_move.Source())->kind() == kPawn) {
+      distance = 1;
+    }
+    results.push_back({root_move, -*wdl, distance});
+  }
+  if (results.empty()) {
+    return false;
+  }
+
+  // Keep the moves with the best result. Among winning moves, prefer the
+  // quickest to make progress, and among losing moves the slowest.
+  int best_wdl = std::max_element(results.begin(), results.end(),
+                                  [](const RootResult& a, const RootResult& b) {
+                                    return a.wdl < b.wdl;
+                                  })
+                     ->wdl;
+  results.erase(std::remove_if(results.begin(), results.end(),
+                               [&](const RootResult& result) {
+                                 return result.wdl != best_wdl;
+                               }),
+                results.end());
+  std::stable_sort(results.begin(), results.end(),
+                   [&](const RootResult& a, const RootResult& b) {
+                     return best_wdl > 0 ? a.dtz < b.dtz : a.dtz > b.dtz;
+                   });
+  root_moves.clear();
+  for (const RootResult& result : results) {
+    root_moves.push_back(result.move);
+  }
+  return true;
+}
+
+template <typename Evaluator>
+double SearchCore<Evaluator>::SearchRoot(Position& pos,
+                                         std::vector<Move>& root_moves,
+                                         size_t first, int depth) {
+  stats_.nodes++;
+  double best_score = -std::numeric_limits<double>::infinity();
+  double alpha = best_score;
+  double beta = -best_score;
+  size_t best = first;
+  for (size_t i = first; i < root_moves.size(); i++) {
+    pos.MakeMove(root_moves[i]);
+    double score = -AlphaBeta(pos, -beta, -alpha, depth - 1, 1);
+    pos.UnmakeMove();
+    if (stopped_) {
+      return best_score;
+    }
     if (score > alpha) {
       alpha = score;
     }
-    if (score > best_score || !seen_a_legal_move) {
-      seen_a_legal_move = true;
+    if (score > best_score || i == first) {
       best_score = score;
-      best_move = mov;
+      best = i;
     }
   }
 
-  return {best_move, best_score, nodes_};
+  // Move the best move to the front of the moves searched, keeping the
+  // others in order.
+  std::rotate(root_moves.begin() + first, root_moves.begin() + best,
+              root_moves.begin() + best + 1);
+  return best_score;
 }
 
-double Searcher::AlphaBeta(Position& pos, double alpha, double beta,
-                           int depth) {
+template <typename Evaluator>
+double SearchCore<Evaluator>::AlphaBeta(Position& pos, double alpha,
+                                        double beta, int depth, int ply) {
   if (depth == 0) {
-    return Quiesce(pos, alpha, beta);
+    return Quiesce(pos, alpha, beta, ply);
   }
 
-  for (Move mov : pos.PseudolegalMoves()) {
+  stats_.nodes++;
+  stats_.seldepth = std::max(stats_.seldepth, ply);
+  if (ShouldStop()) {
+    return 0;
+  }
+
+  // The tablebases know the result of this position, so there's nothing left
+  // to search. Cursed wins and blessed losses are draws under the fifty-move
+  // rule.
+  if (tablebases_) {
+    std::optional<tablebase::Wdl> wdl = ProbeWdl(pos);
+    if (wdl) {
+      double score = *wdl == tablebase::kWdlWin    ? kTablebaseWinScore - ply
+                     : *wdl == tablebase::kWdlLoss ? ply - kTablebaseWinScore
+                                                   : 0;
+      return std::clamp(score, alpha, beta);
+    }
+  }
+
+  int moves_searched = 0;
+  MovePicker picker(pos);
+  Move mov;
+  while (picker.Next(mov)) {
     if (!pos.IsLegalGivenPseudolegal(mov)) {
       continue;
     }
 
     pos.MakeMove(mov);
-    double score = -AlphaBeta(pos, -beta, -alpha, depth - 1);
+    double score = -AlphaBeta(pos, -beta, -alpha, depth - 1, ply + 1);
     pos.UnmakeMove();
+    if (stopped_) {
+      return 0;
+    }
+
+    moves_searched++;
     if (score >= beta) {
+      stats_.beta_cutoffs++;
+      if (moves_searched == 1) {
+        stats_.first_move_cutoffs++;
+      }
       return beta;
     }
     if (score > alpha) {
@@ -58,10 +320,68 @@ double Searcher::AlphaBeta(Position& pos, double alpha, double beta,
   return alpha;
 }
 
-double Searcher::Quiesce(Position& pos, double alpha, double beta) {
-  nodes_++;
-  double value = evaluator_->Evaluate(pos);
+template <typename Evaluator>
+double SearchCore<Evaluator>::Quiesce(Position& pos, double alpha,
+                                      double beta, int ply) {
+  stats_.nodes++;
+  stats_.qnodes++;
+  stats_.seldepth = std::max(stats_.seldepth, ply);
+  if (ShouldStop()) {
+    return 0;
+  }
+
+  double value = Evaluate(pos);
   return pos.SideToMove() == kBlack ? -value : value;
 }
 
-}  // namespace apollo::search
\ No newline at end of file
+template <typename Evaluator>
+double SearchCore<Evaluator>::Evaluate(const Position& pos) {
+  double value;
+  if (eval_cache_.Probe(pos.ZobristHash(), value)) {
+    return value;
+  }
+
+  // Evaluators are final, so this call is direct unless Evaluator is the
+  // BoardEvaluator interface itself.
+  value = evaluator_.Evaluate(pos);
+  eval_cache_.Store(pos.ZobristHash(), value);
+  return value;
+}
+
+Searcher::Searcher(std::unique_ptr<BoardEvaluator> eval,
+                   size_t eval_cache_entries)
+    : evaluator_(std::move(eval)),
+      eval_cache_(eval_cache_entries),
+      multi_pv_(1),
+      search_fn_(nullptr),
+      generic_(false) {
+  SelectSearch();
+}
+
+void Searcher::SetEvaluator(std::unique_ptr<BoardEvaluator> eval) {
+  evaluator_ = std::move(eval);
+  eval_cache_.Clear();
+  SelectSearch();
+}
+
+void Searcher::UseGenericSearch(bool generic) {
+  generic_ = generic;
+  SelectSearch();
+}
+
+void Searcher::SelectSearch() {
+  const BoardEvaluator* eval = evaluator_.get();
+  if (generic_) {
+    search_fn_ = SearchCore<BoardEvaluator>::Run;
+  } else if (dynamic_cast<const evaluators::ShannonEvaluator*>(eval)) {
+    search_fn_ = SearchCore<evaluators::ShannonEvaluator>::Run;
+  } else if (dynamic_cast<const evaluators::TaperedEvaluator*>(eval)) {
+    search_fn_ = SearchCore<evaluators::TaperedEvaluator>::Run;
+  } else if (dynamic_cast<const evaluators::NnueEvaluator*>(eval)) {
+    search_fn_ = SearchCore<evaluators::NnueEvaluator>::Run;
+  } else {
+    search_fn_ = SearchCore<BoardEvaluator>::Run;
+  }
+}
+
+}  // namespace apollo::search
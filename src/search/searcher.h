@@ -1,34 +1,150 @@
 #pragma once
 
-#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <utility>
 
 #include "board_evaluator.h"
 #include "move.h"
 #include "position.h"
+#include "search/eval_cache.h"
+#include "search/search_stats.h"
+#include "tablebase/prober.h"
 
 namespace apollo::search {
 
+/**
+ * The default number of entries in a searcher's evaluation cache, which
+ * comes to 1 MiB.
+ */
+constexpr size_t kDefaultEvalCacheEntries = 1 << 16;
+
+/**
+ * The deepest iteration a search will ever start.
+ */
+constexpr int kMaxDepth = 64;
+
+/**
+ * The score of a position that a tablebase says is won, less the ply at which
+ * the search found it, so that nearer wins score higher. Scores are in pawns,
+ * so this is far beyond anything an evaluator returns.
+ */
+constexpr double kTablebaseWinScore = 1000;
+
+/**
+ * Limits on a search, which stops at whichever it reaches first. Zero means
+ * no limit on nodes or time. The first iteration always completes, whatever
+ * the limits, so that every search has a move to return; an iteration that
+ * is cut short is discarded.
+ */
+struct SearchLimits {
+  int depth = kMaxDepth;
+  uint64_t nodes = 0;
+  double seconds = 0;
+};
+
 struct SearchResult {
   Move best_move;
   double score;
-  int nodes_searched;
+  SearchStats stats;
 };
 
+/**
+ * A callback invoked at the end of every iteration of iterative deepening.
+ */
+using IterationCallback = std::function<void(const IterationStats&)>;
+
+/**
+ * A Searcher searches a position for the best move using a particular
+ * evaluator.
+ *
+ * The search itself is a template over the type of the evaluator, so that the
+ * evaluator can be called directly and inlined into the search instead of
+ * going through a virtual call at every leaf. The virtual BoardEvaluator
+ * interface only serves to pick the right instantiation, once, whenever the
+ * evaluator is set. Evaluators without an instantiation of their own fall
+ * back to a generic instantiation that calls through the interface.
+ */
 class Searcher {
  public:
-  explicit Searcher(std::unique_ptr<BoardEvaluator> eval)
-      : evaluator_(std::move(eval)), nodes_(0) {}
+  explicit Searcher(std::unique_ptr<BoardEvaluator> eval,
+                    size_t eval_cache_entries = kDefaultEvalCacheEntries);
+
+  /**
+   * Searches the given position by iterative deepening to the given depth,
+   * calling on_iteration, if given, as each iteration completes.
+   */
+  SearchResult Search(Position& pos, int depth,
+                      const IterationCallback& on_iteration = nullptr) {
+    SearchLimits limits;
+    limits.depth = depth;
+    return search_fn_(*this, pos, limits, on_iteration);
+  }
+
+  /**
+   * Searches the given position by iterative deepening until one of the given
+   * limits is reached.
+   */
+  SearchResult Search(Position& pos, const SearchLimits& limits,
+                      const IterationCallback& on_iteration = nullptr) {
+    return search_fn_(*this, pos, limits, on_iteration);
+  }
 
-  SearchResult Search(Position& pos, int depth);
+  /**
+   * Replaces the evaluator used by this searcher.
+   */
+  void SetEvaluator(std::unique_ptr<BoardEvaluator> eval);
+
+  /**
+   * Forces this searcher to use the generic, virtual-call search for every
+   * evaluator. This is slower and exists to measure the difference.
+   */
+  void UseGenericSearch(bool generic);
+
+  /**
+   * Resizes the evaluation cache, discarding its contents. A size of zero
+   * disables the cache.
+   */
+  void ResizeEvalCache(size_t entries) { eval_cache_.Resize(entries); }
+
+  /**
+   * Discards the contents of the evaluation cache, keeping its size.
+   */
+  void ClearEvalCache() { eval_cache_.Clear(); }
+
+  /**
+   * Sets how many of the best root moves every search finds an exact score
+   * for (MultiPV). Each line costs a search of the root moves not already
+   * chosen, so K lines cost about K times as much as one.
+   */
+  void SetMultiPv(int lines) { multi_pv_ = std::max(lines, 1); }
+
+  /**
+   * Sets the endgame tablebases consulted by the search, or none if null.
+   * Positions the prober knows about aren't searched any further, and at the
+   * root only the moves that keep the best known result are searched.
+   */
+  void SetTablebases(std::shared_ptr<const tablebase::Prober> tablebases) {
+    tablebases_ = std::move(tablebases);
+  }
 
  private:
-  double AlphaBeta(Position& pos, double alpha, double beta, int depth);
-  double Quiesce(Position& pos, double alpha, double beta);
+  template <typename Evaluator>
+  friend class SearchCore;
+
+  using SearchFn = SearchResult (*)(Searcher&, Position&, const SearchLimits&,
+                                    const IterationCallback&);
+
+  void SelectSearch();
 
   std::unique_ptr<BoardEvaluator> evaluator_;
-  int nodes_;
+  EvalCache eval_cache_;
+  std::shared_ptr<const tablebase::Prober> tablebases_;
+  int multi_pv_;
+  SearchFn search_fn_;
+  bool generic_;
 };
 
 }  // namespace apollo::search
@@ -0,0 +1,208 @@
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "json.hpp"
+
+#include "evaluators/shannon_evaluator.h"
+#include "position.h"
+#include "search/searcher.h"
+#include "tablebase/prober.h"
+
+using apollo::Bitboard;
+using apollo::Position;
+using apollo::evaluators::ShannonEvaluator;
+using apollo::search::IterationStats;
+using apollo::search::Searcher;
+using apollo::search::SearchResult;
+using apollo::tablebase::Prober;
+using apollo::tablebase::Wdl;
+using nlohmann::json;
+
+namespace {
+
+const char* const kKiwipete =
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+
+/**
+ * Knows the three-piece positions with a lone queen, which it calls won if
+ * the queen stands on one of the winning squares and drawn otherwise.
+ */
+class QueenProber : public Prober {
+ public:
+  explicit QueenProber(Bitboard winning_squares)
+      : winning_squares_(winning_squares) {}
+
+  int MaxPieces() const override { return 3; }
+
+  std::optional<Wdl> ProbeWdl(const Position& pos) const override {
+    for (apollo::Color color : apollo::kColors) {
+      if (pos.Queens(color).Empty()) {
+        continue;
+      }
+      if ((pos.Queens(color) & winning_squares_).Empty()) {
+        return apollo::tablebase::kWdlDraw;
+      }
+      return color == pos.SideToMove() ? apollo::tablebase::kWdlWin
+                                       : apollo::tablebase::kWdlLoss;
+    }
+    return {};
+  }
+
+ private:
+  Bitboard winning_squares_;
+};
+
+}  // anonymous namespace
+
+TEST(SearcherTest, IterationsAddUpToSearch) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Position pos(kKiwipete);
+  std::vector<IterationStats> reported;
+  SearchResult result =
+      searcher.Search(pos, 3, [&](const IterationStats& iteration) {
+        reported.push_back(iteration);
+      });
+
+  ASSERT_EQ(3u, result.stats.iterations.size());
+  ASSERT_EQ(3u, reported.size());
+  uint64_t nodes = 0;
+  for (size_t i = 0; i < reported.size(); i++) {
+    ASSERT_EQ(static_cast<int>(i) + 1, reported[i].depth);
+    ASSERT_EQ(reported[i].nodes, result.stats.iterations[i].nodes);
+    nodes += reported[i].nodes;
+  }
+  ASSERT_EQ(result.stats.nodes, nodes);
+  ASSERT_EQ(result.best_move, reported.back().best_move);
+  ASSERT_EQ(result.score, reported.back().score);
+}
+
+TEST(SearcherTest, CountsNodes) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Position pos(kKiwipete);
+  SearchResult result = searcher.Search(pos, 2);
+  const auto& stats = result.stats;
+  ASSERT_GT(stats.qnodes, 0u);
+  ASSERT_LT(stats.qnodes, stats.nodes);
+  ASSERT_EQ(2, stats.seldepth);
+  ASSERT_GT(stats.beta_cutoffs, 0u);
+  ASSERT_LE(stats.first_move_cutoffs, stats.beta_cutoffs);
+  ASSERT_GE(stats.FirstMoveCutoffRate(), 0.0);
+  ASSERT_LE(stats.FirstMoveCutoffRate(), 1.0);
+  ASSERT_EQ(stats.qnodes, stats.eval_cache_hits + stats.eval_cache_misses);
+}
+
+TEST(SearcherTest, StatsAsJson) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Position pos(kKiwipete);
+  SearchResult result = searcher.Search(pos, 2);
+  json doc = json::parse(result.stats.ToJson());
+  ASSERT_EQ(result.stats.nodes, doc["nodes"].get<uint64_t>());
+  ASSERT_EQ(result.stats.qnodes, doc["qnodes"].get<uint64_t>());
+  ASSERT_EQ(result.stats.beta_cutoffs,
+            doc["beta_cutoffs"].get<uint64_t>());
+  ASSERT_EQ(2u, doc["iterations"].size());
+  ASSERT_EQ(result.best_move.AsUci(),
+            doc["iterations"][1]["best_move"].get<std::string>());
+}
+
+TEST(SearcherTest, StopsAtNodeLimit) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Position pos(kKiwipete);
+  apollo::search::SearchLimits limits;
+  limits.nodes = 20000;
+  SearchResult result = searcher.Search(pos, limits);
+
+  // The first iteration is always searched, and the search stops within a
+  // node of the limit after that.
+  ASSERT_FALSE(result.best_move.IsNull());
+  ASSERT_FALSE(result.stats.iterations.empty());
+  ASSERT_LT(result.stats.iterations.size(), 64u);
+  ASSERT_LE(result.stats.nodes, limits.nodes + 1);
+  ASSERT_EQ(result.best_move, result.stats.iterations.back().best_move);
+}
+
+TEST(SearcherTest, StopsAtTimeLimit) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Position pos(kKiwipete);
+  apollo::search::SearchLimits limits;
+  limits.seconds = 0.05;
+  SearchResult result = searcher.Search(pos, limits);
+  ASSERT_FALSE(result.best_move.IsNull());
+  ASSERT_LT(result.stats.seconds, 1.0);
+}
+
+TEST(SearcherTest, TablebaseCutsOffSearch) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  searcher.SetTablebases(
+      std::make_shared<QueenProber>(Bitboard(~uint64_t{0})));
+  Position pos("4k3/8/8/3r4/8/8/8/3QK3 w - - 0 1");
+  SearchResult result = searcher.Search(pos, 3);
+  ASSERT_EQ("d1d5", result.best_move.AsUci());
+  ASSERT_GT(result.score, 900);
+  ASSERT_GT(result.stats.tb_hits, 0u);
+}
+
+TEST(SearcherTest, TablebaseFiltersRootMoves) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  searcher.SetTablebases(std::make_shared<QueenProber>(apollo::kBBRank7));
+  Position pos("7k/8/8/8/8/8/8/3QK3 w - - 0 1");
+
+  // Only the one winning move is searched: the root and the position after
+  // it.
+  SearchResult result = searcher.Search(pos, 1);
+  ASSERT_EQ("d1d7", result.best_move.AsUci());
+  ASSERT_EQ(2u, result.stats.nodes);
+}
+
+TEST(SearcherTest, NoTablebaseHitsWithoutTablebases) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  Position pos("4k3/8/8/3r4/8/8/8/3QK3 w - - 0 1");
+  SearchResult result = searcher.Search(pos, 3);
+  ASSERT_EQ(0u, result.stats.tb_hits);
+}
+
+TEST(SearcherTest, MultiPvFindsDistinctLines) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  searcher.SetMultiPv(4);
+  Position pos(kKiwipete);
+  SearchResult result = searcher.Search(pos, 3);
+  for (const IterationStats& iteration : result.stats.iterations) {
+    ASSERT_EQ(4u, iteration.lines.size());
+  }
+
+  const auto& lines = result.stats.iterations.back().lines;
+  ASSERT_EQ(result.best_move, lines[0].move);
+  ASSERT_EQ(result.score, lines[0].score);
+  for (size_t i = 1; i < lines.size(); i++) {
+    ASSERT_LE(lines[i].score, lines[i - 1].score);
+    for (size_t j = 0; j < i; j++) {
+      ASSERT_NE(lines[i].move, lines[j].move);
+    }
+  }
+}
+
+TEST(SearcherTest, MultiPvScoresAreExact) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  searcher.SetMultiPv(3);
+  Position pos(kKiwipete);
+  SearchResult result = searcher.Search(pos, 3);
+
+  // Each line scores the same as searching the position after its move.
+  Searcher single(std::make_unique<ShannonEvaluator>());
+  for (const auto& line : result.stats.iterations.back().lines) {
+    pos.MakeMove(line.move);
+    SearchResult reply = single.Search(pos, 2);
+    pos.UnmakeMove();
+    ASSERT_DOUBLE_EQ(-reply.score, line.score) << line.move.AsUci();
+  }
+}
+
+TEST(SearcherTest, MultiPvIsLimitedByLegalMoves) {
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  searcher.SetMultiPv(10);
+  Position pos("7k/8/8/8/8/8/8/K7 w - - 0 1");
+  SearchResult result = searcher.Search(pos, 2);
+  ASSERT_EQ(3u, result.stats.iterations.back().lines.size());
+}
@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <vector>
+
+#include "attacks.h"
+#include "tablebase/bitbase.h"
+
+namespace apollo::tablebase {
+
+namespace {
+
+// The state of a position during retrograde analysis. Results are flags, so
+// that the results of a position's successors can be combined with a
+// bitwise or.
+enum KpkResult : uint8_t {
+  kKpkInvalid = 0,
+  kKpkUnknown = 1,
+  kKpkDraw = 2,
+  kKpkWin = 4,
+};
+
+Square Flip(Square sq) {
+  return static_cast<Square>(static_cast<int>(sq) ^ 56);
+}
+
+}  // anonymous namespace
+
+KpkBitbase::KpkBitbase() : bits_(kPositions / 64) {
+  std::vector<uint8_t> results(kPositions, kKpkUnknown);
+  std::vector<uint32_t> unknown;
+
+  // Classify the positions whose result is immediately clear: positions
+  // that can't occur, promotions that can't be stopped, stalemates and
+  // captures of an undefended pawn.
+  // Positions are visited from the highest pawn rank down, since pawn moves
+  // lead to positions with the pawn one or two ranks further up.
+  for (uint32_t index = kPositions; index-- > 0;) {
+    auto [strong_king, pawn, weak_king, strong_to_move] = Decode(index);
+    Bitboard strong_attacks = attacks::KingAttacks(strong_king);
+    Bitboard weak_attacks = attacks::KingAttacks(weak_king);
+    Bitboard pawn_attacks = attacks::PawnAttacks(pawn, kWhite);
+    if (strong_king == weak_king || strong_attacks.Test(weak_king) ||
+        strong_king == pawn || weak_king == pawn ||
+        (strong_to_move && pawn_attacks.Test(weak_king))) {
+      results[index] = kKpkInvalid;
+      continue;
+    }
+
+    Square push = util::Towards(pawn, kDirectionNorth);
+    if (strong_to_move) {
+      if (util::RankOf(pawn) == kRank7 && push != strong_king &&
+          push != weak_king &&
+          (!weak_attacks.Test(push) || strong_attacks.Test(push))) {
+        results[index] = kKpkWin;
+        continue;
+      }
+    } else {
+      Bitboard guarded = strong_attacks | pawn_attacks;
+      if ((weak_attacks & ~guarded).Empty() ||
+          (weak_attacks.Test(pawn) && !strong_attacks.Test(pawn))) {
+        results[index] = kKpkDraw;
+        continue;
+      }
+    }
+    unknown.push_back(index);
+  }
+
+  // Work backwards from those until nothing changes. The strong side wins if
+  // any of its moves wins, and the weak side draws if any of its moves
+  // draws. Everything still unknown after that is a draw. Each pass only
+  // visits the positions that are still unknown.
+  size_t remaining = unknown.size();
+  size_t resolved = 1;
+  while (resolved > 0) {
+    size_t kept = 0;
+    for (size_t i = 0; i < remaining; i++) {
+      uint32_t index = unknown[i];
+      auto [strong_king, pawn, weak_king, strong_to_move] = Decode(index);
+      uint8_t successors = 0;
+      Bitboard strong_attacks = attacks::KingAttacks(strong_king);
+      Bitboard weak_attacks = attacks::KingAttacks(weak_king);
+      if (strong_to_move) {
+        (strong_attacks & ~weak_attacks).ForEach([&](Square to) {
+          successors |= results[Index(to, pawn, weak_king, false)];
+        });
+
+        Square push = util::Towards(pawn, kDirectionNorth);
+        if (util::RankOf(pawn) < kRank7 && push != strong_king &&
+            push != weak_king) {
+          successors |= results[Index(strong_king, push, weak_king, false)];
+          Square double_push = util::Towards(push, kDirectionNorth);
+          if (util::RankOf(pawn) == kRank2 && double_push != strong_king &&
+              double_push != weak_king) {
+            successors |=
+                results[Index(strong_king, double_push, weak_king, false)];
+          }
+        }
+      } else {
+        (weak_attacks & ~strong_attacks).ForEach([&](Square to) {
+          successors |= results[Index(strong_king, pawn, to, true)];
+        });
+      }
+
+      uint8_t good = strong_to_move ? kKpkWin : kKpkDraw;
+      uint8_t bad = strong_to_move ? kKpkDraw : kKpkWin;
+      if (successors & good) {
+        results[index] = good;
+      } else if (!(successors & kKpkUnknown)) {
+        results[index] = bad;
+      } else {
+        unknown[kept++] = index;
+      }
+    }
+    resolved = remaining - kept;
+    remaining = kept;
+  }
+
+  for (size_t index = 0; index < kPositions; index++) {
+    if (results[index] == kKpkWin) {
+      bits_[index / 64] |= uint64_t{1} << (index % 64);
+    }
+  }
+}
+
+std::optional<Wdl> KpkBitbase::Probe(const Position& pos) const {
+  Bitboard pawns = pos.Pawns(kWhite) | pos.Pawns(kBlack);
+  // Positions set up by hand may be missing kings.
+  Bitboard kings = pos.Kings(kWhite) | pos.Kings(kBlack);
+  if (pawns.Count() != 1 || kings.Count() != 2 ||
+      (pos.Pieces(kWhite) | pos.Pieces(kBlack)).Count() != 3) {
+    return {};
+  }
+
+  Color strong = pos.Pawns(kWhite).Empty() ? kBlack : kWhite;
+  Square strong_king = pos.Kings(strong).Iterator().Next();
+  Square weak_king = pos.Kings(!strong).Iterator().Next();
+  Square pawn = pawns.Iterator().Next();
+  if (strong == kBlack) {
+    strong_king = Flip(strong_king);
+    weak_king = Flip(weak_king);
+    pawn = Flip(pawn);
+  }
+
+  bool strong_to_move = pos.SideToMove() == strong;
+  if (!Wins(strong_king, pawn, weak_king, strong_to_move)) {
+    return kWdlDraw;
+  }
+  return strong_to_move ? kWdlWin : kWdlLoss;
+}
+
+const KpkBitbase& Kpk() {
+  static const KpkBitbase kpk;
+  return kpk;
+}
+
+std::optional<Wdl> Bitbases::ProbeWdl(const Position& pos) const {
+  if ((pos.Pieces(kWhite) | pos.Pieces(kBlack)).Count() == 2) {
+    return kWdlDraw;
+  }
+  return kpk_.Probe(pos);
+}
+
+}  // namespace apollo::tablebase
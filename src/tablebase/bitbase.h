@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "position.h"
+#include "tablebase/prober.h"
+#include "types.h"
+#include "util.h"
+
+namespace apollo::tablebase {
+
+/**
+ * A bitbase of every king and pawn versus king position, recording whether
+ * the side with the pawn wins. The bitbase is built by retrograde analysis
+ * when it is constructed, which takes a few milliseconds, and takes 24 KiB.
+ *
+ * Positions are given from the point of view of the side with the pawn, as
+ * if it were white, so a caller with a black pawn flips the board first.
+ */
+class KpkBitbase {
+ public:
+  KpkBitbase();
+
+  /**
+   * Returns whether the strong side, with the king and pawn, wins. The
+   * position must be legal.
+   */
+  bool Wins(Square strong_king, Square pawn, Square weak_king,
+            bool strong_to_move) const {
+    // The board is mirrored so that the pawn is on files a to d.
+    if (util::FileOf(pawn) > kFileD) {
+      strong_king = Mirror(strong_king);
+      pawn = Mirror(pawn);
+      weak_king = Mirror(weak_king);
+    }
+    size_t index = Index(strong_king, pawn, weak_king, strong_to_move);
+    return (bits_[index / 64] >> (index % 64)) & 1;
+  }
+
+  /**
+   * Returns the bitbase with the side to move's king and pawn, or nothing if
+   * the position isn't a king and pawn versus king position.
+   */
+  std::optional<Wdl> Probe(const Position& pos) const;
+
+ private:
+  // 24 pawn squares on files a to d and ranks 2 to 7, 64 squares for each
+  // king and two sides to move.
+  static constexpr size_t kPositions = 24 * 64 * 64 * 2;
+
+  static Square Mirror(Square sq) {
+    return static_cast<Square>(static_cast<int>(sq) ^ 7);
+  }
+
+  static size_t Index(Square strong_king, Square pawn, Square weak_king,
+                      bool strong_to_move) {
+    size_t pawn_index = (util::RankOf(pawn) - kRank2) * 4 + util::FileOf(pawn);
+    return ((pawn_index * 64 + strong_king) * 64 + weak_king) * 2 +
+           strong_to_move;
+  }
+
+  struct Squares {
+    Square strong_king;
+    Square pawn;
+    Square weak_king;
+    bool strong_to_move;
+  };
+
+  static Squares Decode(size_t index) {
+    size_t pawn_index = index >> 13;
+    return {static_cast<Square>((index >> 7) & 63),
+            util::SquareOf(kRank2 + pawn_index / 4, pawn_index % 4),
+            static_cast<Square>((index >> 1) & 63), (index & 1) != 0};
+  }
+
+  std::vector<uint64_t> bits_;
+};
+
+/**
+ * Returns the KPK bitbase, building it the first time it is needed.
+ */
+const KpkBitbase& Kpk();
+
+/**
+ * Bitbases is a Prober for the endgames the engine knows without any tables
+ * on disk: bare kings, which are drawn, and king and pawn versus king.
+ */
+class Bitbases final : public Prober {
+ public:
+  Bitbases() : kpk_(Kpk()) {}
+
+  int MaxPieces() const override { return 3; }
+  std::optional<Wdl> ProbeWdl(const Position& pos) const override;
+
+ private:
+  const KpkBitbase& kpk_;
+};
+
+}  // namespace apollo::tablebase
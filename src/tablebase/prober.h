@@ -0,0 +1,56 @@
+#pragma once
+
+#include <optional>
+
+#include "position.h"
+
+namespace apollo::tablebase {
+
+/**
+ * The result of a position with perfect play, from the point of view of the
+ * side to move. Cursed wins and blessed losses are wins and losses that the
+ * fifty-move rule turns into draws.
+ */
+enum Wdl {
+  kWdlLoss = -2,
+  kWdlBlessedLoss = -1,
+  kWdlDraw = 0,
+  kWdlCursedWin = 1,
+  kWdlWin = 2,
+};
+
+/**
+ * A Prober knows the perfect result of some endgame positions, such as the
+ * positions covered by a set of tablebases. Probers are shared by every
+ * thread that searches, so probes must be safe to make concurrently.
+ *
+ * Probes assume that the position has no castling rights and that its
+ * halfmove clock has just been reset; the search doesn't probe positions
+ * with castling rights.
+ */
+class Prober {
+ public:
+  virtual ~Prober() {}
+
+  /**
+   * Returns the most pieces, kings included, that a position the prober
+   * knows about can have. Positions with more aren't probed.
+   */
+  virtual int MaxPieces() const = 0;
+
+  /**
+   * Returns the result of a position, or nothing if the prober doesn't know
+   * it.
+   */
+  virtual std::optional<Wdl> ProbeWdl(const Position& pos) const = 0;
+
+  /**
+   * Returns the distance of a position, in plies, to the next capture or
+   * pawn move of a game played perfectly, or nothing if the prober doesn't
+   * know it. As in Syzygy tables, the sign is the sign of the result: the
+   * distance is negative for the side that is losing.
+   */
+  virtual std::optional<int> ProbeDtz(const Position& pos) const { return {}; }
+};
+
+}  // namespace apollo::tablebase
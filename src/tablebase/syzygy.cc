@@ -0,0 +1,1021 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "attacks.h"
+#include "tablebase/syzygy.h"
+#include "util.h"
+
+namespace apollo::tablebase {
+
+namespace {
+
+// Every Syzygy table starts with one of these.
+const uint8_t kWdlMagic[4] = {0x71, 0xe8, 0x23, 0x5d};
+const uint8_t kDtzMagic[4] = {0xd7, 0x66, 0x0c, 0xa5};
+
+const char* const kWdlExtension = ".rtbw";
+const char* const kDtzExtension = ".rtbz";
+
+// The letters of table names, in the order of piece codes from a pawn to a
+// king.
+const char kPieceLetters[] = "PNBRQK";
+
+// The flags of a part of a table. DTZ tables only have the positions with
+// one side to move, and store distances either in plies or in moves,
+// possibly through a map of the values that occur.
+enum SubtableFlag : uint8_t {
+  kSideToMoveFlag = 1,
+  kMappedFlag = 2,
+  kWinPliesFlag = 4,
+  kLossPliesFlag = 8,
+  kWideFlag = 16,
+  kSingleValueFlag = 128,
+};
+
+// The header flags of a table.
+enum TableFlag : uint8_t {
+  kSplitFlag = 1,
+  kHasPawnsFlag = 2,
+};
+
+// How far a square is above the a1-h8 diagonal; negative below it.
+int OffDiagonal(Square sq) {
+  return static_cast<int>(util::RankOf(sq)) -
+         static_cast<int>(util::FileOf(sq));
+}
+
+Square MirrorFile(Square sq) { return static_cast<Square>(sq ^ 7); }
+
+Square MirrorRank(Square sq) { return static_cast<Square>(sq ^ 56); }
+
+Square MirrorDiagonal(Square sq) {
+  return static_cast<Square>(((sq >> 3) | (sq << 3)) & 63);
+}
+
+// The tables that the encoding of pieces and pawns is built from.
+struct EncodingTables {
+  EncodingTables();
+
+  // Squares below the a1-h8 diagonal, numbered 0 to 27.
+  int below_diagonal[64] = {};
+  // Squares in the a1-d1-d4 triangle, numbered 0 to 9 with the squares on
+  // the diagonal last.
+  int triangle[64] = {};
+  // The 462 ways to place two kings, the first in the a1-d1-d4 triangle and
+  // the second not above the diagonal if the first is on it.
+  int kings[10][64] = {};
+  // The number of ways to choose k of n squares.
+  uint64_t binomial[6][64] = {};
+  // Pawn squares numbered from 47 down, so that the leading pawn, closest to
+  // the edge and to the second rank, has the highest number.
+  int pawns[64] = {};
+  // The index of each leading pawn square for each number of leading pawns,
+  // and the number of indices for each file.
+  uint64_t lead_pawn_index[6][64] = {};
+  uint64_t lead_pawn_size[6][4] = {};
+};
+
+EncodingTables::EncodingTables() {
+  int code = 0;
+  for (int sq = A1; sq <= H8; sq++) {
+    if (OffDiagonal(static_cast<Square>(sq)) < 0) {
+      below_diagonal[sq] = code++;
+    }
+  }
+
+  code = 0;
+  std::vector<Square> diagonal;
+  for (int i = A1; i <= D4; i++) {
+    Square sq = static_cast<Square>(i);
+    if (util::FileOf(sq) > kFileD) {
+      continue;
+    }
+    if (OffDiagonal(sq) < 0) {
+      triangle[sq] = code++;
+    } else if (OffDiagonal(sq) == 0) {
+      diagonal.push_back(sq);
+    }
+  }
+  for (Square sq : diagonal) {
+    triangle[sq] = code++;
+  }
+
+  // Placements with both kings on the diagonal are numbered last.
+  std::vector<std::pair<int, Square>> both_on_diagonal;
+  code = 0;
+  for (int index = 0; index < 10; index++) {
+    for (int i = A1; i <= D4; i++) {
+      Square first = static_cast<Square>(i);
+      // Squares outside the triangle are numbered zero too; b1 is the zero.
+      if (triangle[first] != index || (index == 0 && first != B1)) {
+        continue;
+      }
+      for (int j = A1; j <= H8; j++) {
+        Square second = static_cast<Square>(j);
+        if (first == second || attacks::KingAttacks(first).Test(second) ||
+            (OffDiagonal(first) == 0 && OffDiagonal(second) > 0)) {
+          continue;
+        }
+        if (OffDiagonal(first) == 0 && OffDiagonal(second) == 0) {
+          both_on_diagonal.emplace_back(index, second);
+        } else {
+          kings[index][second] = code++;
+        }
+      }
+    }
+  }
+  for (auto [index, second] : both_on_diagonal) {
+    kings[index][second] = code++;
+  }
+
+  binomial[0][0] = 1;
+  for (int n = 1; n < 64; n++) {
+    for (int k = 0; k < 6 && k <= n; k++) {
+      binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) +
+                       (k < n ? binomial[k][n - 1] : 0);
+    }
+  }
+
+  int available = 47;
+  for (int lead_count = 1; lead_count <= 5; lead_count++) {
+    for (int file = kFileA; file <= kFileD; file++) {
+      uint64_t index = 0;
+      for (int rank = kRank2; rank <= kRank7; rank++) {
+        Square sq = util::SquareOf(rank, file);
+        if (lead_count == 1) {
+          pawns[sq] = available--;
+          pawns[MirrorFile(sq)] = available--;
+        }
+        lead_pawn_index[lead_count][sq] = index;
+        index += binomial[lead_count - 1][pawns[sq]];
+      }
+      lead_pawn_size[lead_count][file] = index;
+    }
+  }
+}
+
+const EncodingTables& Encoding() {
+  static const EncodingTables tables;
+  return tables;
+}
+
+uint16_t ReadLittleEndian16(const uint8_t* data) {
+  return static_cast<uint16_t>(data[0] | data[1] << 8);
+}
+
+uint32_t ReadLittleEndian32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+         static_cast<uint32_t>(data[2]) << 16 |
+         static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint32_t ReadBigEndian32(const uint8_t* data) {
+  return static_cast<uint32_t>(data[0]) << 24 |
+         static_cast<uint32_t>(data[1]) << 16 |
+         static_cast<uint32_t>(data[2]) << 8 | static_cast<uint32_t>(data[3]);
+}
+
+uint64_t ReadBigEndian64(const uint8_t* data) {
+  return static_cast<uint64_t>(ReadBigEndian32(data)) << 32 |
+         ReadBigEndian32(data + 4);
+}
+
+// One part of a table: the positions with one side to move and, in tables
+// with pawns, the leading pawn on one file.
+//
+// Values are compressed by recursive pairing, which replaces frequent pairs
+// of symbols with new symbols, and the symbols are then Huffman coded with
+// a canonical code. Symbols are stored in blocks of a fixed size, each
+// holding a varying number of values, and a sparse index records the block
+// and offset of every span-th value so that a value can be found without
+// reading every block before it.
+struct Subtable {
+  explicit Subtable(const SyzygyEncoding& subtable_encoding)
+      : encoding(subtable_encoding) {}
+
+  SyzygyEncoding encoding;
+  uint8_t flags = 0;
+
+  uint64_t block_size = 0;
+  uint64_t span = 0;
+  uint64_t sparse_index_size = 0;
+  uint64_t block_length_size = 0;
+  uint64_t blocks = 0;
+
+  // The value of every position, if kSingleValueFlag is set.
+  int min_symbol_length = 0;
+  const uint8_t* lowest_symbols = nullptr;
+  // The lowest code of each symbol length, left-aligned to 64 bits.
+  std::vector<uint64_t> base;
+  // The number of values that each symbol stands for, less one.
+  std::vector<uint8_t> symbol_lengths;
+  // The pair that each symbol replaced, or the value of a symbol that
+  // stands for a single value.
+  const uint8_t* pairs = nullptr;
+
+  const uint8_t* sparse_index = nullptr;
+  const uint8_t* block_lengths = nullptr;
+  const uint8_t* data = nullptr;
+
+  // Where the DTZ values of each result start in the table's map.
+  uint16_t map_index[4] = {};
+
+  int Left(int symbol) const {
+    const uint8_t* pair = pairs + 3 * symbol;
+    return (pair[1] & 0xf) << 8 | pair[0];
+  }
+
+  int Right(int symbol) const {
+    const uint8_t* pair = pairs + 3 * symbol;
+    return pair[2] << 4 | pair[1] >> 4;
+  }
+
+  int LowestSymbol(int length) const {
+    return ReadLittleEndian16(lowest_symbols + 2 * length);
+  }
+
+  int BlockLength(uint64_t block) const {
+    return ReadLittleEndian16(block_lengths + 2 * block);
+  }
+
+  int SymbolLength(int symbol, std::vector<bool>& visited) {
+    visited[symbol] = true;
+    int right = Right(symbol);
+    if (right == 0xfff) {
+      return 0;
+    }
+    int left = Left(symbol);
+    if (!visited[left]) {
+      symbol_lengths[left] = SymbolLength(left, visited);
+    }
+    if (!visited[right]) {
+      symbol_lengths[right] = SymbolLength(right, visited);
+    }
+    return symbol_lengths[left] + symbol_lengths[right] + 1;
+  }
+
+  // Reads the compression parameters, returning the data after them.
+  const uint8_t* ReadSizes(const uint8_t* in) {
+    flags = *in++;
+    if (flags & kSingleValueFlag) {
+      min_symbol_length = *in++;
+      return in;
+    }
+
+    block_size = uint64_t{1} << *in++;
+    span = uint64_t{1} << *in++;
+    sparse_index_size = (encoding.Size() + span - 1) / span;
+    int padding = *in++;
+    blocks = ReadLittleEndian32(in);
+    in += 4;
+    // The block lengths are padded so that the sparse index never points
+    // past them.
+    block_length_size = blocks + padding;
+    int max_symbol_length = *in++;
+    min_symbol_length = *in++;
+    lowest_symbols = in;
+
+    // Longer codes have lower values, so the lowest code of each length is
+    // derived from the next longer one.
+    base.resize(max_symbol_length - min_symbol_length + 1);
+    for (int i = static_cast<int>(base.size()) - 2; i >= 0; i--) {
+      base[i] = (base[i + 1] + LowestSymbol(i) - LowestSymbol(i + 1)) / 2;
+    }
+    for (size_t i = 0; i < base.size(); i++) {
+      base[i] <<= 64 - i - min_symbol_length;
+    }
+    in += base.size() * 2;
+
+    symbol_lengths.resize(ReadLittleEndian16(in));
+    in += 2;
+    pairs = in;
+    std::vector<bool> visited(symbol_lengths.size());
+    for (size_t symbol = 0; symbol < symbol_lengths.size(); symbol++) {
+      if (!visited[symbol]) {
+        symbol_lengths[symbol] =
+            SymbolLength(static_cast<int>(symbol), visited);
+      }
+    }
+    return in + symbol_lengths.size() * 3 + (symbol_lengths.size() & 1);
+  }
+
+  // Returns the value at an index.
+  int Decompress(uint64_t index) const {
+    if (flags & kSingleValueFlag) {
+      return min_symbol_length;
+    }
+
+    // Find the block with the value, starting from the entry of the sparse
+    // index nearest to it. Each entry is the block and offset of the value
+    // in the middle of its span.
+    const uint8_t* entry = sparse_index + 6 * (index / span);
+    uint64_t block = ReadLittleEndian32(entry);
+    int offset = ReadLittleEndian16(entry + 4) +
+                 static_cast<int>(index % span) - static_cast<int>(span / 2);
+    while (offset < 0) {
+      offset += BlockLength(--block) + 1;
+    }
+    while (offset > BlockLength(block)) {
+      offset -= BlockLength(block++) + 1;
+    }
+
+    // Decode symbols from the start of the block until the one that
+    // stands for the value.
+    const uint8_t* in = data + block * block_size;
+    uint64_t buffer = ReadBigEndian64(in);
+    in += 8;
+    int buffer_bits = 64;
+    uint16_t symbol;
+    while (true) {
+      int length = 0;
+      while (buffer < base[length]) {
+        length++;
+      }
+      symbol = static_cast<uint16_t>((buffer - base[length]) >>
+                                     (64 - length - min_symbol_length));
+      symbol += LowestSymbol(length);
+      if (offset < symbol_lengths[symbol] + 1) {
+        break;
+      }
+
+      offset -= symbol_lengths[symbol] + 1;
+      length += min_symbol_length;
+      buffer <<= length;
+      buffer_bits -= length;
+      if (buffer_bits <= 32) {
+        buffer_bits += 32;
+        buffer |= static_cast<uint64_t>(ReadBigEndian32(in))
+                  << (64 - buffer_bits);
+        in += 4;
+      }
+    }
+
+    // Then expand the symbol's pairs down to the value.
+    while (symbol_lengths[symbol]) {
+      int left = Left(symbol);
+      if (offset < symbol_lengths[left] + 1) {
+        symbol = left;
+      } else {
+        offset -= symbol_lengths[left] + 1;
+        symbol = Right(symbol);
+      }
+    }
+    return Left(symbol);
+  }
+};
+
+// Returns the pieces of a table name, such as "KRvK", as piece codes.
+std::vector<uint8_t> NamePieces(const std::string& name) {
+  std::vector<uint8_t> pieces;
+  uint8_t color = 0;
+  for (char c : name) {
+    if (c == 'v') {
+      color = 8;
+      continue;
+    }
+    const char* letter = std::strchr(kPieceLetters, c);
+    if (!letter || c == '\0') {
+      return {};
+    }
+    pieces.push_back(color + static_cast<uint8_t>(letter - kPieceLetters) + 1);
+  }
+  return pieces;
+}
+
+// Returns the piece code of a piece, with the given color playing white.
+uint8_t PieceCode(Piece piece, Color white) {
+  return (piece.color() == white ? 0 : 8) + static_cast<uint8_t>(piece.kind()) +
+         1;
+}
+
+int Sign(int value) { return (value > 0) - (value < 0); }
+
+// The distance to zeroing of a position whose best move zeroes.
+int ZeroingDtz(Wdl wdl) {
+  switch (wdl) {
+    case kWdlWin:
+      return 1;
+    case kWdlCursedWin:
+      return 101;
+    case kWdlBlessedLoss:
+      return -101;
+    case kWdlLoss:
+      return -1;
+    default:
+      return 0;
+  }
+}
+
+}  // anonymous namespace
+
+struct SyzygyTablebases::Layout {
+  // Whether both sides have the same pieces, in which case the table only
+  // has the positions with white to move.
+  bool symmetric;
+  bool has_pawns;
+  int sides;
+  std::vector<Subtable> subtables;
+  const uint8_t* dtz_map = nullptr;
+
+  const Subtable& Get(int side, File file) const {
+    return subtables[(has_pawns ? file : 0) * sides + side % sides];
+  }
+
+  // Reads the header of a mapped table, returning nothing if it isn't a
+  // valid table for its name.
+  static std::unique_ptr<const Layout> Read(const uint8_t* base, size_t size,
+                                            const std::string& name, bool dtz);
+};
+
+std::unique_ptr<const SyzygyTablebases::Layout> SyzygyTablebases::Layout::Read(
+    const uint8_t* base, size_t size, const std::string& name, bool dtz) {
+  std::vector<uint8_t> name_pieces = NamePieces(name);
+  size_t split = name.find('v');
+  if (name_pieces.size() < 2 ||
+      name_pieces.size() > SyzygyEncoding::kMaxPieces) {
+    return nullptr;
+  }
+  std::sort(name_pieces.begin(), name_pieces.end());
+  bool white_pawns = std::count(name_pieces.begin(), name_pieces.end(), 1) > 0;
+  bool black_pawns = std::count(name_pieces.begin(), name_pieces.end(), 9) > 0;
+
+  auto layout = std::make_unique<Layout>();
+  layout->symmetric = name.substr(0, split) == name.substr(split + 1);
+  layout->has_pawns = white_pawns || black_pawns;
+  bool both_pawns = white_pawns && black_pawns;
+
+  const uint8_t* in = base + 4;
+  if (bool(*in & kSplitFlag) == layout->symmetric ||
+      bool(*in & kHasPawnsFlag) != layout->has_pawns) {
+    return nullptr;
+  }
+  in++;
+
+  layout->sides = !dtz && !layout->symmetric ? 2 : 1;
+  int files = layout->has_pawns ? 4 : 1;
+  int piece_count = static_cast<int>(name_pieces.size());
+  for (int file = kFileA; file < files; file++) {
+    int lead_order[2] = {*in & 0xf, *in >> 4};
+    int pawn_order[2] = {0xf, 0xf};
+    if (both_pawns) {
+      pawn_order[0] = in[1] & 0xf;
+      pawn_order[1] = in[1] >> 4;
+    }
+    in += 1 + both_pawns;
+
+    uint8_t pieces[2][SyzygyEncoding::kMaxPieces];
+    for (int k = 0; k < piece_count; k++, in++) {
+      pieces[0][k] = *in & 0xf;
+      pieces[1][k] = *in >> 4;
+    }
+    for (int side = 0; side < layout->sides; side++) {
+      // Every part lists the table's pieces, with a pawn leading if there
+      // are pawns.
+      std::vector<uint8_t> sorted(pieces[side], pieces[side] + piece_count);
+      std::sort(sorted.begin(), sorted.end());
+      if (sorted != name_pieces ||
+          (layout->has_pawns && (pieces[side][0] & 7) != 1)) {
+        return nullptr;
+      }
+      layout->subtables.emplace_back(
+          SyzygyEncoding(pieces[side], piece_count, lead_order[side],
+                         pawn_order[side], static_cast<File>(file)));
+    }
+  }
+
+  in += (in - base) & 1;
+  for (Subtable& subtable : layout->subtables) {
+    in = subtable.ReadSizes(in);
+  }
+
+  if (dtz) {
+    layout->dtz_map = in;
+    for (Subtable& subtable : layout->subtables) {
+      if (!(subtable.flags & kMappedFlag)) {
+        continue;
+      }
+      // The values of each of the four results, each list preceded by its
+      // length.
+      if (subtable.flags & kWideFlag) {
+        in += (in - base) & 1;
+        for (uint16_t& index : subtable.map_index) {
+          index = static_cast<uint16_t>((in - layout->dtz_map) / 2 + 1);
+          in += 2 * ReadLittleEndian16(in) + 2;
+        }
+      } else {
+        for (uint16_t& index : subtable.map_index) {
+          index = static_cast<uint16_t>(in - layout->dtz_map + 1);
+          in += *in + 1;
+        }
+      }
+    }
+    in += (in - base) & 1;
+  }
+
+  for (Subtable& subtable : layout->subtables) {
+    subtable.sparse_index = in;
+    in += subtable.sparse_index_size * 6;
+  }
+  for (Subtable& subtable : layout->subtables) {
+    subtable.block_lengths = in;
+    in += subtable.block_length_size * 2;
+  }
+  for (Subtable& subtable : layout->subtables) {
+    in = base + ((in - base + 63) & ~63);
+    subtable.data = in;
+    in += subtable.blocks * subtable.block_size;
+  }
+  if (in > base + size) {
+    return nullptr;
+  }
+  return layout;
+}
+
+SyzygyEncoding::SyzygyEncoding(const uint8_t* pieces, int piece_count,
+                               int lead_order, int pawn_order, File file)
+    : pieces_(), piece_count_(piece_count), group_length_(), group_index_() {
+  const EncodingTables& tables = Encoding();
+  std::copy(pieces, pieces + piece_count, pieces_.begin());
+  int counts[16] = {};
+  for (int i = 0; i < piece_count; i++) {
+    counts[pieces[i] & 0xf]++;
+  }
+  has_pawns_ = counts[1] > 0 || counts[9] > 0;
+  both_pawns_ = counts[1] > 0 && counts[9] > 0;
+  has_unique_pieces_ = false;
+  for (int code = 1; code < 6; code++) {
+    if (counts[code] == 1 || counts[code + 8] == 1) {
+      has_unique_pieces_ = true;
+    }
+  }
+
+  // Without pawns, the first two or three pieces are encoded together.
+  // Every other group is a run of the same piece.
+  int first_length = has_pawns_ ? 0 : has_unique_pieces_ ? 3 : 2;
+  int groups = 0;
+  group_length_[0] = 1;
+  for (int i = 1; i < piece_count; i++) {
+    if (--first_length > 0 || pieces_[i] == pieces_[i - 1]) {
+      group_length_[groups]++;
+    } else {
+      group_length_[++groups] = 1;
+    }
+  }
+  group_length_[++groups] = 0;
+  group_count_ = groups;
+
+  // The groups are numbered in the order the header gives, with each index
+  // a multiple of the number of ways to place the groups after it.
+  int next = both_pawns_ ? 2 : 1;
+  int free_squares =
+      64 - group_length_[0] - (both_pawns_ ? group_length_[1] : 0);
+  uint64_t index = 1;
+  for (int k = 0; next < groups || k == lead_order || k == pawn_order; k++) {
+    if (k == lead_order) {
+      group_index_[0] = index;
+      index *= has_pawns_ ? tables.lead_pawn_size[group_length_[0]][file]
+               : has_unique_pieces_ ? 31332
+                                    : 462;
+    } else if (k == pawn_order) {
+      group_index_[1] = index;
+      index *= tables.binomial[group_length_[1]][48 - group_length_[0]];
+    } else {
+      group_index_[next] = index;
+      index *= tables.binomial[group_length_[next]][free_squares];
+      free_squares -= group_length_[next++];
+    }
+  }
+  group_index_[groups] = index;
+}
+
+uint64_t SyzygyEncoding::Index(Square* squares) const {
+  const EncodingTables& tables = Encoding();
+  if (util::FileOf(squares[0]) > kFileD) {
+    for (int i = 0; i < piece_count_; i++) {
+      squares[i] = MirrorFile(squares[i]);
+    }
+  }
+
+  uint64_t index;
+  int lead_length = group_length_[0];
+  if (has_pawns_) {
+    // The leading pawn picks out the other leading pawns' placements, which
+    // are numbered in increasing order.
+    index = tables.lead_pawn_index[lead_length][squares[0]];
+    std::stable_sort(squares + 1, squares + lead_length,
+                     [&](Square a, Square b) {
+                       return tables.pawns[a] < tables.pawns[b];
+                     });
+    for (int i = 1; i < lead_length; i++) {
+      index += tables.binomial[i][tables.pawns[squares[i]]];
+    }
+  } else {
+    // Without pawns, the board is also mirrored so that the leading piece
+    // is on ranks 1 to 4, and the first piece of the leading group that is
+    // off the diagonal is below it.
+    if (util::RankOf(squares[0]) > kRank4) {
+      for (int i = 0; i < piece_count_; i++) {
+        squares[i] = MirrorRank(squares[i]);
+      }
+    }
+    for (int i = 0; i < lead_length; i++) {
+      if (OffDiagonal(squares[i]) == 0) {
+        continue;
+      }
+      if (OffDiagonal(squares[i]) > 0) {
+        for (int j = i; j < piece_count_; j++) {
+          squares[j] = MirrorDiagonal(squares[j]);
+        }
+      }
+      break;
+    }
+
+    if (has_unique_pieces_) {
+      // The first three pieces, numbered by how many of them are on the
+      // diagonal.
+      int adjust1 = squares[1] > squares[0];
+      int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+      if (OffDiagonal(squares[0])) {
+        index = (tables.triangle[squares[0]] * 63 + (squares[1] - adjust1)) *
+                    62 +
+                squares[2] - adjust2;
+      } else if (OffDiagonal(squares[1])) {
+        index = (6 * 63 + util::RankOf(squares[0]) * 28 +
+                 tables.below_diagonal[squares[1]]) *
+                    62 +
+                squares[2] - adjust2;
+      } else if (OffDiagonal(squares[2])) {
+        index = 6 * 63 * 62 + 4 * 28 * 62 + util::RankOf(squares[0]) * 7 * 28 +
+                (util::RankOf(squares[1]) - adjust1) * 28 +
+                tables.below_diagonal[squares[2]];
+      } else {
+        index = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 +
+                util::RankOf(squares[0]) * 7 * 6 +
+                (util::RankOf(squares[1]) - adjust1) * 6 +
+                (util::RankOf(squares[2]) - adjust2);
+      }
+    } else {
+      index = tables.kings[tables.triangle[squares[0]]][squares[1]];
+    }
+  }
+  index *= group_index_[0];
+
+  // Every other group is numbered by its squares in increasing order, not
+  // counting the squares of the groups before it. The other side's pawns
+  // can't be on the first rank either.
+  Square* group = squares + lead_length;
+  int pawn_offset = both_pawns_ ? 8 : 0;
+  for (int g = 1; group_length_[g]; g++) {
+    std::stable_sort(group, group + group_length_[g]);
+    uint64_t n = 0;
+    for (int i = 0; i < group_length_[g]; i++) {
+      int adjust = static_cast<int>(std::count_if(
+          squares, group, [&](Square sq) { return group[i] > sq; }));
+      n += tables.binomial[i + 1][group[i] - adjust - pawn_offset];
+    }
+    pawn_offset = 0;
+    index += n * group_index_[g];
+    group += group_length_[g];
+  }
+  return index;
+}
+
+File SyzygyEncoding::LeadingPawnFile(Square* squares, int pawn_count) {
+  const EncodingTables& tables = Encoding();
+  std::swap(squares[0],
+            *std::max_element(squares, squares + pawn_count,
+                              [&](Square a, Square b) {
+                                return tables.pawns[a] < tables.pawns[b];
+                              }));
+  File file = util::FileOf(squares[0]);
+  return file > kFileD ? util::FileOf(MirrorFile(squares[0])) : file;
+}
+
+std::string MaterialName(const Position& pos, Color first) {
+  static const PieceKind kOrder[] = {kKing,   kQueen,  kRook,
+                                     kBishop, kKnight, kPawn};
+  static const char kLetters[] = "KQRBNP";
+  std::string name;
+  for (Color color : {first, !first}) {
+    if (color != first) {
+      name += 'v';
+    }
+    for (int i = 0; i < 6; i++) {
+      name.append(pos.Pieces(color, kOrder[i]).Count(), kLetters[i]);
+    }
+  }
+  return name;
+}
+
+SyzygyTablebases::Table::Table(std::string table_path)
+    : path(std::move(table_path)) {}
+
+SyzygyTablebases::Table::~Table() {}
+
+SyzygyTablebases::SyzygyTablebases(const std::string& paths)
+    : max_pieces_(0) {
+  std::istringstream stream(paths);
+  std::string directory;
+  while (std::getline(stream, directory, ':')) {
+    std::error_code err;
+    std::filesystem::directory_iterator it(directory, err);
+    if (err) {
+      continue;
+    }
+
+    for (const auto& entry : it) {
+      std::string extension = entry.path().extension().string();
+      std::string name = entry.path().stem().string();
+      Tables* tables = extension == kWdlExtension   ? &wdl_
+                       : extension == kDtzExtension ? &dtz_
+                                                    : nullptr;
+      if (!tables || name.find('v') == std::string::npos) {
+        continue;
+      }
+
+      // The first directory to have a table wins.
+      tables->try_emplace(name, entry.path().string());
+      int pieces = static_cast<int>(name.size()) - 1;
+      max_pieces_ = std::max(max_pieces_, pieces);
+    }
+  }
+}
+
+SyzygyTablebases::~SyzygyTablebases() {
+  for (Tables* tables : {&wdl_, &dtz_}) {
+    for (auto& [name, table] : *tables) {
+      if (table.data) {
+        munmap(const_cast<uint8_t*>(table.data), table.size);
+      }
+    }
+  }
+}
+
+void SyzygyTablebases::Map(const Table& table, const std::string& name,
+                           bool dtz) {
+  int fd = open(table.path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+
+  // Tables are padded to 16 bytes past a multiple of 64.
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size % 64 != 16) {
+    close(fd);
+    return;
+  }
+
+  size_t size = static_cast<size_t>(st.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return;
+  }
+
+  const uint8_t* data = static_cast<const uint8_t*>(mapping);
+  std::unique_ptr<const Layout> layout;
+  if (std::memcmp(data, dtz ? kDtzMagic : kWdlMagic, 4) == 0) {
+    layout = Layout::Read(data, size, name, dtz);
+  }
+  if (!layout) {
+    munmap(mapping, size);
+    return;
+  }
+  table.data = data;
+  table.size = size;
+  table.layout = std::move(layout);
+}
+
+const SyzygyTablebases::Table* SyzygyTablebases::Find(const Tables& tables,
+                                                      const Position& pos,
+                                                      bool& flipped) const {
+  // Tables are named with the stronger side first, and cover both colors.
+  // A table whose sides have the same pieces only has white to move.
+  std::string white_first = MaterialName(pos, kWhite);
+  std::string black_first = MaterialName(pos, kBlack);
+  auto it = tables.find(white_first);
+  flipped = false;
+  if (it == tables.end()) {
+    it = tables.find(black_first);
+    flipped = true;
+    if (it == tables.end()) {
+      return nullptr;
+    }
+  }
+  if (white_first == black_first) {
+    flipped = pos.SideToMove() == kBlack;
+  }
+
+  const Table& table = it->second;
+  std::call_once(table.mapped, Map, std::cref(table), std::cref(it->first),
+                 &tables == &dtz_);
+  return table.layout ? &table : nullptr;
+}
+
+int SyzygyTablebases::ProbeTable(const Position& pos, bool dtz, Wdl wdl,
+                                 ProbeState& state) const {
+  Bitboard occupied = pos.Pieces(kWhite) | pos.Pieces(kBlack);
+  if (occupied.Count() == 2) {
+    return kWdlDraw;
+  }
+
+  bool flipped;
+  const Table* table = Find(dtz ? dtz_ : wdl_, pos, flipped);
+  if (!table) {
+    state = kProbeFailed;
+    return 0;
+  }
+
+  // The table is looked up with its white pieces as white, which may mean
+  // flipping the board.
+  const Layout& layout = *table->layout;
+  Color white = flipped ? kBlack : kWhite;
+  int flip = flipped ? 56 : 0;
+  int side = pos.SideToMove() == white ? 0 : 1;
+
+  Square squares[SyzygyEncoding::kMaxPieces];
+  uint8_t pieces[SyzygyEncoding::kMaxPieces];
+  int count = 0;
+  int lead_count = 0;
+  Bitboard lead_pawns;
+  File file = kFileA;
+  if (layout.has_pawns) {
+    // Every part of the table leads with the pawns of the same side.
+    uint8_t lead = layout.Get(0, kFileA).encoding.PieceCode(0);
+    lead_pawns = pos.Pawns(lead == 1 ? white : !white);
+    lead_pawns.ForEach([&](Square sq) {
+      squares[count++] = static_cast<Square>(sq ^ flip);
+    });
+    lead_count = count;
+    file = SyzygyEncoding::LeadingPawnFile(squares, lead_count);
+  }
+
+  const Subtable& subtable = layout.Get(side, file);
+  if (dtz && (subtable.flags & kSideToMoveFlag) != side &&
+      !(layout.symmetric && !layout.has_pawns)) {
+    state = kProbeOtherSide;
+    return 0;
+  }
+
+  (occupied & ~lead_pawns).ForEach([&](Square sq) {
+    squares[count] = static_cast<Square>(sq ^ flip);
+    pieces[count++] = PieceCode(*pos.PieceAt(sq), white);
+  });
+
+  // The other pieces are put in the order that the table encodes them.
+  const SyzygyEncoding& encoding = subtable.encoding;
+  for (int i = lead_count; i < count - 1; i++) {
+    for (int j = i + 1; j < count; j++) {
+      if (encoding.PieceCode(i) == pieces[j]) {
+        std::swap(pieces[i], pieces[j]);
+        std::swap(squares[i], squares[j]);
+        break;
+      }
+    }
+  }
+
+  int value = subtable.Decompress(encoding.Index(squares));
+  if (!dtz) {
+    return value - 2;
+  }
+
+  // DTZ values may be mapped, and may be in moves rather than plies.
+  if (subtable.flags & kMappedFlag) {
+    static const int kResultMap[] = {1, 3, 0, 2, 0};
+    int index = subtable.map_index[kResultMap[wdl + 2]] + value;
+    value = subtable.flags & kWideFlag
+                ? ReadLittleEndian16(layout.dtz_map + 2 * index)
+                : layout.dtz_map[index];
+  }
+  if ((wdl == kWdlWin && !(subtable.flags & kWinPliesFlag)) ||
+      (wdl == kWdlLoss && !(subtable.flags & kLossPliesFlag)) ||
+      wdl == kWdlCursedWin || wdl == kWdlBlessedLoss) {
+    value *= 2;
+  }
+  return value + 1;
+}
+
+Wdl SyzygyTablebases::SearchWdl(Position& pos, bool check_zeroing,
+                                ProbeState& state) const {
+  // The tables may record anything for a position whose best move is a
+  // capture, or with en passant rights, so captures are searched first.
+  int best = kWdlLoss;
+  std::vector<Move> moves = pos.LegalMoves();
+  size_t searched = 0;
+  for (Move mov : moves) {
+    bool pawn_move = pos.PieceAt(mov.Source())->kind() == kPawn;
+    if (!mov.IsCapture() && (!check_zeroing || !pawn_move)) {
+      continue;
+    }
+
+    searched++;
+    pos.MakeMove(mov);
+    int value = -SearchWdl(pos, false, state);
+    pos.UnmakeMove();
+    if (state == kProbeFailed) {
+      return kWdlDraw;
+    }
+    if (value > best) {
+      best = value;
+      if (value >= kWdlWin) {
+        state = kProbeZeroingBest;
+        return kWdlWin;
+      }
+    }
+  }
+
+  // If every move was searched, the table isn't needed.
+  bool all_searched = searched > 0 && searched == moves.size();
+  int value = best;
+  if (!all_searched) {
+    value = ProbeTable(pos, false, kWdlDraw, state);
+    if (state == kProbeFailed) {
+      return kWdlDraw;
+    }
+  }
+  if (best >= value) {
+    state = best > kWdlDraw || all_searched ? kProbeZeroingBest : kProbeOk;
+    return static_cast<Wdl>(best);
+  }
+  state = kProbeOk;
+  return static_cast<Wdl>(value);
+}
+
+int SyzygyTablebases::SearchDtz(Position& pos, ProbeState& state) const {
+  state = kProbeOk;
+  Wdl wdl = SearchWdl(pos, true, state);
+  if (state == kProbeFailed || wdl == kWdlDraw) {
+    return 0;
+  }
+  if (state == kProbeZeroingBest) {
+    return ZeroingDtz(wdl);
+  }
+
+  int dtz = ProbeTable(pos, true, wdl, state);
+  if (state == kProbeFailed) {
+    return 0;
+  }
+  if (state != kProbeOtherSide) {
+    bool cursed = wdl == kWdlCursedWin || wdl == kWdlBlessedLoss;
+    return (dtz + (cursed ? 100 : 0)) * Sign(wdl);
+  }
+
+  // The table only has the other side to move, so the distance is found
+  // through the best move. A zeroing move's distance is measured from the
+  // position before it.
+  int best = 0xffff;
+  for (Move mov : pos.LegalMoves()) {
+    bool zeroing =
+        mov.IsCapture() || pos.PieceAt(mov.Source())->kind() == kPawn;
+    pos.MakeMove(mov);
+    int value = zeroing ? -ZeroingDtz(SearchWdl(pos, false, state))
+                        : -SearchDtz(pos, state);
+    if (value == 1 && pos.IsCheckmate(pos.SideToMove())) {
+      best = 1;
+    }
+    if (!zeroing) {
+      value += Sign(value);
+    }
+    if (value < best && Sign(value) == Sign(wdl)) {
+      best = value;
+    }
+    pos.UnmakeMove();
+    if (state == kProbeFailed) {
+      return 0;
+    }
+  }
+  // Without a legal move, the side to move is mated.
+  return best == 0xffff ? -1 : best;
+}
+
+std::optional<Wdl> SyzygyTablebases::ProbeWdl(const Position& pos) const {
+  // Probes make moves, so they search a copy of the position without its
+  // history or network.
+  Position search_pos = Position::Unpack(pos.Pack());
+  ProbeState state = kProbeOk;
+  Wdl wdl = SearchWdl(search_pos, false, state);
+  if (state == kProbeFailed) {
+    return {};
+  }
+  return wdl;
+}
+
+std::optional<int> SyzygyTablebases::ProbeDtz(const Position& pos) const {
+  Position search_pos = Position::Unpack(pos.Pack());
+  ProbeState state = kProbeOk;
+  int dtz = SearchDtz(search_pos, state);
+  if (state == kProbeFailed) {
+    return {};
+  }
+  return dtz;
+}
+
+}  // namespace apollo::tablebase
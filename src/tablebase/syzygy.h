@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "position.h"
+#include "tablebase/prober.h"
+#include "types.h"
+
+namespace apollo::tablebase {
+
+/**
+ * Returns the Syzygy name of a position's material, such as "KRPvKR", with
+ * the given color's pieces first and the pieces of each side ordered KQRBNP.
+ */
+std::string MaterialName(const Position& pos, Color first);
+
+/**
+ * A SyzygyEncoding numbers the positions of one part of a Syzygy table, the
+ * way the table generator does. Each part lists the table's pieces in the
+ * order that it encodes them, as codes from 1 (a white pawn) to 6 (a white
+ * king) and from 9 (a black pawn) to 14 (a black king). Pieces are encoded
+ * in groups, which are ordered by the table header, and the board is
+ * mirrored so that the leading piece (or pawn) is on files a to d and, if
+ * the table has no pawns, below the a1-h8 diagonal.
+ */
+class SyzygyEncoding {
+ public:
+  static constexpr int kMaxPieces = 7;
+
+  /**
+   * Builds the encoding of a part of a table, given its pieces and the
+   * positions of its leading group and, if both sides have pawns, of the
+   * other side's pawns among its groups. For a table with pawns, the file is
+   * the file, a to d, of the leading pawn of the positions in the part.
+   */
+  SyzygyEncoding(const uint8_t* pieces, int piece_count, int lead_order,
+                 int pawn_order, File file);
+
+  int PieceCount() const { return piece_count_; }
+  uint8_t PieceCode(int i) const { return pieces_[i]; }
+
+  /**
+   * Returns the number of indices that positions are encoded to.
+   */
+  uint64_t Size() const { return group_index_[group_count_]; }
+
+  /**
+   * Returns the index of a position, given the square of each of the pieces
+   * in the order of PieceCode. In a table with pawns, the leading pawn must
+   * come first, as LeadingPawnFile leaves it. The squares are mirrored and
+   * sorted in place.
+   */
+  uint64_t Index(Square* squares) const;
+
+  /**
+   * Moves the leading pawn, of the given number of pawns at the start of an
+   * array of squares, to the front and returns its file mirrored to a to d.
+   * The leading pawn is the one closest to the edge of the board and, among
+   * those, to its side's second rank.
+   */
+  static File LeadingPawnFile(Square* squares, int pawn_count);
+
+ private:
+  std::array<uint8_t, kMaxPieces> pieces_;
+  int piece_count_;
+  bool has_pawns_;
+  bool has_unique_pieces_;
+  // Whether both sides have pawns, in which case the second group is the
+  // pawns of the side that doesn't lead.
+  bool both_pawns_;
+
+  // The number of pieces in each group, followed by a zero, and the factor
+  // that each group's index is multiplied by; the factor after the last
+  // group is the size of the encoding.
+  int group_count_;
+  std::array<int, kMaxPieces + 1> group_length_;
+  std::array<uint64_t, kMaxPieces + 1> group_index_;
+};
+
+/**
+ * SyzygyTablebases probes the Syzygy WDL (.rtbw) and DTZ (.rtbz) tables in
+ * a list of directories. A table is mapped into memory and its header read
+ * the first time a position it covers is probed, so opening a large set of
+ * tables is cheap and tables that are never needed are never read.
+ *
+ * Tables don't record positions with captures or en passant rights
+ * correctly, so probes search the captures (and, for DTZ, every move) of a
+ * position the way the Syzygy probing code does.
+ */
+class SyzygyTablebases final : public Prober {
+ public:
+  /**
+   * Scans the directories of a colon-separated list for tables.
+   */
+  explicit SyzygyTablebases(const std::string& paths);
+  ~SyzygyTablebases() override;
+
+  SyzygyTablebases(const SyzygyTablebases&) = delete;
+  SyzygyTablebases& operator=(const SyzygyTablebases&) = delete;
+
+  /**
+   * Returns the number of WDL and DTZ tables found.
+   */
+  size_t TableCount() const { return wdl_.size() + dtz_.size(); }
+
+  int MaxPieces() const override { return max_pieces_; }
+  std::optional<Wdl> ProbeWdl(const Position& pos) const override;
+  std::optional<int> ProbeDtz(const Position& pos) const override;
+
+ private:
+  // The decoding state of a mapped table, defined with the decoder.
+  struct Layout;
+
+  struct Table {
+    explicit Table(std::string table_path);
+    ~Table();
+
+    std::string path;
+
+    // Set by the first probe that needs the table. A table that can't be
+    // mapped, or isn't a valid Syzygy table, is left unmapped.
+    mutable std::once_flag mapped;
+    mutable const uint8_t* data = nullptr;
+    mutable size_t size = 0;
+    mutable std::unique_ptr<const Layout> layout;
+  };
+
+  using Tables = std::map<std::string, Table>;
+
+  // How a probe went. The DTZ table of a position may only have the
+  // positions with the other side to move, and a capture or pawn move may
+  // be the best move of a position, in which case the table may record
+  // anything for it.
+  enum ProbeState {
+    kProbeFailed,
+    kProbeOk,
+    kProbeOtherSide,
+    kProbeZeroingBest,
+  };
+
+  // Returns the mapped table in the given set that covers the position, or
+  // nullptr if there isn't one. The table's white pieces are the
+  // position's black pieces if flipped is set.
+  const Table* Find(const Tables& tables, const Position& pos,
+                    bool& flipped) const;
+  static void Map(const Table& table, const std::string& name, bool dtz);
+
+  // Looks a position up in its WDL table, or in its DTZ table given its
+  // result, without searching it.
+  int ProbeTable(const Position& pos, bool dtz, Wdl wdl,
+                 ProbeState& state) const;
+
+  // The result of a position after searching its captures (and pawn moves,
+  // if check_zeroing is set), and its distance to zeroing.
+  Wdl SearchWdl(Position& pos, bool check_zeroing, ProbeState& state) const;
+  int SearchDtz(Position& pos, ProbeState& state) const;
+
+  Tables wdl_;
+  Tables dtz_;
+  int max_pieces_;
+};
+
+}  // namespace apollo::tablebase
@@ -0,0 +1,542 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "gtest/gtest.h"
+
+#include "attacks.h"
+#include "evaluators/shannon_evaluator.h"
+#include "evaluators/tapered_evaluator.h"
+#include "position.h"
+#include "search/searcher.h"
+#include "tablebase/bitbase.h"
+#include "tablebase/syzygy.h"
+#include "util.h"
+
+using apollo::Bitboard;
+using apollo::File;
+using apollo::Position;
+using apollo::Square;
+using apollo::attacks::KingAttacks;
+using apollo::attacks::PawnAttacks;
+using apollo::attacks::RookAttacks;
+using apollo::evaluators::ShannonEvaluator;
+using apollo::evaluators::TaperedEvaluator;
+using apollo::search::Searcher;
+using apollo::search::SearchResult;
+using apollo::tablebase::Bitbases;
+using apollo::tablebase::Kpk;
+using apollo::tablebase::MaterialName;
+using apollo::tablebase::SyzygyEncoding;
+using apollo::tablebase::SyzygyTablebases;
+using apollo::tablebase::Wdl;
+
+namespace {
+
+std::optional<Wdl> ProbeKpk(const char* fen) {
+  return Kpk().Probe(Position(fen));
+}
+
+// Piece codes of Syzygy tables.
+constexpr uint8_t kWhitePawn = 1;
+constexpr uint8_t kWhiteRook = 4;
+constexpr uint8_t kWhiteKing = 6;
+constexpr uint8_t kBlackKing = 14;
+
+// The value of each placement of a table's pieces, given their squares in
+// the table's order and the side to move (0 for white), or nothing if the
+// placement can't occur.
+using PlacementValue =
+    std::function<std::optional<int>(const Square* squares, int side)>;
+
+void Put(std::string& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out += static_cast<char>((value >> (8 * i)) & 0xff);
+  }
+}
+
+void Align(std::string& out, size_t alignment) {
+  while (out.size() % alignment != 0) {
+    out += '\0';
+  }
+}
+
+// Writes a three-piece Syzygy table, laid out like the generator's tables
+// but with every value stored as a fixed-length code rather than compressed.
+// The pieces are listed in the order the table encodes them, with white's
+// pieces as the table's white pieces; a DTZ table only has white to move,
+// in moves. The tables in these tests can't be vendored from the published
+// sets, which are only available online, so they're written this way.
+void WriteTable(const std::filesystem::path& path, bool dtz,
+                const std::vector<uint8_t>& pieces,
+                const PlacementValue& value) {
+  bool has_pawns = pieces[0] == kWhitePawn;
+  int sides = dtz ? 1 : 2;
+  int files = has_pawns ? 4 : 1;
+
+  std::vector<std::vector<int>> parts;
+  int value_count = 1;
+  for (int file = 0; file < files; file++) {
+    SyzygyEncoding encoding(pieces.data(), 3, 0, 0xf, static_cast<File>(file));
+    for (int side = 0; side < sides; side++) {
+      std::vector<int> values(encoding.Size());
+      Square squares[3];
+      for (int a = 0; a < 64; a++) {
+        squares[0] = static_cast<Square>(a);
+        if (has_pawns && (a < 8 || a >= 56)) {
+          continue;
+        }
+        for (int b = 0; b < 64; b++) {
+          for (int c = 0; c < 64; c++) {
+            if (a == b || a == c || b == c) {
+              continue;
+            }
+            squares[1] = static_cast<Square>(b);
+            squares[2] = static_cast<Square>(c);
+            Square placed[3] = {squares[0], squares[1], squares[2]};
+            if (has_pawns &&
+                SyzygyEncoding::LeadingPawnFile(placed, 1) != file) {
+              continue;
+            }
+            std::optional<int> v = value(squares, side);
+            if (v) {
+              values[encoding.Index(placed)] = *v;
+              value_count = std::max(value_count, *v + 1);
+            }
+          }
+        }
+      }
+      parts.push_back(std::move(values));
+    }
+  }
+
+  int bits = 1;
+  while ((1 << bits) < value_count) {
+    bits++;
+  }
+  // 32-byte blocks and a sparse index entry every 64 values.
+  const uint64_t block_size = 32;
+  const uint64_t span = 64;
+  const uint64_t per_block = block_size * 8 / bits;
+
+  std::string out = dtz ? "\xd7\x66\x0c\xa5" : "\x71\xe8\x23\x5d";
+  out += static_cast<char>(1 | (has_pawns ? 2 : 0));
+  for (int file = 0; file < files; file++) {
+    out += '\0';
+    for (uint8_t piece : pieces) {
+      out += static_cast<char>(piece | piece << 4);
+    }
+  }
+  Align(out, 2);
+
+  // Every symbol is a single value with a code of the same length.
+  for (const std::vector<int>& values : parts) {
+    uint64_t blocks = (values.size() + per_block - 1) / per_block;
+    out += '\0';
+    out += '\5';
+    out += '\6';
+    out += '\0';
+    Put(out, blocks, 4);
+    out += static_cast<char>(bits);
+    out += static_cast<char>(bits);
+    Put(out, 0, 2);
+    Put(out, value_count, 2);
+    for (int symbol = 0; symbol < value_count; symbol++) {
+      Put(out, symbol | 0xfff << 12, 3);
+    }
+    Align(out, 2);
+  }
+  for (const std::vector<int>& values : parts) {
+    uint64_t blocks = (values.size() + per_block - 1) / per_block;
+    for (uint64_t index = span / 2; index - span / 2 < values.size();
+         index += span) {
+      uint64_t block = std::min(index / per_block, blocks - 1);
+      Put(out, block, 4);
+      Put(out, index - block * per_block, 2);
+    }
+  }
+  for (const std::vector<int>& values : parts) {
+    for (uint64_t start = 0; start < values.size(); start += per_block) {
+      Put(out, std::min<uint64_t>(per_block, values.size() - start) - 1, 2);
+    }
+  }
+  for (const std::vector<int>& values : parts) {
+    Align(out, 64);
+    for (uint64_t start = 0; start < values.size(); start += per_block) {
+      std::string block(block_size, '\0');
+      uint64_t end = std::min<uint64_t>(start + per_block, values.size());
+      for (uint64_t i = start; i < end; i++) {
+        for (int bit = 0; bit < bits; bit++) {
+          uint64_t at = (i - start) * bits + bit;
+          if ((values[i] >> (bits - 1 - bit)) & 1) {
+            block[at / 8] |= static_cast<char>(0x80 >> (at % 8));
+          }
+        }
+      }
+      out += block;
+    }
+  }
+  do {
+    out += '\0';
+  } while (out.size() % 64 != 16);
+
+  std::ofstream(path, std::ios::binary) << out;
+}
+
+// Returns a position with the given pieces, by FEN letter.
+Position Place(const std::vector<std::pair<char, Square>>& pieces,
+               bool white_to_move) {
+  std::string board(64, '\0');
+  for (auto [letter, sq] : pieces) {
+    board[sq] = letter;
+  }
+  std::string fen;
+  for (int rank = 7; rank >= 0; rank--) {
+    int empty = 0;
+    for (int file = 0; file < 8; file++) {
+      char letter = board[rank * 8 + file];
+      if (!letter) {
+        empty++;
+        continue;
+      }
+      if (empty > 0) {
+        fen += static_cast<char>('0' + empty);
+        empty = 0;
+      }
+      fen += letter;
+    }
+    if (empty > 0) {
+      fen += static_cast<char>('0' + empty);
+    }
+    fen += rank > 0 ? "/" : "";
+  }
+  fen += white_to_move ? " w - - 0 1" : " b - - 0 1";
+  return Position(fen);
+}
+
+Square Flip(Square sq) { return static_cast<Square>(sq ^ 56); }
+
+int Distance(Square a, Square b) {
+  return std::max(std::abs(apollo::util::RankOf(a) - apollo::util::RankOf(b)),
+                  std::abs(apollo::util::FileOf(a) - apollo::util::FileOf(b)));
+}
+
+// The WDL value of king and pawn versus king, from the bitbase.
+std::optional<int> KpkValue(const Square* squares, int side) {
+  Square pawn = squares[0];
+  Square strong_king = squares[1];
+  Square weak_king = squares[2];
+  if (KingAttacks(strong_king).Test(weak_king) ||
+      (side == 0 && PawnAttacks(pawn, apollo::kWhite).Test(weak_king))) {
+    return {};
+  }
+  if (!Kpk().Wins(strong_king, pawn, weak_king, side == 0)) {
+    return 2;
+  }
+  return side == 0 ? 4 : 0;
+}
+
+// King and rook versus king is won unless the rook is lost at once or the
+// lone king is stalemated.
+std::optional<Wdl> KrkResult(Square king, Square rook, Square weak_king,
+                             bool white_to_move) {
+  Bitboard kings;
+  kings.Set(king);
+  kings.Set(weak_king);
+  bool check = RookAttacks(rook, kings).Test(weak_king);
+  if (KingAttacks(king).Test(weak_king) || (white_to_move && check)) {
+    return {};
+  }
+  if (white_to_move) {
+    return apollo::tablebase::kWdlWin;
+  }
+
+  // The lone king can't hide from the rook behind itself.
+  Bitboard white_king;
+  white_king.Set(king);
+  Bitboard guarded = KingAttacks(king) | RookAttacks(rook, white_king);
+  if (KingAttacks(weak_king).Test(rook) && !KingAttacks(king).Test(rook)) {
+    return apollo::tablebase::kWdlDraw;
+  }
+  if ((KingAttacks(weak_king) & ~guarded).Empty() && !check) {
+    return apollo::tablebase::kWdlDraw;
+  }
+  return apollo::tablebase::kWdlLoss;
+}
+
+std::optional<int> KrkValue(const Square* squares, int side) {
+  std::optional<Wdl> result = KrkResult(squares[0], squares[1], squares[2],
+                                        side == 0);
+  if (!result) {
+    return {};
+  }
+  return *result + 2;
+}
+
+class SyzygyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ =
+        std::filesystem::temp_directory_path() / "apollo_tablebase_test";
+    std::filesystem::remove_all(directory_);
+    std::filesystem::create_directories(directory_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  std::filesystem::path directory_;
+};
+
+}  // anonymous namespace
+
+TEST(KpkTest, PawnRunsAway) {
+  ASSERT_EQ(apollo::tablebase::kWdlWin,
+            ProbeKpk("k7/8/8/8/4P3/8/8/4K3 w - - 0 1"));
+}
+
+TEST(KpkTest, KingInFrontOnTheSixthWins) {
+  ASSERT_EQ(apollo::tablebase::kWdlWin,
+            ProbeKpk("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1"));
+  ASSERT_EQ(apollo::tablebase::kWdlLoss,
+            ProbeKpk("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1"));
+}
+
+TEST(KpkTest, OppositionDecides) {
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            ProbeKpk("8/8/4k3/8/4K3/4P3/8/8 w - - 0 1"));
+  ASSERT_EQ(apollo::tablebase::kWdlLoss,
+            ProbeKpk("8/8/4k3/8/4K3/4P3/8/8 b - - 0 1"));
+}
+
+TEST(KpkTest, BlackPawn) {
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            ProbeKpk("8/8/4p3/4k3/8/4K3/8/8 b - - 0 1"));
+  ASSERT_EQ(apollo::tablebase::kWdlLoss,
+            ProbeKpk("8/8/4p3/4k3/8/4K3/8/8 w - - 0 1"));
+  ASSERT_EQ(apollo::tablebase::kWdlWin,
+            ProbeKpk("8/8/8/8/4p3/4k3/8/4K3 b - - 0 1"));
+}
+
+TEST(KpkTest, RookPawnIsDrawn) {
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            ProbeKpk("k7/8/K7/P7/8/8/8/8 w - - 0 1"));
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            ProbeKpk("7k/8/7K/7P/8/8/8/8 b - - 0 1"));
+}
+
+TEST(KpkTest, OtherMaterial) {
+  ASSERT_FALSE(ProbeKpk("4k3/8/8/8/8/8/8/3QK3 w - - 0 1"));
+  ASSERT_FALSE(ProbeKpk("4k3/4p3/8/8/8/8/4P3/4K3 w - - 0 1"));
+}
+
+TEST(BitbasesTest, BareKingsAreDrawn) {
+  Bitbases bitbases;
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            bitbases.ProbeWdl(Position("4k3/8/8/8/8/8/8/4K3 w - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlWin,
+            bitbases.ProbeWdl(Position("k7/8/8/8/4P3/8/8/4K3 w - - 0 1")));
+}
+
+TEST(KpkEvaluationTest, DrawsScoreZero) {
+  Position pos("k7/8/K7/P7/8/8/8/8 w - - 0 1");
+  ASSERT_EQ(0, ShannonEvaluator().Evaluate(pos));
+  ASSERT_EQ(0, TaperedEvaluator().Evaluate(pos));
+}
+
+TEST(KpkEvaluationTest, WinsGetBonus) {
+  // The bonus is from white's point of view, whoever is to move.
+  Position white_pawn("k7/8/8/8/4P3/8/8/4K3 w - - 0 1");
+  ASSERT_GT(ShannonEvaluator().Evaluate(white_pawn), 10);
+  ASSERT_GT(TaperedEvaluator().Evaluate(white_pawn), 10);
+
+  Position black_pawn("8/8/8/8/4p3/4k3/8/4K3 b - - 0 1");
+  ASSERT_LT(ShannonEvaluator().Evaluate(black_pawn), -10);
+  ASSERT_LT(TaperedEvaluator().Evaluate(black_pawn), -10);
+}
+
+TEST(MaterialNameTest, OrdersPieces) {
+  Position pos("4k3/4p3/8/8/8/8/3RP3/4K1N1 w - - 0 1");
+  ASSERT_EQ("KRNPvKP", MaterialName(pos, apollo::kWhite));
+  ASSERT_EQ("KPvKRNP", MaterialName(pos, apollo::kBlack));
+}
+
+TEST_F(SyzygyTest, FindsTables) {
+  for (const char* name : {"KQvK.rtbw", "KQvK.rtbz", "KRPvKR.rtbw"}) {
+    std::ofstream(directory_ / name) << "table";
+  }
+  std::ofstream(directory_ / "README.txt") << "readme";
+
+  SyzygyTablebases tablebases("/nonexistent:" + directory_.string());
+  ASSERT_EQ(3u, tablebases.TableCount());
+  ASSERT_EQ(5, tablebases.MaxPieces());
+}
+
+TEST_F(SyzygyTest, IgnoresInvalidTables) {
+  // Right magic, but no header.
+  std::ofstream(directory_ / "KQvK.rtbw", std::ios::binary)
+      << std::string("\x71\xe8\x23\x5d\0\0\0\0", 8);
+  SyzygyTablebases tablebases(directory_.string());
+  ASSERT_FALSE(tablebases.ProbeWdl(Position("4k3/8/8/8/8/8/8/3QK3 b - - 0 1")));
+}
+
+TEST_F(SyzygyTest, KingAndPawnWdl) {
+  WriteTable(directory_ / "KPvK.rtbw", false,
+             {kWhitePawn, kWhiteKing, kBlackKing}, KpkValue);
+  SyzygyTablebases tablebases(directory_.string());
+  ASSERT_EQ(apollo::tablebase::kWdlWin,
+            tablebases.ProbeWdl(Position("k7/8/8/8/4P3/8/8/4K3 w - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            tablebases.ProbeWdl(Position("8/8/4k3/8/4K3/4P3/8/8 w - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlLoss,
+            tablebases.ProbeWdl(Position("8/8/4k3/8/4K3/4P3/8/8 b - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            tablebases.ProbeWdl(Position("7k/8/7K/7P/8/8/8/8 b - - 0 1")));
+
+  // Every pawn square, with a sample of king squares, for both colors.
+  for (int pawn = 8; pawn < 56; pawn++) {
+    for (int king = 0; king < 64; king++) {
+      for (int weak_king = (pawn + king) % 7; weak_king < 64; weak_king += 7) {
+        Square squares[3] = {static_cast<Square>(pawn),
+                             static_cast<Square>(king),
+                             static_cast<Square>(weak_king)};
+        if (pawn == king || pawn == weak_king || king == weak_king) {
+          continue;
+        }
+        for (int side = 0; side < 2; side++) {
+          if (!KpkValue(squares, side)) {
+            continue;
+          }
+          Position pos = Place(
+              {{'P', squares[0]}, {'K', squares[1]}, {'k', squares[2]}},
+              side == 0);
+          ASSERT_EQ(Kpk().Probe(pos), tablebases.ProbeWdl(pos)) << pos;
+          Position flipped = Place({{'p', Flip(squares[0])},
+                                    {'k', Flip(squares[1])},
+                                    {'K', Flip(squares[2])}},
+                                   side == 1);
+          ASSERT_EQ(Kpk().Probe(pos), tablebases.ProbeWdl(flipped))
+              << flipped;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(SyzygyTest, KingAndRookWdl) {
+  WriteTable(directory_ / "KRvK.rtbw", false,
+             {kWhiteKing, kWhiteRook, kBlackKing}, KrkValue);
+  SyzygyTablebases tablebases(directory_.string());
+  ASSERT_EQ(apollo::tablebase::kWdlLoss,
+            tablebases.ProbeWdl(Position("k7/2K5/8/8/8/8/8/R7 b - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            tablebases.ProbeWdl(Position("8/8/8/8/8/1K6/1R6/k7 b - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlDraw,
+            tablebases.ProbeWdl(Position("8/8/8/8/8/8/1R6/k6K b - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlWin,
+            tablebases.ProbeWdl(Position("8/8/8/8/8/8/8/r3k2K b - - 0 1")));
+  ASSERT_EQ(apollo::tablebase::kWdlLoss,
+            tablebases.ProbeWdl(Position("8/8/8/8/8/8/8/r3k2K w - - 0 1")));
+
+  for (int king = 0; king < 64; king++) {
+    for (int rook = king % 5; rook < 64; rook += 5) {
+      for (int weak_king = 0; weak_king < 64; weak_king++) {
+        if (king == rook || king == weak_king || rook == weak_king) {
+          continue;
+        }
+        Square squares[3] = {static_cast<Square>(king),
+                             static_cast<Square>(rook),
+                             static_cast<Square>(weak_king)};
+        for (int side = 0; side < 2; side++) {
+          std::optional<Wdl> expected =
+              KrkResult(squares[0], squares[1], squares[2], side == 0);
+          if (!expected) {
+            continue;
+          }
+          Position pos = Place(
+              {{'K', squares[0]}, {'R', squares[1]}, {'k', squares[2]}},
+              side == 0);
+          ASSERT_EQ(expected, tablebases.ProbeWdl(pos)) << pos;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(SyzygyTest, KingAndRookDtz) {
+  // The distance stored for each position is the distance between the
+  // kings, in moves, which the board's symmetries keep the same.
+  WriteTable(directory_ / "KRvK.rtbw", false,
+             {kWhiteKing, kWhiteRook, kBlackKing}, KrkValue);
+  WriteTable(directory_ / "KRvK.rtbz", true,
+             {kWhiteKing, kWhiteRook, kBlackKing},
+             [](const Square* squares, int side) -> std::optional<int> {
+               if (!KrkValue(squares, side)) {
+                 return {};
+               }
+               return Distance(squares[0], squares[2]);
+             });
+  SyzygyTablebases tablebases(directory_.string());
+  ASSERT_EQ(9, tablebases.ProbeDtz(Position("8/8/8/4k3/8/8/8/R3K3 w - - 0 1")));
+  ASSERT_EQ(-1, tablebases.ProbeDtz(Position("k7/2K5/8/8/8/8/8/R7 b - - 0 1")));
+  ASSERT_EQ(0, tablebases.ProbeDtz(Position("8/8/8/8/8/1K6/1R6/k7 b - - 0 1")));
+
+  for (int king = 0; king < 64; king++) {
+    for (int rook = king % 5; rook < 64; rook += 5) {
+      for (int weak_king = 0; weak_king < 64; weak_king++) {
+        if (king == rook || king == weak_king || rook == weak_king) {
+          continue;
+        }
+        Square squares[3] = {static_cast<Square>(king),
+                             static_cast<Square>(rook),
+                             static_cast<Square>(weak_king)};
+        for (int side = 0; side < 2; side++) {
+          std::optional<Wdl> result =
+              KrkResult(squares[0], squares[1], squares[2], side == 0);
+          if (!result) {
+            continue;
+          }
+          Position pos = Place(
+              {{'K', squares[0]}, {'R', squares[1]}, {'k', squares[2]}},
+              side == 0);
+
+          // With white to move, the table has the distance. With black to
+          // move, it's one more than the longest distance after a move.
+          int expected = 0;
+          if (side == 0) {
+            expected = 2 * Distance(squares[0], squares[2]) + 1;
+          } else if (*result == apollo::tablebase::kWdlLoss) {
+            expected = -1;
+            for (apollo::Move mov : pos.LegalMoves()) {
+              expected = std::min(
+                  expected, -2 * Distance(squares[0], mov.Destination()) - 2);
+            }
+          }
+          ASSERT_EQ(expected, tablebases.ProbeDtz(pos)) << pos;
+        }
+      }
+    }
+  }
+}
+
+TEST_F(SyzygyTest, SearchKeepsTheWin) {
+  WriteTable(directory_ / "KRvK.rtbw", false,
+             {kWhiteKing, kWhiteRook, kBlackKing}, KrkValue);
+  auto tablebases = std::make_shared<SyzygyTablebases>(directory_.string());
+  Searcher searcher(std::make_unique<ShannonEvaluator>());
+  searcher.SetTablebases(tablebases);
+
+  // The king attacks the rook, and only the moves that save it are
+  // searched.
+  Position pos("8/8/8/8/8/8/1k6/R3K3 w - - 0 1");
+  SearchResult result = searcher.Search(pos, 2);
+  ASSERT_GT(result.stats.tb_hits, 0u);
+  pos.MakeMove(result.best_move);
+  ASSERT_EQ(apollo::tablebase::kWdlLoss, tablebases->ProbeWdl(pos));
+}
@@ -0,0 +1,59 @@
+#include "gtest/gtest.h"
+
+#include "evaluators/shannon_evaluator.h"
+#include "position.h"
+#include "training/texel_tuner.h"
+
+using apollo::Position;
+using apollo::evaluators::kShannonFeatureCount;
+using apollo::evaluators::ShannonEvaluator;
+using apollo::evaluators::ShannonFeatures;
+using apollo::evaluators::ShannonWeights;
+using apollo::training::TexelTuner;
+
+TEST(ShannonFeaturesTest, EvaluateIsLinear) {
+  const char* fens[] = {
+      apollo::kFenDefaultPosition,
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  };
+  ShannonEvaluator evaluator;
+  for (const char* fen : fens) {
+    Position pos(fen);
+    ShannonFeatures features = ShannonEvaluator::Features(pos);
+    double score = 0;
+    for (int i = 0; i < kShannonFeatureCount; i++) {
+      score += ShannonEvaluator::Weights()[i] * features[i];
+    }
+    ASSERT_DOUBLE_EQ(score, evaluator.Evaluate(pos));
+  }
+}
+
+TEST(ShannonFeaturesTest, CountsMaterial) {
+  Position pos("4k3/8/8/8/8/8/PP6/3QK3 w - - 0 1");
+  ShannonFeatures features = ShannonEvaluator::Features(pos);
+  ASSERT_EQ(0, features[apollo::evaluators::kShannonKings]);
+  ASSERT_EQ(1, features[apollo::evaluators::kShannonQueens]);
+  ASSERT_EQ(2, features[apollo::evaluators::kShannonPawns]);
+}
+
+TEST(TexelTunerTest, StepsReduceError) {
+  // Being a pawn up wins every time, which the default weights undersell.
+  TexelTuner tuner(2, 0.05);
+  for (int i = 0; i < 10; i++) {
+    tuner.Add(Position("4k3/p7/8/8/8/8/PP6/4K3 w - - 0 1"), 1);
+    tuner.Add(Position("4k3/pp6/8/8/8/8/P7/4K3 w - - 0 1"), 0);
+    tuner.Add(Position("4k3/p7/8/8/8/8/P7/4K3 w - - 0 1"), 0.5);
+  }
+  ASSERT_EQ(30, tuner.Size());
+
+  ShannonWeights weights = ShannonEvaluator::Weights();
+  tuner.FitScale(weights);
+  double initial = tuner.Error(weights);
+  for (int i = 0; i < 50; i++) {
+    tuner.Step(weights);
+  }
+  ASSERT_LT(tuner.Error(weights), initial);
+  ASSERT_EQ(ShannonEvaluator::Weights()[apollo::evaluators::kShannonKings],
+            weights[apollo::evaluators::kShannonKings]);
+}
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "training/texel_tuner.h"
+
+namespace apollo::training {
+
+using evaluators::kShannonFeatureCount;
+using evaluators::kShannonKings;
+using evaluators::ShannonEvaluator;
+using evaluators::ShannonFeatures;
+using evaluators::ShannonWeights;
+
+namespace {
+
+constexpr size_t kFeatures = kShannonFeatureCount;
+
+// The Adam hyperparameters recommended by its authors.
+const double kAdamBeta1 = 0.9;
+const double kAdamBeta2 = 0.999;
+const double kAdamEpsilon = 1e-8;
+
+double Sigmoid(double scale, double eval) {
+  return 1 / (1 + std::exp(-scale * eval));
+}
+
+double Dot(const ShannonWeights& weights, const int16_t* features) {
+  double eval = 0;
+  for (size_t i = 0; i < kFeatures; i++) {
+    eval += weights[i] * features[i];
+  }
+  return eval;
+}
+
+}  // anonymous namespace
+
+TexelTuner::TexelTuner(int threads, double learning_rate)
+    : threads_(std::max(threads, 1)),
+      learning_rate_(learning_rate),
+      scale_(1),
+      first_moments_(),
+      second_moments_(),
+      steps_(0) {}
+
+void TexelTuner::Add(const Position& pos, double result) {
+  ShannonFeatures features = ShannonEvaluator::Features(pos);
+  for (int feature : features) {
+    features_.push_back(static_cast<int16_t>(feature));
+  }
+  results_.push_back(static_cast<float>(result));
+}
+
+template <typename Work>
+void TexelTuner::ParallelFor(Work work) const {
+  size_t chunk = (Size() + threads_ - 1) / threads_;
+  std::vector<std::thread> workers;
+  for (int thread = 0; thread < threads_; thread++) {
+    size_t begin = std::min(Size(), thread * chunk);
+    size_t end = std::min(Size(), begin + chunk);
+    workers.emplace_back(work, thread, begin, end);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+double TexelTuner::Error(const ShannonWeights& weights) const {
+  std::vector<double> errors(threads_);
+  ParallelFor([&](int thread, size_t begin, size_t end) {
+    double error = 0;
+    for (size_t i = begin; i < end; i++) {
+      double eval = Dot(weights, &features_[i * kFeatures]);
+      double diff = results_[i] - Sigmoid(scale_, eval);
+      error += diff * diff;
+    }
+    errors[thread] = error;
+  });
+
+  double error = 0;
+  for (double thread_error : errors) {
+    error += thread_error;
+  }
+  return Size() == 0 ? 0 : error / Size();
+}
+
+double TexelTuner::FitScale(const ShannonWeights& weights) {
+  // The error is convex enough in the scale for a golden section search.
+  const double kGolden = (std::sqrt(5.0) - 1) / 2;
+  double low = 0.01;
+  double high = 10;
+  while (high - low > 1e-4) {
+    double left = high - kGolden * (high - low);
+    double right = low + kGolden * (high - low);
+    scale_ = left;
+    double left_error = Error(weights);
+    scale_ = right;
+    double right_error = Error(weights);
+    if (left_error < right_error) {
+      high = right;
+    } else {
+      low = left;
+    }
+  }
+  scale_ = (low + high) / 2;
+  return scale_;
+}
+
+void TexelTuner::Step(ShannonWeights& weights) {
+  std::vector<ShannonWeights> gradients(threads_);
+  ParallelFor([&](int thread, size_t begin, size_t end) {
+    ShannonWeights gradient = {};
+    for (size_t i = begin; i < end; i++) {
+      const int16_t* features = &features_[i * kFeatures];
+      double sigmoid = Sigmoid(scale_, Dot(weights, features));
+      double term = (sigmoid - results_[i]) * sigmoid * (1 - sigmoid);
+      for (size_t j = 0; j < kFeatures; j++) {
+        gradient[j] += term * features[j];
+      }
+    }
+    gradients[thread] = gradient;
+  });
+
+  steps_++;
+  for (size_t j = 0; j < kFeatures; j++) {
+    if (j == kShannonKings) {
+      continue;
+    }
+
+    double gradient = 0;
+    for (const ShannonWeights& thread_gradient : gradients) {
+      gradient += thread_gradient[j];
+    }
+    gradient *= 2 * scale_ / std::max<size_t>(Size(), 1);
+
+    first_moments_[j] =
+        kAdamBeta1 * first_moments_[j] + (1 - kAdamBeta1) * gradient;
+    second_moments_[j] = kAdamBeta2 * second_moments_[j] +
+                         (1 - kAdamBeta2) * gradient * gradient;
+    double first = first_moments_[j] / (1 - std::pow(kAdamBeta1, steps_));
+    double second = second_moments_[j] / (1 - std::pow(kAdamBeta2, steps_));
+    weights[j] -= learning_rate_ * first / (std::sqrt(second) + kAdamEpsilon);
+  }
+}
+
+}  // namespace apollo::training
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "evaluators/shannon_evaluator.h"
+#include "position.h"
+
+namespace apollo::training {
+
+/**
+ * A TexelTuner tunes the weights of the ShannonEvaluator against the results
+ * of the games that a set of positions came from, by minimizing
+ *
+ *   E = 1/N sum (result - sigmoid(scale * eval))^2
+ *
+ * where results are 1, 0.5 or 0 from white's point of view and the sigmoid
+ * maps an evaluation in pawns to an expected score.
+ *
+ * The evaluator is linear in its features, so each position is reduced to
+ * its feature vector once when it is added, and the error and its gradient
+ * are dot products over a flat array of small integers, computed in parallel
+ * over a number of threads. The weights are optimized by full-batch gradient
+ * descent with Adam.
+ */
+class TexelTuner {
+ public:
+  TexelTuner(int threads, double learning_rate);
+
+  /**
+   * Adds a position to the set, with the result of its game from white's
+   * point of view.
+   */
+  void Add(const Position& pos, double result);
+
+  size_t Size() const { return results_.size(); }
+
+  double Scale() const { return scale_; }
+
+  /**
+   * Returns the mean squared error of the given weights over the set.
+   */
+  double Error(const evaluators::ShannonWeights& weights) const;
+
+  /**
+   * Sets the scale of the sigmoid to the one that minimizes the error of the
+   * given weights, and returns it. This should be done once, with the
+   * weights that are about to be tuned, before any steps are taken.
+   */
+  double FitScale(const evaluators::ShannonWeights& weights);
+
+  /**
+   * Takes one step of gradient descent over the whole set, updating the
+   * weights. The king weight is left alone, since kings are never missing
+   * and it has no effect on the error.
+   */
+  void Step(evaluators::ShannonWeights& weights);
+
+ private:
+  // Splits the set into one contiguous range per thread and calls
+  // work(thread, begin, end) for each, in parallel.
+  template <typename Work>
+  void ParallelFor(Work work) const;
+
+  int threads_;
+  double learning_rate_;
+  double scale_;
+
+  // The feature vectors of every position, one after another.
+  std::vector<int16_t> features_;
+  std::vector<float> results_;
+
+  // The state of the Adam optimizer.
+  evaluators::ShannonWeights first_moments_;
+  evaluators::ShannonWeights second_moments_;
+  int steps_;
+};
+
+}  // namespace apollo::training
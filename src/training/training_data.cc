@@ -0,0 +1,58 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+
+#include "training/training_data.h"
+
+namespace apollo::training {
+
+TrainingDataWriter::TrainingDataWriter(const std::string& path)
+    : fd_(open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644)) {
+  if (fd_ < 0) {
+    throw TrainingDataException(kTrainingDataOpenFailed);
+  }
+  buffer_.reserve(kBufferRecords);
+}
+
+TrainingDataWriter::~TrainingDataWriter() {
+  try {
+    Flush();
+  } catch (const TrainingDataException&) {
+    // There's nobody left to tell.
+  }
+  close(fd_);
+}
+
+void TrainingDataWriter::Flush() {
+  const char* data = reinterpret_cast<const char*>(buffer_.data());
+  size_t remaining = buffer_.size() * sizeof(TrainingRecord);
+  buffer_.clear();
+
+  // Writes to regular files are only ever short when the disk is full or the
+  // write is interrupted, and only the latter is worth retrying.
+  while (remaining > 0) {
+    ssize_t written = write(fd_, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw TrainingDataException(kTrainingDataWriteFailed);
+    }
+    data += written;
+    remaining -= static_cast<size_t>(written);
+  }
+}
+
+TrainingDataReader::TrainingDataReader(const std::string& path)
+    : file_(path, std::ios::binary) {
+  if (!file_) {
+    throw TrainingDataException(kTrainingDataOpenFailed);
+  }
+}
+
+bool TrainingDataReader::Next(TrainingRecord& record) {
+  return static_cast<bool>(
+      file_.read(reinterpret_cast<char*>(&record), sizeof(record)));
+}
+
+}  // namespace apollo::training
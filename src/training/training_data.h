@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "position.h"
+
+namespace apollo::training {
+
+/**
+ * A position from a self-play game, labelled with the score that a search of
+ * it returned and the result of the game it came from. Both are from the
+ * point of view of the side to move. Training data files are nothing but a
+ * sequence of these.
+ */
+struct TrainingRecord {
+  PackedPosition position;
+
+  // The search score in centipawns.
+  int16_t score;
+
+  // 1 if the side to move went on to win, -1 if it lost and 0 for a draw.
+  int8_t result;
+  uint8_t reserved;
+};
+
+static_assert(sizeof(TrainingRecord) == 32,
+              "training records must be 32 bytes long");
+
+enum TrainingDataError {
+  kTrainingDataOpenFailed = 1,
+  kTrainingDataWriteFailed,
+};
+
+class TrainingDataException : std::exception {
+ public:
+  explicit TrainingDataException(TrainingDataError err) : err_(err) {}
+
+  const char* what() const noexcept override {
+    return "training data I/O failed";
+  }
+
+  TrainingDataError Error() const { return err_; }
+
+ private:
+  TrainingDataError err_;
+};
+
+/**
+ * A TrainingDataWriter appends records to a training data file. It is meant
+ * to be owned by a single thread, and any number of threads can each have
+ * their own writer for the same file without any locking between them.
+ *
+ * Records are buffered and the buffer is appended to the file with a single
+ * write to a descriptor opened with O_APPEND, which the kernel positions
+ * atomically, so the records of different writers never interleave.
+ */
+class TrainingDataWriter {
+ public:
+  /**
+   * The number of records buffered before they are written, which comes to
+   * 2 MiB.
+   */
+  static constexpr size_t kBufferRecords = 1 << 16;
+
+  explicit TrainingDataWriter(const std::string& path);
+  ~TrainingDataWriter();
+
+  TrainingDataWriter(const TrainingDataWriter&) = delete;
+  TrainingDataWriter& operator=(const TrainingDataWriter&) = delete;
+
+  void Write(const TrainingRecord& record) {
+    buffer_.push_back(record);
+    if (buffer_.size() == kBufferRecords) {
+      Flush();
+    }
+  }
+
+  /**
+   * Writes every buffered record to the file.
+   */
+  void Flush();
+
+ private:
+  int fd_;
+  std::vector<TrainingRecord> buffer_;
+};
+
+/**
+ * A TrainingDataReader reads the records of a training data file in order.
+ */
+class TrainingDataReader {
+ public:
+  explicit TrainingDataReader(const std::string& path);
+
+  /**
+   * Reads the next record, returning false at the end of the file. A
+   * truncated record at the end of the file is ignored.
+   */
+  bool Next(TrainingRecord& record);
+
+ private:
+  std::ifstream file_;
+};
+
+}  // namespace apollo::training
@@ -0,0 +1,67 @@
+#include <filesystem>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "position.h"
+#include "training/training_data.h"
+
+using apollo::Position;
+using apollo::training::TrainingDataReader;
+using apollo::training::TrainingDataWriter;
+using apollo::training::TrainingRecord;
+
+class TrainingDataTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    path_ = (std::filesystem::temp_directory_path() / "apollo_training_test")
+                .string();
+    std::filesystem::remove(path_);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::string path_;
+};
+
+TEST_F(TrainingDataTest, RoundTrip) {
+  Position pos;
+  {
+    TrainingDataWriter writer(path_);
+    writer.Write({pos.Pack(), 25, 1, 0});
+    writer.Write({pos.Pack(), -300, -1, 0});
+  }
+  ASSERT_EQ(2 * sizeof(TrainingRecord), std::filesystem::file_size(path_));
+
+  TrainingDataReader reader(path_);
+  TrainingRecord record;
+  ASSERT_TRUE(reader.Next(record));
+  ASSERT_EQ(pos.AsFen(), Position::Unpack(record.position).AsFen());
+  ASSERT_EQ(25, record.score);
+  ASSERT_EQ(1, record.result);
+  ASSERT_TRUE(reader.Next(record));
+  ASSERT_EQ(-300, record.score);
+  ASSERT_EQ(-1, record.result);
+  ASSERT_FALSE(reader.Next(record));
+}
+
+TEST_F(TrainingDataTest, WritersAppend) {
+  Position pos;
+  {
+    TrainingDataWriter first(path_);
+    TrainingDataWriter second(path_);
+    for (int i = 0; i < 3; i++) {
+      first.Write({pos.Pack(), 1, 0, 0});
+      second.Write({pos.Pack(), 2, 0, 0});
+    }
+    first.Flush();
+  }
+
+  // Each writer's records land in the file as one block.
+  TrainingDataReader reader(path_);
+  TrainingRecord record;
+  for (int expected : {1, 1, 1, 2, 2, 2}) {
+    ASSERT_TRUE(reader.Next(record));
+    ASSERT_EQ(expected, record.score);
+  }
+  ASSERT_FALSE(reader.Next(record));
+}
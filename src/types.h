@@ -114,7 +114,7 @@ constexpr std::array<File, kFileLast> kFiles = {
 
 enum Color { kWhite, kBlack, kColorLast };
 
-inline Color operator!(Color c) { return c == kWhite ? kBlack : kWhite; }
+constexpr Color operator!(Color c) { return c == kWhite ? kBlack : kWhite; }
 inline std::ostream& operator<<(std::ostream& os, Color c) {
   if (c == kWhite) {
     os << "w";
@@ -1,9 +1,18 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
 #include <iterator>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "evaluators/nnue_evaluator.h"
+#include "evaluators/shannon_evaluator.h"
+#include "nnue/network.h"
+#include "tablebase/syzygy.h"
 #include "uci.h"
 
 namespace apollo {
@@ -17,6 +26,48 @@ void Split(const std::string& str, char delimiter, TOut out) {
   }
 }
 
+namespace {
+
+// Scores are in pawns, and infinite once a side is mated. UCI wants
+// centipawns, so losses and wins are clamped to a large finite score.
+constexpr double kMaxCentipawns = 30000;
+
+long ScoreToCentipawns(double score) {
+  return std::lround(std::clamp(score * 100, -kMaxCentipawns, kMaxCentipawns));
+}
+
+// Spin options, as their minimum, default and maximum.
+struct SpinOption {
+  long min;
+  long max;
+};
+
+constexpr SpinOption kHashOption = {0, 1024};
+constexpr SpinOption kThreadsOption = {1, 512};
+constexpr SpinOption kMultiPvOption = {1, 256};
+constexpr SpinOption kMoveOverheadOption = {0, 5000};
+
+// Returns the value of a spin option clamped to its range, or nothing if the
+// value isn't a number.
+std::optional<long> ParseSpin(const std::string& value, SpinOption option) {
+  char* end = nullptr;
+  long parsed = std::strtol(value.c_str(), &end, 10);
+  if (value.empty() || *end != '\0') {
+    return {};
+  }
+  return std::clamp(parsed, option.min, option.max);
+}
+
+// Without a "movestogo", the remaining time is shared as if this many moves
+// were left in the game. A fraction of the increment is spent on top.
+constexpr int kDefaultMovesToGo = 30;
+
+// The depth of a search without any limits.
+constexpr int kDefaultGoDepth = 5;
+constexpr double kIncrementFraction = 0.75;
+
+}  // anonymous namespace
+
 void UciServer::Run() {
   std::string line;
   while (true) {
@@ -41,14 +92,22 @@ void UciServer::Run() {
       HandleGo(line);
       continue;
     }
+    if (line.rfind("setoption ") == 0) {
+      HandleSetOption(line);
+      continue;
+    }
     if (line == "isready") {
       out_ << "readyok" << std::endl;
       continue;
     }
     if (line == "ucinewgame") {
+      HandleNewGame();
       continue;
     }
-    if (line == "stop") {
+    if (line == "stop" || line == "ponderhit") {
+      // Searches are synchronous, so the only thing left to stop is a
+      // finished ponder search whose move hasn't been sent.
+      FlushPendingBestMove();
       continue;
     }
     if (line == "quit") {
@@ -72,6 +131,26 @@ void UciServer::HandleUci() {
   out_ << "id name "
        << "apollo3 0.1" << std::endl;
   out_ << "id author Sean Gillespie" << std::endl;
+  out_ << "option name Evaluator type combo default shannon var shannon var "
+          "nnue"
+       << std::endl;
+  out_ << "option name EvalFile type string default <empty>" << std::endl;
+  out_ << "option name Hash type spin default 1 min " << kHashOption.min
+       << " max " << kHashOption.max << std::endl;
+  out_ << "option name Clear Hash type button" << std::endl;
+  out_ << "option name EvalCache type spin default 1 min " << kHashOption.min
+       << " max " << kHashOption.max << std::endl;
+  out_ << "option name Threads type spin default 1 min " << kThreadsOption.min
+       << " max " << kThreadsOption.max << std::endl;
+  out_ << "option name MultiPV type spin default 1 min " << kMultiPvOption.min
+       << " max " << kMultiPvOption.max << std::endl;
+  out_ << "option name Ponder type check default false" << std::endl;
+  out_ << "option name Move Overhead type spin default "
+       << kDefaultMoveOverheadMs << " min " << kMoveOverheadOption.min
+       << " max " << kMoveOverheadOption.max << std::endl;
+  out_ << "option name OwnBook type check default false" << std::endl;
+  out_ << "option name BookFile type string default <empty>" << std::endl;
+  out_ << "option name SyzygyPath type string default <empty>" << std::endl;
   out_ << "uciok" << std::endl;
 }
 
@@ -100,7 +179,8 @@ void UciServer::HandlePosition(const std::string& line) {
     Split(moves_str, ' ', std::back_inserter(moves));
     for (auto move : moves) {
       auto parsed_move = pos_.MoveFromUci(move);
-      if (parsed_move) {
+      if (parsed_move &&
+          (parsed_move->IsNull() || pos_.IsLegal(*parsed_move))) {
         log_ << "position: applying move: " << *parsed_move << std::endl;
         pos_.MakeMove(*parsed_move);
         log_ << pos_ << std::endl;
@@ -114,13 +194,282 @@ void UciServer::HandlePosition(const std::string& line) {
   log_ << pos_ << std::endl;
 }
 
+void UciServer::HandleSetOption(const std::string& line) {
+  // setoption name <id> [value <x>]. Both the name and the value may contain
+  // spaces.
+  size_t name_idx = line.find("name ");
+  if (name_idx == std::string::npos) {
+    log_ << "setoption: no option name" << std::endl;
+    return;
+  }
+  size_t value_idx = line.find(" value ");
+  std::string name;
+  std::string value;
+  if (value_idx == std::string::npos) {
+    name = line.substr(name_idx + 5);
+  } else {
+    name = line.substr(name_idx + 5, value_idx - name_idx - 5);
+    value = line.substr(value_idx + 7);
+  }
+
+  log_ << "setoption: " << name << " = " << value << std::endl;
+  if (name == "EvalFile") {
+    eval_file_ = value;
+    return;
+  }
+  if (name == "Evaluator") {
+    SetEvaluator(value);
+    return;
+  }
+  if (name == "EvalCache" || name == "Hash") {
+    // Both options are in MiB. Until there is a transposition table, the eval
+    // cache is the only hash table, so Hash sizes it too.
+    std::optional<long> megabytes = ParseSpin(value, kHashOption);
+    if (!megabytes) {
+      log_ << "setoption: bad value for " << name << std::endl;
+      return;
+    }
+    std::lock_guard lock(position_lock_);
+    searcher_.ResizeEvalCache(search::EvalCache::EntriesInBytes(
+        static_cast<size_t>(*megabytes) << 20));
+    return;
+  }
+  if (name == "Clear Hash") {
+    std::lock_guard lock(position_lock_);
+    searcher_.ClearEvalCache();
+    return;
+  }
+  if (name == "Threads" || name == "MultiPV" || name == "Move Overhead") {
+    SpinOption option = name == "Threads"   ? kThreadsOption
+                        : name == "MultiPV" ? kMultiPvOption
+                                            : kMoveOverheadOption;
+    std::optional<long> parsed = ParseSpin(value, option);
+    if (!parsed) {
+      log_ << "setoption: bad value for " << name << std::endl;
+      return;
+    }
+    int& target = name == "Threads"   ? threads_
+                  : name == "MultiPV" ? multi_pv_
+                                      : move_overhead_ms_;
+    target = static_cast<int>(*parsed);
+    if (name == "Threads" && threads_ > 1) {
+      out_ << "info string the search is single-threaded, ignoring Threads "
+           << threads_ << std::endl;
+    }
+    return;
+  }
+  if (name == "Ponder") {
+    ponder_ = value == "true";
+    return;
+  }
+  if (name == "OwnBook") {
+    own_book_ = value == "true";
+    return;
+  }
+  if (name == "BookFile") {
+    SetBookFile(value);
+    return;
+  }
+  if (name == "SyzygyPath") {
+    SetSyzygyPath(value);
+    return;
+  }
+  log_ << "setoption: unknown option " << name << std::endl;
+}
+
+void UciServer::HandleNewGame() {
+  // Nothing from the last game should carry over into the next one. The eval
+  // cache is the only state the searcher keeps between searches.
+  std::lock_guard lock(position_lock_);
+  pending_bestmove_.clear();
+  searcher_.ClearEvalCache();
+}
+
+void UciServer::FlushPendingBestMove() {
+  if (!pending_bestmove_.empty()) {
+    out_ << pending_bestmove_ << std::endl;
+    pending_bestmove_.clear();
+  }
+}
+
+search::SearchLimits UciServer::ParseGo(const std::string& line,
+                                        bool& ponder) const {
+  std::vector<std::string> tokens;
+  Split(line, ' ', std::back_inserter(tokens));
+  long depth = 0;
+  long nodes = 0;
+  long movetime = -1;
+  long time_left[2] = {-1, -1};
+  long increment[2] = {0, 0};
+  long moves_to_go = 0;
+  ponder = false;
+  for (size_t i = 1; i < tokens.size(); i++) {
+    const std::string& token = tokens[i];
+    if (token == "ponder") {
+      // A GUI that hasn't turned Ponder on shouldn't send "go ponder"; if one
+      // does, the search is treated as a normal one.
+      ponder = ponder_;
+      continue;
+    }
+    if (i + 1 >= tokens.size()) {
+      continue;
+    }
+    long* field = token == "depth"       ? &depth
+                  : token == "nodes"     ? &nodes
+                  : token == "movetime"  ? &movetime
+                  : token == "wtime"     ? &time_left[kWhite]
+                  : token == "btime"     ? &time_left[kBlack]
+                  : token == "winc"      ? &increment[kWhite]
+                  : token == "binc"      ? &increment[kBlack]
+                  : token == "movestogo" ? &moves_to_go
+                                         : nullptr;
+    if (field) {
+      *field = std::strtol(tokens[++i].c_str(), nullptr, 10);
+    }
+  }
+
+  // Time is budgeted in milliseconds, less the move overhead, but every move
+  // gets at least a millisecond.
+  search::SearchLimits limits;
+  Color us = pos_.SideToMove();
+  double budget_ms = -1;
+  if (movetime >= 0) {
+    budget_ms = static_cast<double>(movetime);
+  } else if (time_left[us] >= 0) {
+    long moves = moves_to_go > 0 ? moves_to_go : kDefaultMovesToGo;
+    budget_ms = std::min<double>(
+        static_cast<double>(time_left[us]) / moves +
+            increment[us] * kIncrementFraction,
+        static_cast<double>(time_left[us]));
+  }
+  if (budget_ms >= 0) {
+    limits.seconds = std::max(budget_ms - move_overhead_ms_, 1.0) / 1000;
+  }
+  if (depth > 0) {
+    limits.depth = static_cast<int>(std::min<long>(depth, search::kMaxDepth));
+  }
+  if (nodes > 0) {
+    limits.nodes = static_cast<uint64_t>(nodes);
+  }
+
+  // A plain "go", or "go infinite", searches to a fixed depth, since there is
+  // no way yet to stop a search from the outside.
+  if (budget_ms < 0 && depth <= 0 && nodes <= 0) {
+    limits.depth = kDefaultGoDepth;
+  }
+  return limits;
+}
+
+void UciServer::SetBookFile(const std::string& path) {
+  std::lock_guard lock(position_lock_);
+  book_.reset();
+  if (path.empty() || path == "<empty>") {
+    return;
+  }
+
+  try {
+    book_ = book::PolyglotBook::Open(path);
+    log_ << "setoption: loaded book " << path << " with " << book_->Size()
+         << " entries" << std::endl;
+  } catch (const book::BookLoadException& exn) {
+    out_ << "info string failed to load book " << path << ": error "
+         << exn.Error() << std::endl;
+  }
+}
+
+void UciServer::SetSyzygyPath(const std::string& paths) {
+  std::lock_guard lock(position_lock_);
+  if (paths.empty() || paths == "<empty>") {
+    searcher_.SetTablebases(std::make_shared<tablebase::Bitbases>());
+    return;
+  }
+
+  auto tablebases = std::make_shared<tablebase::SyzygyTablebases>(paths);
+  out_ << "info string found " << tablebases->TableCount()
+       << " tablebase files, up to " << tablebases->MaxPieces() << " pieces"
+       << std::endl;
+  // Every set of tables has king and pawn versus king, so the bitbases are
+  // only kept if there are no tables at all.
+  if (tablebases->TableCount() == 0) {
+    searcher_.SetTablebases(std::make_shared<tablebase::Bitbases>());
+    return;
+  }
+  searcher_.SetTablebases(std::move(tablebases));
+}
+
+void UciServer::SetEvaluator(const std::string& name) {
+  std::lock_guard lock(position_lock_);
+  if (name == "shannon") {
+    searcher_.SetEvaluator(std::make_unique<evaluators::ShannonEvaluator>());
+    return;
+  }
+
+  if (name == "nnue") {
+    try {
+      auto network = nnue::Network::Load(eval_file_);
+      log_ << "setoption: loaded network " << eval_file_ << " using "
+           << network->InferenceKernels().name << " kernels" << std::endl;
+      searcher_.SetEvaluator(
+          std::make_unique<evaluators::NnueEvaluator>(std::move(network)));
+    } catch (const nnue::NetworkLoadException& exn) {
+      // Keep the current evaluator if the network can't be loaded.
+      out_ << "info string failed to load network " << eval_file_ << ": error "
+           << exn.Error() << std::endl;
+    }
+    return;
+  }
+
+  log_ << "setoption: unknown evaluator " << name << std::endl;
+}
+
 void UciServer::HandleGo(const std::string& line) {
   // The correct thing to do here is to launch this in another thread.
   // We're being lazy here as we bootstrap the UCI interface.
   std::lock_guard lock(position_lock_);
-  search::SearchResult result = searcher_.Search(pos_, 5);
-  out_ << "info score cp " << result.score << std::endl;
-  out_ << "bestmove " << result.best_move.AsUci() << std::endl;
+  pending_bestmove_.clear();
+  bool ponder = false;
+  search::SearchLimits limits = ParseGo(line, ponder);
+  if (own_book_ && book_) {
+    if (std::optional<Move> book_move = book_->Pick(pos_, book_rng_())) {
+      out_ << "info string book move" << std::endl;
+      pending_bestmove_ = "bestmove " + book_move->AsUci();
+      if (!ponder) {
+        FlushPendingBestMove();
+      }
+      return;
+    }
+  }
+
+  uint64_t nodes = 0;
+  double seconds = 0;
+  searcher_.SetMultiPv(multi_pv_);
+  search::SearchResult result = searcher_.Search(
+      pos_, limits, [&](const search::IterationStats& iteration) {
+        nodes += iteration.nodes;
+        seconds += iteration.seconds;
+        for (size_t i = 0; i < iteration.lines.size(); i++) {
+          const search::PvLine& pv = iteration.lines[i];
+          out_ << "info depth " << iteration.depth << " seldepth "
+               << iteration.seldepth << " multipv " << i + 1 << " score cp "
+               << ScoreToCentipawns(pv.score) << " nodes " << nodes
+               << " nps "
+               << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0)
+               << " time " << static_cast<uint64_t>(seconds * 1000)
+               << " pv " << pv.move.AsUci() << std::endl;
+        }
+      });
+
+  const search::SearchStats& stats = result.stats;
+  out_ << "info string qnodes " << stats.qnodes << " cutoffs "
+       << stats.beta_cutoffs << " firstmovecutoffs "
+       << stats.first_move_cutoffs << std::endl;
+  out_ << "info string evalcache hits " << stats.eval_cache_hits
+       << " misses " << stats.eval_cache_misses << " tbhits "
+       << stats.tb_hits << std::endl;
+  pending_bestmove_ = "bestmove " + result.best_move.AsUci();
+  if (!ponder) {
+    FlushPendingBestMove();
+  }
 }
 
 }  // namespace apollo
\ No newline at end of file
@@ -1,14 +1,25 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <random>
+#include <string>
 
+#include "book/polyglot.h"
 #include "evaluators/shannon_evaluator.h"
 #include "position.h"
 #include "search/searcher.h"
+#include "tablebase/bitbase.h"
 
 namespace apollo {
 
+/**
+ * The time, in milliseconds, kept in reserve on every move for the GUI and
+ * the connection to it.
+ */
+constexpr int kDefaultMoveOverheadMs = 10;
+
 class UciServer {
  public:
   UciServer(std::istream& in, std::ostream& out, std::ostream& log)
@@ -17,7 +28,19 @@ class UciServer {
         log_(log),
         position_lock_(),
         pos_(),
-        searcher_(std::make_unique<evaluators::ShannonEvaluator>()) {}
+        searcher_(std::make_unique<evaluators::ShannonEvaluator>()),
+        eval_file_(),
+        own_book_(false),
+        book_(),
+        book_rng_(std::random_device()()),
+        multi_pv_(1),
+        ponder_(false),
+        move_overhead_ms_(kDefaultMoveOverheadMs),
+        threads_(1),
+        pending_bestmove_() {
+    // The built-in bitbases are used until a SyzygyPath is set.
+    searcher_.SetTablebases(std::make_shared<tablebase::Bitbases>());
+  }
 
   void Run();
 
@@ -26,6 +49,13 @@ class UciServer {
   void HandleDebug();
   void HandlePosition(const std::string& line);
   void HandleGo(const std::string& line);
+  void HandleSetOption(const std::string& line);
+  void HandleNewGame();
+  void FlushPendingBestMove();
+  search::SearchLimits ParseGo(const std::string& line, bool& ponder) const;
+  void SetEvaluator(const std::string& name);
+  void SetBookFile(const std::string& path);
+  void SetSyzygyPath(const std::string& paths);
 
   std::istream& in_;
   std::ostream& out_;
@@ -34,6 +64,24 @@ class UciServer {
   std::mutex position_lock_;
   Position pos_;
   search::Searcher searcher_;
+  std::string eval_file_;
+
+  // The opening book, consulted before searching when OwnBook is on.
+  bool own_book_;
+  std::unique_ptr<book::PolyglotBook> book_;
+  std::mt19937_64 book_rng_;
+
+  // Options that shape every search. The search is single-threaded, so
+  // Threads is recorded but doesn't change anything yet. Unless Ponder is
+  // on, "go ponder" searches like a plain "go".
+  int multi_pv_;
+  bool ponder_;
+  int move_overhead_ms_;
+  int threads_;
+
+  // The bestmove of a "go ponder" search, which the protocol says is held
+  // back until the GUI sends ponderhit or stop.
+  std::string pending_bestmove_;
 };
 
 }  // namespace apollo
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <sstream>
+#include <string>
+#include "gtest/gtest.h"
+
+#include "uci.h"
+
+using apollo::UciServer;
+
+namespace {
+
+/**
+ * Runs a UCI session with the given commands, one per line, and returns
+ * everything the server wrote.
+ */
+std::string RunSession(const std::string& commands) {
+  std::istringstream in(commands);
+  std::ostringstream out;
+  std::ostringstream log;
+  UciServer server(in, out, log);
+  server.Run();
+  return out.str();
+}
+
+size_t Count(const std::string& haystack, const std::string& needle) {
+  size_t count = 0;
+  for (size_t pos = haystack.find(needle); pos != std::string::npos;
+       pos = haystack.find(needle, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+}  // anonymous namespace
+
+TEST(UciTest, AdvertisesOptions) {
+  std::string out = RunSession("uci\n");
+  for (const char* option :
+       {"option name Hash type spin", "option name Clear Hash type button",
+        "option name EvalCache type spin", "option name Threads type spin",
+        "option name MultiPV type spin", "option name Ponder type check",
+        "option name Move Overhead type spin",
+        "option name SyzygyPath type string", "uciok"}) {
+    ASSERT_NE(std::string::npos, out.find(option)) << option;
+  }
+}
+
+TEST(UciTest, SetsOptions) {
+  std::string out = RunSession(
+      "setoption name Hash value 2\n"
+      "setoption name EvalCache value 2\n"
+      "setoption name Clear Hash\n"
+      "setoption name Move Overhead value 50\n"
+      "setoption name Ponder value true\n"
+      "setoption name Threads value 4\n"
+      "setoption name SyzygyPath value /nonexistent\n"
+      "ucinewgame\n"
+      "isready\n");
+  ASSERT_NE(std::string::npos, out.find("ignoring Threads 4"));
+  ASSERT_NE(std::string::npos,
+            out.find("info string found 0 tablebase files, up to 0 pieces"));
+  ASSERT_NE(std::string::npos, out.find("readyok"));
+}
+
+TEST(UciTest, GoDepth) {
+  std::string out = RunSession("position startpos\ngo depth 2\n");
+  ASSERT_NE(std::string::npos, out.find("info depth 2 "));
+  ASSERT_EQ(std::string::npos, out.find("info depth 3 "));
+  ASSERT_EQ(1u, Count(out, "bestmove "));
+}
+
+TEST(UciTest, GoWithClock) {
+  std::string out = RunSession(
+      "setoption name Move Overhead value 100\n"
+      "position startpos moves e2e4\n"
+      "go wtime 1000 btime 1000 winc 0 binc 0\n");
+  ASSERT_EQ(1u, Count(out, "bestmove "));
+}
+
+TEST(UciTest, PonderHoldsBestMove) {
+  const std::string ponder =
+      "setoption name Ponder value true\nposition startpos\n"
+      "go ponder depth 1\n";
+  std::string out = RunSession(ponder);
+  ASSERT_EQ(0u, Count(out, "bestmove "));
+
+  out = RunSession(ponder + "ponderhit\n");
+  ASSERT_EQ(1u, Count(out, "bestmove "));
+
+  out = RunSession(ponder + "stop\nstop\n");
+  ASSERT_EQ(1u, Count(out, "bestmove "));
+}
+
+TEST(UciTest, GoPonderWithoutPonderOption) {
+  std::string out = RunSession("position startpos\ngo ponder depth 1\n");
+  ASSERT_EQ(1u, Count(out, "bestmove "));
+}
+
+TEST(UciTest, MultiPv) {
+  std::string out = RunSession(
+      "setoption name MultiPV value 3\n"
+      "position startpos\n"
+      "go depth 2\n");
+  ASSERT_NE(std::string::npos, out.find("info depth 2 seldepth 2 multipv 3 "));
+  ASSERT_EQ(std::string::npos, out.find("multipv 4"));
+  ASSERT_EQ(1u, Count(out, "bestmove "));
+}
@@ -74,13 +74,11 @@ class ZobristHasher {
 
   uint64_t Hash(const Position& pos) const {
     uint64_t running_hash = 0;
-    for (Square sq : kSquares) {
-      for (Color color : kColors) {
-        for (PieceKind piece : kPieces) {
-          if (pos.Pieces(color, piece).Test(sq)) {
-            running_hash ^= SquareHash(piece, color, sq);
-          }
-        }
+    for (Color color : kColors) {
+      for (PieceKind piece : kPieces) {
+        pos.Pieces(color, piece).ForEach([&](Square sq) {
+          running_hash ^= SquareHash(piece, color, sq);
+        });
       }
     }
 
@@ -94,7 +92,7 @@ class ZobristHasher {
     if (pos.CanCastleKingside(kBlack)) {
       running_hash ^= CastleHash(2);
     }
-    if (pos.CanCastleKingside(kBlack)) {
+    if (pos.CanCastleQueenside(kBlack)) {
       running_hash ^= CastleHash(3);
     }
     if (pos.EnPassantSquare()) {
@@ -117,6 +115,13 @@ void ModifyPiece(uint64_t& hash, Square square, Piece piece) {
   hash ^= kHasher.SquareHash(piece.kind(), piece.color(), square);
 }
 
+void ModifyPieces(uint64_t& hash, const Piece* pieces, const Square* squares,
+                  int count) {
+  for (int i = 0; i < count; i++) {
+    hash ^= kHasher.SquareHash(pieces[i].kind(), pieces[i].color(), squares[i]);
+  }
+}
+
 void ModifySideToMove(uint64_t& hash) {
   hash ^= kHasher.SideToMoveHash(kBlack);
 }
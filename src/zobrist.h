@@ -11,6 +11,8 @@ namespace apollo::zobrist {
 uint64_t Hash(const Position& pos);
 
 void ModifyPiece(uint64_t& hash, Square square, Piece piece);
+void ModifyPieces(uint64_t& hash, const Piece* pieces, const Square* squares,
+                  int count);
 void ModifySideToMove(uint64_t& hash);
 void ModifyKingsideCastle(uint64_t& hash, Color color);
 void ModifyQueensideCastle(uint64_t& hash, Color color);